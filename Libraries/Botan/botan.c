@@ -48,6 +48,7 @@ const char **botan_ciphers()
         CIPHER_AES_128_GCM,
         CIPHER_AES_128_OCB,
         CIPHER_AES_128_CCM,
+        CIPHER_AES_128_XTS,
     #endif
 #elif defined(AES_192)
     #if defined(ECB)
@@ -59,6 +60,7 @@ const char **botan_ciphers()
         CIPHER_AES_192_GCM,
         CIPHER_AES_192_OCB,
         CIPHER_AES_192_CCM,
+        CIPHER_AES_192_XTS,
     #endif
 #elif defined(AES_256)
     #if defined(ECB)
@@ -70,6 +72,7 @@ const char **botan_ciphers()
         CIPHER_AES_256_GCM,
         CIPHER_AES_256_OCB,
         CIPHER_AES_256_CCM,
+        CIPHER_AES_256_XTS,
     #endif
 #endif
         NULL
@@ -98,6 +101,64 @@ bool botan_random(void *param, const size_t size, void *data)
 	return true;
 }
 
+/**
+ * Get a list of random number generators supported by botan_rng_init().
+ * @return An array of generator names as strings, with a NULL-terminated
+ * sentinel.
+ */
+const char **botan_rngs()
+{
+	static const char *rngs[] = {"system", "user", "user-threadsafe", NULL};
+	return rngs;
+}
+
+/**
+ * Set the random number generator used by botan_rng_bytes().
+ * @param param A pointer to the cryptographic context.
+ * @param rng The name of the generator for botan_rng_init().
+ * @param shared Whether the generator is called from several threads. The
+ * "user" generator is not thread safe and cannot be shared.
+ * @return True if the generator is successfully set, otherwise false.
+ */
+bool botan_set_rng(void *param, const char *rng, bool shared)
+{
+	if (!param || !rng)
+	{
+		return false;
+	}
+
+	BotanParam *op = param;
+
+	botan_rng_destroy(op->rng);
+	op->rng = NULL;
+
+	if (shared && strcmp(rng, "user") == 0)
+	{
+		return false;
+	}
+
+	int error = botan_rng_init(&op->rng, rng);
+	if (error)
+	{
+		printf("Error: botan_set_rng(): botan_rng_init(\"%s\") has failed with error %d!\n", rng, error);
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Generate random data with the generator chosen by botan_set_rng().
+ * @param param A pointer to the cryptographic context.
+ * @param size The size of random data to generate.
+ * @param dst A pointer to the destination buffer for the random data.
+ * @return True if random data is generated successfully, otherwise false.
+ */
+bool botan_rng_bytes(void *param, const size_t size, void *dst)
+{
+	return !botan_rng_get(((BotanParam *)param)->rng, dst, size);
+}
+
 /**
  * Free resources associated with BotanParam.
  * @param param A pointer to the context to be freed.
@@ -114,10 +175,17 @@ bool botan_free(void *param)
 
 	#if defined(ECB)
 		op->error = botan_block_cipher_destroy(op->bc);
-	else
+	#else
 		op->error = botan_cipher_destroy(op->cipher);
 	#endif
 
+	botan_hash_destroy(op->hash);
+	botan_mac_destroy(op->mac);
+	botan_pk_free(op->pk);
+	botan_rng_destroy(op->rng);
+	free(op->carry);
+	free(op->message);
+
 	free(op);
 
 	return true;
@@ -135,20 +203,15 @@ bool botan_init(void **param)
 		return false;
 	}
 
-	BotanParam *op = malloc(sizeof(BotanParam));
-	*param = op;
-
-	op->error = false;
-	op->output_written = 0;
-	op->input_consumed = 0;
-
+	BotanParam *op = calloc(1, sizeof(BotanParam));
 	if (!op)
 	{
 		printf("Error : botan_init() : BotanParam Initialization has failed !\n");
-		return !op->error;
+		return false;
 	}
 
-	return !op->error;
+	*param = op;
+	return true;
 }
 
 /**
@@ -172,29 +235,491 @@ bool botan_set_cipher(void *param, const char *cipher)
 		handle_botan_cipher(&op->error, param, cipher);
 	#endif
 
+	for (size_t i = 0; i < REKEY_KEYS && !op->error; ++i)
+	{
+		op->error = !botan_random(param, op->key_size, op->rekey_keys[i]);
+	}
+	op->next_key = 0;
+
 	return !op->error;
 }
 
+#if !defined(ECB)
+/**
+ * Start a message with the IV of the context, AEAD ciphers get the associated
+ * data first.
+ * @param op The Botan context with the cipher already set.
+ * @return True on success, otherwise false.
+ */
+static bool botan_start_message(BotanParam *op)
+{
+	return !(op->aead && botan_cipher_set_associated_data(op->cipher, (const uint8_t *)"ADADADADADADADAD", 16)) &&
+		   !botan_cipher_start(op->cipher, op->iv, op->iv_size);
+}
+
+/**
+ * Grow the buffer of whole-message modes to a message of `size` bytes and its
+ * tag.
+ * @param op The Botan context.
+ * @param size The size of the message.
+ * @return True on success, otherwise false.
+ */
+static bool botan_reserve_message(BotanParam *op, const size_t size)
+{
+	const size_t capacity = size + 2 * MAX_DIGEST_SIZE;
+
+	if (capacity > op->message_capacity)
+	{
+		uint8_t *message = realloc(op->message, capacity);
+		if (!message)
+		{
+			return false;
+		}
+		op->message = message;
+		op->message_capacity = capacity;
+	}
+
+	return true;
+}
+
+/**
+ * Encrypt a message of a mode that only encrypts the final update, like CCM,
+ * as a whole with the IV of the context. Only the ciphertext is copied to dst,
+ * the tag stays behind it in the buffer of the context. The next message is
+ * started again.
+ * @param op The Botan context with the cipher already set.
+ * @param src A pointer to the source data to be encrypted.
+ * @param size The size of the source data.
+ * @param dst A pointer to the destination buffer for the encrypted data.
+ * @return The size of the encrypted data, zero on error.
+ */
+static size_t botan_encrypt_whole(BotanParam *op, const uint8_t *src, const size_t size, uint8_t *dst)
+{
+	size_t written = 0, consumed = 0;
+
+	if (!botan_reserve_message(op, size) ||
+		botan_cipher_update(op->cipher, BOTAN_CIPHER_UPDATE_FLAG_FINAL, op->message, op->message_capacity, &written,
+							src, size, &consumed) ||
+		consumed != size || written < size || !botan_start_message(op))
+	{
+		return 0;
+	}
+
+	memcpy(dst, op->message, size);
+	return size;
+}
+
+/**
+ * Pass a multiple of the update granularity to botan_cipher_update().
+ */
+static bool botan_stream_process(BotanParam *op, const uint8_t *src, size_t size, uint8_t *dst, size_t *written)
+{
+	while (size > 0)
+	{
+		size_t out = 0, consumed = 0;
+		if (botan_cipher_update(op->cipher, 0, dst, size, &out, src, size, &consumed) || consumed == 0)
+		{
+			return false;
+		}
+		src += consumed;
+		size -= consumed;
+		dst += out;
+		*written += out;
+	}
+
+	return true;
+}
+#endif
+
+/**
+ * Encrypt data without argument checks. Shared by botan_encrypt() and
+ * botan_encrypt_loop().
+ * @param param A pointer to the cryptographic context.
+ * @param size The size of the source data, all of it is encrypted.
+ * @param dst A pointer to the destination buffer for the encrypted data.
+ * @param src A pointer to the source data to be encrypted.
+ * @return The size of the encrypted data, zero on error.
+ */
+static inline size_t botan_encrypt_kernel(void *param, const size_t size, void *dst, const void *src)
+{
+	BotanParam *op = param;
+
+	#if defined(ECB)
+		return botan_block_cipher_encrypt_blocks(op->bc, (const uint8_t *)src, (uint8_t *)dst, (size / 16)) ? 0 : size;
+	#else
+		if (op->whole_message)
+		{
+			return botan_encrypt_whole(op, src, size, dst);
+		}
+
+		size_t written = 0;
+		return botan_stream_process(op, src, size, dst, &written) ? written : 0;
+	#endif
+}
+
 /**
  * Encrypt data.
  * @param param A pointer to the cryptographic context.
  * @param size The size of the source data.
  * @param dst A pointer to the destination buffer for the encrypted data.
  * @param src A pointer to the source data to be encrypted.
- * @return zero on success or an error code.
+ * @return The size of the encrypted data, zero on error.
  */
 size_t botan_encrypt(void *param, const size_t size, void *dst, const void *src)
 {
+	return botan_encrypt_kernel(param, size, dst, src);
+}
+
+CBOS_DEFINE_ENCRYPT_LOOP(botan_loop, botan_encrypt_kernel, MESSAGE_SIZE)
+
+/**
+ * Encrypt data repeatedly with the kernel inlined into the loop.
+ * @param param A pointer to the cryptographic context.
+ * @param size The size of the source data, must be MESSAGE_SIZE.
+ * @param dst A pointer to the destination buffer for the encrypted data.
+ * @param src A pointer to the source data to be encrypted.
+ * @param iterations The number of encryptions.
+ * @return The number of completed encryptions.
+ */
+size_t botan_encrypt_loop(void *param, const size_t size, void *dst, const void *src, const size_t iterations)
+{
+	if (!param || !dst || !src)
+	{
+		return 0;
+	}
+
+	return botan_loop(param, size, dst, src, iterations);
+}
+
+/**
+ * Restart the message of the current cipher with its key, IV and associated
+ * data for botan_stream_update().
+ * @param param A pointer to the cryptographic context.
+ * @return True on success, otherwise false. ECB has no message to stream and
+ * CCM buffers the whole message until the final update, like OpenSSL has to
+ * know its length in advance.
+ */
+bool botan_stream_start(void *param)
+{
+#if defined(ECB)
+	return false;
+#else
 	BotanParam *op = param;
+	size_t granularity = 0;
 
-	#if defined(ECB)
-		return !botan_block_cipher_encrypt_blocks(op->bc, (const uint8_t *)src, (uint8_t *)dst, (MESSAGE_SIZE / 16));
-	#else			    
-		return !botan_cipher_update(op->cipher, 0, dst, MESSAGE_SIZE, &op->output_written, src, MESSAGE_SIZE,
-									  &op->input_consumed);
+	if (op->whole_message || botan_cipher_reset(op->cipher) || botan_cipher_get_update_granularity(op->cipher, &granularity) ||
+		granularity == 0)
+	{
+		return false;
+	}
+
+	if (granularity > op->carry_capacity)
+	{
+		uint8_t *carry = realloc(op->carry, granularity);
+		if (!carry)
+		{
+			return false;
+		}
+		op->carry = carry;
+		op->carry_capacity = granularity;
+	}
+
+	op->granularity = granularity;
+	op->carry_size = 0;
+
+	// Resetting the cipher also drops the associated data
+	return botan_start_message(op);
 #endif
 }
 
+/**
+ * Encrypt the next part of the streamed message. botan_cipher_update() only
+ * consumes multiples of the update granularity, so the rest of every update is
+ * carried over and completed by the next one.
+ * @param param A pointer to the cryptographic context.
+ * @param size The size of the source data.
+ * @param dst A pointer to the destination buffer, at least size +
+ * granularity bytes.
+ * @param src A pointer to the source data to be encrypted.
+ * @param written Output for the number of bytes written to dst.
+ * @return True on success, otherwise false.
+ */
+bool botan_stream_update(void *param, const size_t size, void *dst, const void *src, size_t *written)
+{
+#if defined(ECB)
+	return false;
+#else
+	BotanParam *op = param;
+	const uint8_t *in = src;
+	uint8_t *out = dst;
+	size_t remaining = size;
+
+	*written = 0;
+
+	if (op->carry_size > 0)
+	{
+		const size_t take = op->granularity - op->carry_size < remaining ? op->granularity - op->carry_size : remaining;
+		memcpy(op->carry + op->carry_size, in, take);
+		op->carry_size += take;
+		in += take;
+		remaining -= take;
+
+		if (op->carry_size < op->granularity)
+		{
+			return true;
+		}
+
+		if (!botan_stream_process(op, op->carry, op->granularity, out, written))
+		{
+			return false;
+		}
+		op->carry_size = 0;
+	}
+
+	const size_t full = remaining - remaining % op->granularity;
+	if (!botan_stream_process(op, in, full, out + *written, written))
+	{
+		return false;
+	}
+
+	op->carry_size = remaining - full;
+	memcpy(op->carry, in + full, op->carry_size);
+	return true;
+#endif
+}
+
+/**
+ * Finish the streamed message with the carried-over input.
+ * @param param A pointer to the cryptographic context.
+ * @param dst A pointer to the destination buffer for the rest of the
+ * ciphertext, the padding and the tag.
+ * @param written Output for the number of bytes written to dst.
+ * @return True on success, otherwise false.
+ */
+bool botan_stream_finish(void *param, void *dst, size_t *written)
+{
+#if defined(ECB)
+	return false;
+#else
+	BotanParam *op = param;
+	size_t consumed = 0;
+
+	return !botan_cipher_update(op->cipher, BOTAN_CIPHER_UPDATE_FLAG_FINAL, dst, op->carry_size + 2 * MAX_DIGEST_SIZE,
+								written, op->carry, op->carry_size, &consumed);
+#endif
+}
+
+/**
+ * Replace the key of the current cipher with the next one drawn in
+ * botan_set_cipher() through the Botan key schedule. A new key ends the
+ * message, so it is started again with the IV and associated data of
+ * botan_set_cipher().
+ * @param param A pointer to the cryptographic context.
+ * @return True on success, otherwise false.
+ */
+bool botan_rekey(void *param)
+{
+	if (!param)
+	{
+		return false;
+	}
+
+	BotanParam *op = param;
+
+	memcpy(op->key, op->rekey_keys[op->next_key], op->key_size);
+	op->next_key = (op->next_key + 1) % REKEY_KEYS;
+
+#if defined(ECB)
+	return !botan_block_cipher_set_key(op->bc, op->key, op->key_size);
+#else
+	return !botan_cipher_set_key(op->cipher, op->key, op->key_size) && botan_start_message(op);
+#endif
+}
+
+/**
+ * Encrypt one XTS data unit: the message is started with the tweak of the
+ * sector and finished in one call.
+ * @param param A pointer to the cryptographic context.
+ * @param sector Number of the sector, the tweak is its little-endian encoding.
+ * @param size The size of the sector.
+ * @param dst A pointer to the destination buffer for the encrypted data.
+ * @param src A pointer to the source data to be encrypted.
+ * @return The size of the encrypted data or zero on error.
+ */
+size_t botan_encrypt_sector(void *param, const uint64_t sector, const size_t size, void *dst, const void *src)
+{
+#if defined(ECB)
+	return 0;
+#else
+	BotanParam *op = param;
+	uint8_t tweak[IV_SIZE] = {0};
+	size_t written = 0, consumed = 0;
+
+	if (!op || !op->cipher || !dst || !src)
+	{
+		return 0;
+	}
+
+	for (int i = 0; i < 8; ++i)
+	{
+		tweak[i] = (uint8_t)(sector >> (8 * i));
+	}
+
+	if (botan_cipher_start(op->cipher, tweak, sizeof(tweak)) ||
+		botan_cipher_update(op->cipher, BOTAN_CIPHER_UPDATE_FLAG_FINAL, dst, size, &written, src, size, &consumed))
+	{
+		return 0;
+	}
+
+	return written;
+#endif
+}
+
+/**
+ * Replace the key and IV of the current cipher, e.g. with those of a test
+ * vector, and start a new message with them and the associated data of
+ * botan_set_cipher().
+ * @param param A pointer to the cryptographic context.
+ * @param key The new key.
+ * @param key_size The size of the key, must be the key length of the cipher.
+ * @param iv The new IV.
+ * @param iv_size The size of the IV, must be the IV length of the cipher.
+ * @return True on success, otherwise false.
+ */
+bool botan_set_key(void *param, const uint8_t *key, const size_t key_size, const uint8_t *iv, const size_t iv_size)
+{
+	BotanParam *op = param;
+
+	if (!op || !key || (iv_size && !iv))
+	{
+		return false;
+	}
+
+#if defined(ECB)
+	const size_t expected_iv = 0;
+#else
+	const size_t expected_iv = op->iv_size;
+#endif
+
+	if (key_size != op->key_size || iv_size != expected_iv)
+	{
+		printf("Error: botan_set_key(): the cipher takes a %zu bytes key and %zu bytes IV, not %zu and %zu!\n",
+			   op->key_size, expected_iv, key_size, iv_size);
+		return false;
+	}
+
+	memcpy(op->key, key, key_size);
+
+#if defined(ECB)
+	return !botan_block_cipher_set_key(op->bc, op->key, op->key_size);
+#else
+	memcpy(op->iv, iv, iv_size);
+
+	return !botan_cipher_set_key(op->cipher, op->key, op->key_size) && botan_start_message(op);
+#endif
+}
+
+/**
+ * Get a list of hash and MAC functions supported by the Botan library.
+ * @return An array of names as strings, with a NULL-terminated sentinel.
+ */
+const char **botan_digests()
+{
+	static const char *names[] = {
+		"SHA-256",
+		"SHA-512",
+		"SHA-3(256)",
+		"SHA-3(512)",
+		"BLAKE2b(512)",
+		"BLAKE2s(256)",
+		"HMAC(SHA-256)",
+		"HMAC(SHA-512)",
+		"Poly1305",
+		NULL
+	};
+
+	return names;
+}
+
+/**
+ * Set the hash or MAC function and its key.
+ * @param param A pointer to the cryptographic context.
+ * @param digest The name of the hash or MAC function.
+ * @return True if the function is successfully set, otherwise false.
+ */
+bool botan_set_digest(void *param, const char *digest)
+{
+	if (!param || !digest)
+	{
+		return false;
+	}
+
+	BotanParam *op = param;
+
+	botan_hash_destroy(op->hash);
+	botan_mac_destroy(op->mac);
+	op->hash = NULL;
+	op->mac = NULL;
+
+	// Names that are not hash functions are MACs
+	if (botan_hash_init(&op->hash, digest, 0) == 0)
+	{
+		return true;
+	}
+	op->hash = NULL;
+
+	if (botan_mac_init(&op->mac, digest, 0))
+	{
+		op->mac = NULL;
+		printf("Error: botan_set_digest(): \"%s\" is neither a hash nor a MAC function!\n", digest);
+		return false;
+	}
+
+	// Poly1305 keys are one-time keys, Botan clears them after every tag
+	op->rekey_mac = strcmp(digest, "Poly1305") == 0;
+
+	if (!botan_random(param, MAX_MAC_KEY_SIZE, op->mac_key) ||
+		botan_mac_set_key(op->mac, op->mac_key, MAX_MAC_KEY_SIZE))
+	{
+		printf("Error setting key for %s!\n", digest);
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Hash or authenticate data.
+ * @param param A pointer to the cryptographic context.
+ * @param size The size of the source data.
+ * @param dst A pointer to the destination buffer for the digest or tag.
+ * @param src A pointer to the source data.
+ * @return The size of the digest or tag, zero on error.
+ */
+size_t botan_digest(void *param, const size_t size, void *dst, const void *src)
+{
+	BotanParam *op = param;
+	size_t out = 0;
+
+	if (op->hash)
+	{
+		if (botan_hash_update(op->hash, src, size) || botan_hash_final(op->hash, dst) ||
+			botan_hash_output_length(op->hash, &out))
+		{
+			return 0;
+		}
+		return out;
+	}
+
+	if ((op->rekey_mac && botan_mac_set_key(op->mac, op->mac_key, MAX_MAC_KEY_SIZE)) ||
+		botan_mac_update(op->mac, src, size) || botan_mac_final(op->mac, dst) ||
+		botan_mac_output_length(op->mac, &out))
+	{
+		return 0;
+	}
+	return out;
+}
+
 /**
  * Prepare Botan to be called by main by defining pointers to functions
  * containing the implementation.
@@ -202,7 +727,7 @@ size_t botan_encrypt(void *param, const size_t size, void *dst, const void *src)
  * @return a pointer to a struct containing function pointers that implement
  * Botan.
  */
-const Crypto *get_lib()
+const Crypto *botan_get()
 {
 	static const Crypto crypto = {
 		botan_name,
@@ -212,11 +737,29 @@ const Crypto *get_lib()
 		botan_random,
 		botan_set_cipher,
 		botan_encrypt,
+		botan_encrypt_loop,
+		botan_digests,
+		botan_set_digest,
+		botan_digest,
+		botan_pk_operations,
+		botan_set_pk_operation,
+		botan_pk_run,
+		botan_rngs,
+		botan_set_rng,
+		botan_rng_bytes,
+		botan_stream_start,
+		botan_stream_update,
+		botan_stream_finish,
+		botan_rekey,
+		botan_encrypt_sector,
+		botan_set_key,
 	};
 
 	return &crypto;
 }
 
+CBOS_REGISTER_LIB(botan_get)
+
 #if defined(ECB)
 /**
  * Initialize the block cipher.
@@ -241,14 +784,14 @@ void handle_botan_block_cipher(bool *error, void *param, const char *cipher)
 		return;
 	}
 
-	*error = botan_block_cipher_set_key(op->bc, op->key, KEY_SIZE);
+	op->key_size = KEY_SIZE;
+	*error = botan_block_cipher_set_key(op->bc, op->key, op->key_size);
 	if (*error)
 	{
 		printf("Error setting key for %s\n!", cipher);
 	};
 }
-#endif
-
+#else
 /**
  * Initialize the cipher.
  * @param error A pointer to a boolean that will be set to true if an error
@@ -264,6 +807,16 @@ void handle_botan_cipher(bool *error, void *param, const char *cipher)
 {
 	BotanParam *op = param;
 
+	botan_cipher_destroy(op->cipher);
+	op->cipher = NULL;
+
+	*error = botan_cipher_init(&op->cipher, cipher, BOTAN_CIPHER_INIT_FLAG_ENCRYPT);
+	if (*error)
+	{
+		printf("Error: botan_cipher_init(): Cipher Initialization has failed!\n");
+		return;
+	}
+
 	/*
 	The implementation of botan_cipher_is_authenticated() is missing.
 	The following code is a workaround to check if the current cipher is
@@ -274,21 +827,34 @@ void handle_botan_cipher(bool *error, void *param, const char *cipher)
 
 	// which IV size do I need?
 	size_t iv_size = is_authenticated ? AEAD_IV_SIZE : IV_SIZE;
+	op->aead = is_authenticated > 0;
+	op->iv_size = iv_size;
+	op->whole_message = botan_cipher_requires_entire_message(op->cipher) == 1;
 
-	*error = botan_cipher_init(&op->cipher, cipher, BOTAN_CIPHER_INIT_FLAG_ENCRYPT);
+	*error = op->whole_message && !botan_reserve_message(op, MESSAGE_SIZE);
 	if (*error)
 	{
-		printf("Error: botan_cipher_init(): Cipher Initialization has failed!\n");
+		printf("Error: botan_reserve_message(): out of memory for %s!\n", cipher);
 		return;
 	}
 
-	if (!botan_random(param, KEY_SIZE, op->key) || !botan_random(param, iv_size, op->iv))
+	// XTS takes two AES keys
+	size_t min_key = 0, max_key = 0, key_modulo = 0;
+	*error = botan_cipher_get_keyspec(op->cipher, &min_key, &max_key, &key_modulo) || max_key > sizeof(op->key);
+	if (*error)
+	{
+		printf("Error: botan_cipher_get_keyspec(): %s has no usable key size!\n", cipher);
+		return;
+	}
+	op->key_size = max_key;
+
+	if (!botan_random(param, op->key_size, op->key) || !botan_random(param, iv_size, op->iv))
 	{
 		printf("Error: botan_random() has failed!\n");
 		return;
 	}
 
-	*error = botan_cipher_set_key(op->cipher, op->key, KEY_SIZE);
+	*error = botan_cipher_set_key(op->cipher, op->key, op->key_size);
 	if (*error)
 	{
 		printf("Error setting key for %s!\n", cipher);
@@ -313,4 +879,5 @@ void handle_botan_cipher(bool *error, void *param, const char *cipher)
 		printf("Error: botan_cipher_start(): starting cipher has failed for %s!\n", cipher);
 		return;
 	}
-}
\ No newline at end of file
+}
+#endif
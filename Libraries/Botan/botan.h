@@ -22,6 +22,7 @@
         #define CIPHER_AES_128_GCM "AES-128/GCM"
         #define CIPHER_AES_128_OCB "AES-128/OCB"
         #define CIPHER_AES_128_CCM "AES-128/CCM"
+        #define CIPHER_AES_128_XTS "AES-128/XTS"
     #endif
 #elif defined(AES_192)
     #if defined(ECB)
@@ -33,6 +34,7 @@
         #define CIPHER_AES_192_GCM "AES-192/GCM"
         #define CIPHER_AES_192_OCB "AES-192/OCB"
         #define CIPHER_AES_192_CCM "AES-192/CCM"
+        #define CIPHER_AES_192_XTS "AES-192/XTS"
     #endif
 #elif defined(AES_256)
     #if defined(ECB)
@@ -44,6 +46,7 @@
         #define CIPHER_AES_256_GCM "AES-256/GCM"
         #define CIPHER_AES_256_OCB "AES-256/OCB"
         #define CIPHER_AES_256_CCM "AES-256/CCM"
+        #define CIPHER_AES_256_XTS "AES-256/XTS"
     #endif
 #endif
 
@@ -51,13 +54,19 @@
     #define MESSAGE_SIZE 4096
 #endif
 
+#define MAX_MAC_KEY_SIZE 32
+
 #ifndef ITERATIONS
     #define ITERATIONS 100
 #endif
 
 #include "../../src/cbos.h"
+#include "../../src/direct.h"
 #include "botan/ffi.h"
 
+/* keys and inputs of public-key operations, see botan_pk.c */
+typedef struct BotanPK BotanPK;
+
 typedef struct BotanParam
 {
     #if defined(ECB)
@@ -66,12 +75,46 @@ typedef struct BotanParam
         botan_cipher_t cipher;
     #endif
         bool error;
-        unsigned char key[KEY_SIZE];
+        unsigned char key[2 * KEY_SIZE]; // XTS takes two AES keys
+        size_t key_size;
+        unsigned char rekey_keys[REKEY_KEYS][2 * KEY_SIZE]; // Drawn in botan_set_cipher() for botan_rekey()
+        size_t next_key;
         unsigned char iv[IV_SIZE];
-        size_t output_written;
-        size_t input_consumed;
+        botan_hash_t hash;
+        botan_mac_t mac;
+        bool rekey_mac;
+        unsigned char mac_key[MAX_MAC_KEY_SIZE];
+        BotanPK *pk;
+        botan_rng_t rng;
+        bool aead;
+        bool whole_message;     // The mode only encrypts the final update, e.g. CCM
+        size_t iv_size;
+        size_t granularity;     // Update granularity of the streamed message
+        uint8_t *carry;         // Input not yet consumed by botan_cipher_update()
+        size_t carry_size;
+        size_t carry_capacity;
+        uint8_t *message;       // Ciphertext and tag of a whole-message mode
+        size_t message_capacity;
 } BotanParam;
 
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* cipher list shared by the FFI and the native C++ backend */
+const char **botan_ciphers();
+
+/* public-key operations implemented in botan_pk.c */
+const char **botan_pk_operations();
+bool botan_set_pk_operation(void *param, const char *operation);
+bool botan_pk_run(void *param);
+void botan_pk_free(BotanPK *pk);
+
 /* helper functions that are used by botan_set_cipher() */
 void handle_botan_block_cipher(bool *error, void *param, const char *cipher);
-void handle_botan_cipher(bool *error, void *param, const char *cipher);
\ No newline at end of file
+void handle_botan_cipher(bool *error, void *param, const char *cipher);
+
+#ifdef __cplusplus
+}
+#endif
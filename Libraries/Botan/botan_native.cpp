@@ -0,0 +1,551 @@
+#include "botan_native.h"
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <new>
+
+/*
+ * Native C++ Botan backend. It benchmarks the same ciphers as the FFI backend
+ * in botan.c through Botan::Cipher_Mode and Botan::BlockCipher directly, so the
+ * difference between both results is the cost of the FFI wrapper.
+ */
+
+/**
+ * @return "Botan (Version number) native" as a char pointer.
+ */
+const char *botan_native_name()
+{
+	static char name[32];
+
+	if (!name[0])
+	{
+		snprintf(name, sizeof(name), "Botan %s native", Botan::short_version_cstr());
+	}
+
+	return name;
+}
+
+/**
+ * BotanNativeParam Initialization
+ * @param param A pointer to a void pointer where BotanNativeParam will be stored.
+ * @return True if initialization is successful, otherwise false.
+ */
+bool botan_native_init(void **param)
+{
+	if (!param)
+	{
+		return false;
+	}
+
+	BotanNativeParam *op = new (std::nothrow) BotanNativeParam();
+	if (!op)
+	{
+		printf("Error : botan_native_init() : BotanNativeParam Initialization has failed !\n");
+		return false;
+	}
+
+	*param = op;
+	return true;
+}
+
+/**
+ * Free resources associated with BotanNativeParam.
+ * @param param A pointer to the context to be freed.
+ * @return True if resources are successfully freed, otherwise false.
+ */
+bool botan_native_free(void *param)
+{
+	if (!param)
+	{
+		return false;
+	}
+
+	delete static_cast<BotanNativeParam *>(param);
+
+	return true;
+}
+
+/**
+ * Generate random data.
+ * @param param A pointer to the cryptographic context.
+ * @param size The size of random data to generate.
+ * @param data A pointer to the destination buffer for the random data.
+ * @return True if random data is generated successfully, otherwise false.
+ */
+bool botan_native_random(void *param, const size_t size, void *data)
+{
+	if (!param || !data)
+	{
+		return false;
+	}
+
+	random_bytes(static_cast<uint8_t *>(data), size);
+	return true;
+}
+
+#if !defined(ECB)
+/**
+ * Start a new message with the IV and, for AEAD modes, the associated data,
+ * which Botan drops at the end of every message.
+ * @param op The context with the key already set.
+ */
+static void botan_native_start_message(BotanNativeParam *op)
+{
+	if (Botan::AEAD_Mode *aead = dynamic_cast<Botan::AEAD_Mode *>(op->cipher.get()))
+	{
+		aead->set_associated_data(reinterpret_cast<const uint8_t *>("ADADADADADADADAD"), 16);
+	}
+
+	op->cipher->start(op->iv.data(), op->iv.size());
+}
+#endif
+
+/**
+ * Set the cipher and keys to be used for cryptographic operations. Keys, IV
+ * and the working buffer are allocated here, outside of the timed loops.
+ * @param param A pointer to the cryptographic context.
+ * @param cipher The name of the cipher as a null-terminated string.
+ * @return True if the cipher is successfully set, otherwise false.
+ */
+bool botan_native_set_cipher(void *param, const char *cipher)
+{
+	if (!param || !cipher)
+	{
+		return false;
+	}
+
+	BotanNativeParam *op = static_cast<BotanNativeParam *>(param);
+
+	try
+	{
+#if defined(ECB)
+		op->bc = Botan::BlockCipher::create_or_throw(cipher);
+		op->key.resize(KEY_SIZE);
+		random_bytes(op->key.data(), op->key.size());
+		op->bc->set_key(op->key.data(), op->key.size());
+#else
+		op->cipher = Botan::Cipher_Mode::create_or_throw(cipher, Botan::Cipher_Dir::Encryption);
+
+		Botan::AEAD_Mode *aead = dynamic_cast<Botan::AEAD_Mode *>(op->cipher.get());
+
+		// XTS takes two AES keys
+		op->key.resize(op->cipher->key_spec().maximum_keylength());
+		random_bytes(op->key.data(), op->key.size());
+
+		op->iv.resize(aead ? AEAD_IV_SIZE : IV_SIZE);
+		random_bytes(op->iv.data(), op->iv.size());
+
+		op->cipher->set_key(op->key.data(), op->key.size());
+		op->whole_message = op->cipher->requires_entire_message();
+		botan_native_start_message(op);
+
+		// Room for whole-message modes and their tag, other modes encrypt in dst
+		op->buffer.reserve(op->whole_message ? MESSAGE_SIZE + op->cipher->tag_size() : 2 * IV_SIZE);
+#endif
+
+		op->rekey_keys.resize(REKEY_KEYS * op->key.size());
+		random_bytes(op->rekey_keys.data(), op->rekey_keys.size());
+		op->next_key = 0;
+	}
+	catch (const std::exception &e)
+	{
+		printf("Error: botan_native_set_cipher(): %s failed: %s\n", cipher, e.what());
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Encrypt data without argument checks. The message is copied to dst once and
+ * processed there in place, like the FFI backend streams it through
+ * botan_cipher_update(). Modes that only encrypt in finish(), like CCM, encrypt
+ * every call as one message with the IV of the context in the pre-allocated
+ * buffer; only its ciphertext is copied to dst, not the tag.
+ * @param param A pointer to the cryptographic context.
+ * @param size The size of the source data.
+ * @param dst A pointer to the destination buffer for the encrypted data.
+ * @param src A pointer to the source data to be encrypted.
+ * @return non-zero on success, zero on error.
+ */
+static inline size_t botan_native_encrypt_kernel(void *param, const size_t size, void *dst, const void *src)
+{
+	BotanNativeParam *op = static_cast<BotanNativeParam *>(param);
+
+	try
+	{
+#if defined(ECB)
+		op->bc->encrypt_n(static_cast<const uint8_t *>(src), static_cast<uint8_t *>(dst), size / 16);
+#else
+		if (op->whole_message)
+		{
+			// Only a message larger than every one before grows the buffer
+			const uint8_t *input = static_cast<const uint8_t *>(src);
+			op->buffer.assign(input, input + size);
+			op->cipher->finish(op->buffer);
+			botan_native_start_message(op);
+			std::memcpy(dst, op->buffer.data(), size);
+		}
+		else
+		{
+			std::memcpy(dst, src, size);
+			if (op->cipher->process(static_cast<uint8_t *>(dst), size) != size)
+			{
+				return 0;
+			}
+		}
+#endif
+	}
+	catch (const std::exception &e)
+	{
+		printf("Error: botan_native_encrypt(): %s\n", e.what());
+		return 0;
+	}
+
+	return size;
+}
+
+/**
+ * Encrypt data.
+ * @param param A pointer to the cryptographic context.
+ * @param size The size of the source data.
+ * @param dst A pointer to the destination buffer for the encrypted data.
+ * @param src A pointer to the source data to be encrypted.
+ * @return non-zero on success, zero on error.
+ */
+size_t botan_native_encrypt(void *param, const size_t size, void *dst, const void *src)
+{
+	return botan_native_encrypt_kernel(param, size, dst, src);
+}
+
+CBOS_DEFINE_ENCRYPT_LOOP(botan_native_loop, botan_native_encrypt_kernel, MESSAGE_SIZE)
+
+/**
+ * Encrypt data repeatedly with the kernel inlined into the loop.
+ * @param param A pointer to the cryptographic context.
+ * @param size The size of the source data, must be MESSAGE_SIZE.
+ * @param dst A pointer to the destination buffer for the encrypted data.
+ * @param src A pointer to the source data to be encrypted.
+ * @param iterations The number of encryptions.
+ * @return The number of completed encryptions.
+ */
+size_t botan_native_encrypt_loop(void *param, const size_t size, void *dst, const void *src, const size_t iterations)
+{
+	if (!param || !dst || !src)
+	{
+		return 0;
+	}
+
+	return botan_native_loop(param, size, dst, src, iterations);
+}
+
+/**
+ * Restart the message of the current cipher with its key, IV and associated
+ * data for botan_native_stream_update().
+ * @param param A pointer to the cryptographic context.
+ * @return True on success, otherwise false. ECB has no message to stream and
+ * CCM only encrypts in finish().
+ */
+bool botan_native_stream_start(void *param)
+{
+#if defined(ECB)
+	return false;
+#else
+	BotanNativeParam *op = static_cast<BotanNativeParam *>(param);
+
+	if (op->whole_message)
+	{
+		return false;
+	}
+
+	try
+	{
+		op->cipher->reset();
+		botan_native_start_message(op);
+		op->granularity = op->cipher->update_granularity();
+		op->carry.clear();
+		op->carry.reserve(op->granularity + 2 * MAX_DIGEST_SIZE);
+	}
+	catch (const std::exception &e)
+	{
+		printf("Error: botan_native_stream_start(): %s\n", e.what());
+		return false;
+	}
+
+	return true;
+#endif
+}
+
+/**
+ * Encrypt the next part of the streamed message. Cipher_Mode::process() only
+ * accepts multiples of the update granularity, so the rest of every update is
+ * carried over and completed by the next one.
+ * @param param A pointer to the cryptographic context.
+ * @param size The size of the source data.
+ * @param dst A pointer to the destination buffer, at least size +
+ * granularity bytes.
+ * @param src A pointer to the source data to be encrypted.
+ * @param written Output for the number of bytes written to dst.
+ * @return True on success, otherwise false.
+ */
+bool botan_native_stream_update(void *param, const size_t size, void *dst, const void *src, size_t *written)
+{
+#if defined(ECB)
+	return false;
+#else
+	BotanNativeParam *op = static_cast<BotanNativeParam *>(param);
+	const uint8_t *in = static_cast<const uint8_t *>(src);
+	uint8_t *out = static_cast<uint8_t *>(dst);
+	size_t remaining = size;
+
+	*written = 0;
+
+	try
+	{
+		if (!op->carry.empty())
+		{
+			const size_t take = std::min(op->granularity - op->carry.size(), remaining);
+			op->carry.insert(op->carry.end(), in, in + take);
+			in += take;
+			remaining -= take;
+
+			if (op->carry.size() < op->granularity)
+			{
+				return true;
+			}
+
+			op->cipher->process(op->carry.data(), op->carry.size());
+			std::memcpy(out, op->carry.data(), op->carry.size());
+			*written += op->carry.size();
+			op->carry.clear();
+		}
+
+		const size_t full = remaining - remaining % op->granularity;
+		if (full > 0)
+		{
+			std::memcpy(out + *written, in, full);
+			op->cipher->process(out + *written, full);
+			*written += full;
+		}
+
+		op->carry.assign(in + full, in + remaining);
+	}
+	catch (const std::exception &e)
+	{
+		printf("Error: botan_native_stream_update(): %s\n", e.what());
+		return false;
+	}
+
+	return true;
+#endif
+}
+
+/**
+ * Finish the streamed message with the carried-over input.
+ * @param param A pointer to the cryptographic context.
+ * @param dst A pointer to the destination buffer for the rest of the
+ * ciphertext, the padding and the tag.
+ * @param written Output for the number of bytes written to dst.
+ * @return True on success, otherwise false.
+ */
+bool botan_native_stream_finish(void *param, void *dst, size_t *written)
+{
+#if defined(ECB)
+	return false;
+#else
+	BotanNativeParam *op = static_cast<BotanNativeParam *>(param);
+
+	try
+	{
+		op->cipher->finish(op->carry);
+		std::memcpy(dst, op->carry.data(), op->carry.size());
+		*written = op->carry.size();
+		op->carry.clear();
+	}
+	catch (const std::exception &e)
+	{
+		printf("Error: botan_native_stream_finish(): %s\n", e.what());
+		return false;
+	}
+
+	return true;
+#endif
+}
+
+/**
+ * Replace the key of the current cipher with the next one drawn in
+ * botan_native_set_cipher() through the Botan key schedule. A new key ends the
+ * message, so it is started again with the IV and associated data of
+ * botan_native_set_cipher().
+ * @param param A pointer to the cryptographic context.
+ * @return True on success, otherwise false.
+ */
+bool botan_native_rekey(void *param)
+{
+	if (!param)
+	{
+		return false;
+	}
+
+	BotanNativeParam *op = static_cast<BotanNativeParam *>(param);
+
+	try
+	{
+		const uint8_t *next = op->rekey_keys.data() + op->next_key * op->key.size();
+		std::memcpy(op->key.data(), next, op->key.size());
+		op->next_key = (op->next_key + 1) % REKEY_KEYS;
+
+#if defined(ECB)
+		op->bc->set_key(op->key.data(), op->key.size());
+#else
+		op->cipher->set_key(op->key.data(), op->key.size());
+		botan_native_start_message(op);
+#endif
+	}
+	catch (const std::exception &e)
+	{
+		printf("Error: botan_native_rekey(): %s\n", e.what());
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Encrypt one XTS data unit: the message is started with the tweak of the
+ * sector, encrypted in place in dst and only its final blocks are finished in
+ * the pre-allocated buffer.
+ * @param param A pointer to the cryptographic context.
+ * @param sector Number of the sector, the tweak is its little-endian encoding.
+ * @param size The size of the sector.
+ * @param dst A pointer to the destination buffer for the encrypted data.
+ * @param src A pointer to the source data to be encrypted.
+ * @return The size of the encrypted data or zero on error.
+ */
+size_t botan_native_encrypt_sector(void *param, const uint64_t sector, const size_t size, void *dst, const void *src)
+{
+#if defined(ECB)
+	return 0;
+#else
+	BotanNativeParam *op = static_cast<BotanNativeParam *>(param);
+	uint8_t tweak[IV_SIZE] = {0};
+
+	if (!op || !op->cipher || !dst || !src)
+	{
+		return 0;
+	}
+
+	for (int i = 0; i < 8; ++i)
+	{
+		tweak[i] = static_cast<uint8_t>(sector >> (8 * i));
+	}
+
+	try
+	{
+		// The sector is encrypted in place in dst, only the final blocks that
+		// finish() needs, with the ciphertext stealing, go through the buffer
+		const size_t final_size = op->cipher->minimum_final_size();
+		const size_t tail =
+			size < final_size ? size : final_size + (size - final_size) % op->cipher->update_granularity();
+		uint8_t *out = static_cast<uint8_t *>(dst);
+
+		std::memcpy(out, src, size);
+		op->cipher->start(tweak, sizeof(tweak));
+		op->cipher->process(out, size - tail);
+		op->buffer.assign(out + size - tail, out + size);
+		op->cipher->finish(op->buffer);
+		std::memcpy(out + size - tail, op->buffer.data(), op->buffer.size());
+
+		return size - tail + op->buffer.size();
+	}
+	catch (const std::exception &e)
+	{
+		printf("Error: botan_native_encrypt_sector(): %s\n", e.what());
+		return 0;
+	}
+#endif
+}
+
+/**
+ * Replace the key and IV of the current cipher, e.g. with those of a test
+ * vector, and start a new message with them and the associated data of
+ * botan_native_set_cipher().
+ * @param param A pointer to the cryptographic context.
+ * @param key The new key.
+ * @param key_size The size of the key, must be the key length of the cipher.
+ * @param iv The new IV.
+ * @param iv_size The size of the IV, must be the IV length of the cipher.
+ * @return True on success, otherwise false.
+ */
+bool botan_native_set_key(void *param, const uint8_t *key, const size_t key_size, const uint8_t *iv,
+						  const size_t iv_size)
+{
+	if (!param || !key || (iv_size && !iv))
+	{
+		return false;
+	}
+
+	BotanNativeParam *op = static_cast<BotanNativeParam *>(param);
+
+	if (key_size != op->key.size() || iv_size != op->iv.size())
+	{
+		printf("Error: botan_native_set_key(): the cipher takes a %zu bytes key and %zu bytes IV, not %zu and %zu!\n",
+			   op->key.size(), op->iv.size(), key_size, iv_size);
+		return false;
+	}
+
+	try
+	{
+		op->key.assign(key, key + key_size);
+
+#if defined(ECB)
+		op->bc->set_key(op->key.data(), op->key.size());
+#else
+		op->iv.assign(iv, iv + iv_size);
+		op->cipher->set_key(op->key.data(), op->key.size());
+		botan_native_start_message(op);
+#endif
+	}
+	catch (const std::exception &e)
+	{
+		printf("Error: botan_native_set_key(): %s\n", e.what());
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Prepare the native Botan backend to be called by main by defining pointers
+ * to functions containing the implementation.
+ *
+ * @return a pointer to a struct containing function pointers that implement
+ * the native Botan backend.
+ */
+const Crypto *botan_native_get()
+{
+	static const Crypto crypto = {
+		botan_native_name,
+		botan_ciphers,
+		botan_native_init,
+		botan_native_free,
+		botan_native_random,
+		botan_native_set_cipher,
+		botan_native_encrypt,
+		botan_native_encrypt_loop,
+		nullptr, nullptr, nullptr, // Hash and MAC functions are benchmarked by the FFI backend
+		nullptr, nullptr, nullptr, // Public-key operations
+		nullptr, nullptr, nullptr, // Random number generators
+		botan_native_stream_start,
+		botan_native_stream_update,
+		botan_native_stream_finish,
+		botan_native_rekey,
+		botan_native_encrypt_sector,
+		botan_native_set_key,
+	};
+
+	return &crypto;
+}
+
+CBOS_REGISTER_LIB(botan_native_get)
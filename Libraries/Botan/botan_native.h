@@ -0,0 +1,32 @@
+#pragma once
+
+#include "botan.h"
+
+#include <botan/aead.h>
+#include <botan/block_cipher.h>
+#include <botan/cipher_mode.h>
+#include <botan/secmem.h>
+#include <botan/version.h>
+
+#include <memory>
+
+/**
+ * Context of the native C++ Botan backend. All buffers are allocated once in
+ * botan_native_set_cipher() so encryption does not allocate.
+ */
+typedef struct BotanNativeParam
+{
+#if defined(ECB)
+	std::unique_ptr<Botan::BlockCipher> bc;
+#else
+	std::unique_ptr<Botan::Cipher_Mode> cipher;
+#endif
+	Botan::secure_vector<uint8_t> key;
+	Botan::secure_vector<uint8_t> rekey_keys; // REKEY_KEYS keys drawn in botan_native_set_cipher()
+	size_t next_key = 0;
+	Botan::secure_vector<uint8_t> iv;
+	Botan::secure_vector<uint8_t> buffer; // Whole-message modes like CCM and the final blocks of a sector
+	Botan::secure_vector<uint8_t> carry; // Input of the streamed message not yet processed
+	size_t granularity = 0;
+	bool whole_message = false; // The mode only encrypts in finish(), e.g. CCM
+} BotanNativeParam;
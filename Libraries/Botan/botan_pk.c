@@ -0,0 +1,248 @@
+#include "botan.h"
+
+#define PK_MESSAGE "CBOS public-key benchmark message"
+#define PK_MESSAGE_SIZE (sizeof(PK_MESSAGE) - 1)
+#define PK_MAX_SIZE 512
+
+typedef enum BotanPKType
+{
+	PK_DERIVE,
+	PK_SIGN,
+	PK_VERIFY,
+	PK_DECRYPT
+} BotanPKType;
+
+/**
+ * Entry of the public-key operation table.
+ */
+typedef struct BotanPKOperation
+{
+	const char *name;
+	const char *algorithm; // Algorithm for botan_privkey_create()
+	const char *params;	   // Curve or key size for botan_privkey_create()
+	const char *padding;   // Signature or encryption padding, KDF of key agreements
+	BotanPKType type;
+} BotanPKOperation;
+
+/**
+ * Keys and inputs of the current public-key operation, generated outside of
+ * the timed region.
+ */
+struct BotanPK
+{
+	const BotanPKOperation *operation;
+	botan_rng_t rng;
+	botan_privkey_t key;
+	botan_pubkey_t pub;
+	botan_privkey_t peer;
+	botan_pk_op_ka_t ka;
+	botan_pk_op_sign_t sign;
+	botan_pk_op_verify_t verify;
+	botan_pk_op_decrypt_t decrypt;
+	uint8_t input[PK_MAX_SIZE];
+	size_t input_size;
+	uint8_t output[PK_MAX_SIZE];
+};
+
+static const BotanPKOperation botan_pk_table[] = {
+	{"X25519", "Curve25519", "", "Raw", PK_DERIVE},
+	{"ECDH-P256", "ECDH", "secp256r1", "Raw", PK_DERIVE},
+	{"ECDSA-P256-sign", "ECDSA", "secp256r1", "SHA-256", PK_SIGN},
+	{"ECDSA-P256-verify", "ECDSA", "secp256r1", "SHA-256", PK_VERIFY},
+	{"Ed25519-sign", "Ed25519", "", "Pure", PK_SIGN},
+	{"Ed25519-verify", "Ed25519", "", "Pure", PK_VERIFY},
+	{"RSA-2048-sign", "RSA", "2048", "EMSA3(SHA-256)", PK_SIGN},
+	{"RSA-2048-verify", "RSA", "2048", "EMSA3(SHA-256)", PK_VERIFY},
+	{"RSA-2048-decrypt", "RSA", "2048", "OAEP(SHA-256)", PK_DECRYPT},
+	{"RSA-3072-sign", "RSA", "3072", "EMSA3(SHA-256)", PK_SIGN},
+	{"RSA-3072-verify", "RSA", "3072", "EMSA3(SHA-256)", PK_VERIFY},
+	{"RSA-3072-decrypt", "RSA", "3072", "OAEP(SHA-256)", PK_DECRYPT},
+};
+
+#define BOTAN_PK_COUNT (sizeof(botan_pk_table) / sizeof(botan_pk_table[0]))
+
+/**
+ * Get a list of public-key operations supported by the Botan library.
+ * @return An array of operation names as strings, with a NULL-terminated
+ * sentinel.
+ */
+const char **botan_pk_operations()
+{
+	static const char *names[BOTAN_PK_COUNT + 1];
+
+	if (!names[0])
+	{
+		for (size_t i = 0; i < BOTAN_PK_COUNT; ++i)
+		{
+			names[i] = botan_pk_table[i].name;
+		}
+	}
+
+	return names;
+}
+
+/**
+ * Free the keys and operations of the current public-key operation.
+ * @param pk The public-key state, may be NULL.
+ */
+void botan_pk_free(BotanPK *pk)
+{
+	if (!pk)
+	{
+		return;
+	}
+
+	botan_pk_op_key_agreement_destroy(pk->ka);
+	botan_pk_op_sign_destroy(pk->sign);
+	botan_pk_op_verify_destroy(pk->verify);
+	botan_pk_op_decrypt_destroy(pk->decrypt);
+	botan_pubkey_destroy(pk->pub);
+	botan_privkey_destroy(pk->peer);
+	botan_privkey_destroy(pk->key);
+	botan_rng_destroy(pk->rng);
+	free(pk);
+}
+
+/**
+ * Sign the benchmark message.
+ * @param pk The public-key state with a signature operation.
+ * @param sig Destination of the signature, PK_MAX_SIZE bytes.
+ * @param sig_size Output for the size of the signature.
+ * @return zero on success or a Botan error code.
+ */
+static int botan_pk_sign(BotanPK *pk, uint8_t *sig, size_t *sig_size)
+{
+	*sig_size = PK_MAX_SIZE;
+
+	int error = botan_pk_op_sign_update(pk->sign, (const uint8_t *)PK_MESSAGE, PK_MESSAGE_SIZE);
+	if (error)
+	{
+		return error;
+	}
+
+	return botan_pk_op_sign_finish(pk->sign, pk->rng, sig, sig_size);
+}
+
+/**
+ * Generate the keys and inputs of a public-key operation. For verification a
+ * signature and for decryption an OAEP ciphertext are prepared, so the timed
+ * region only contains the operation itself.
+ * @param param A pointer to the cryptographic context.
+ * @param operation The name of the operation.
+ * @return True if the operation is successfully set, otherwise false.
+ */
+bool botan_set_pk_operation(void *param, const char *operation)
+{
+	if (!param || !operation)
+	{
+		return false;
+	}
+
+	BotanParam *op = param;
+	const BotanPKOperation *entry = NULL;
+
+	for (size_t i = 0; i < BOTAN_PK_COUNT && !entry; ++i)
+	{
+		if (strcmp(botan_pk_table[i].name, operation) == 0)
+		{
+			entry = &botan_pk_table[i];
+		}
+	}
+
+	if (!entry)
+	{
+		printf("Error: botan_set_pk_operation(): \"%s\" is not a recognized operation!\n", operation);
+		return false;
+	}
+
+	botan_pk_free(op->pk);
+	op->pk = calloc(1, sizeof(BotanPK));
+	if (!op->pk)
+	{
+		return false;
+	}
+
+	BotanPK *pk = op->pk;
+	pk->operation = entry;
+
+	int error = botan_rng_init(&pk->rng, "system");
+	if (!error)
+		error = botan_privkey_create(&pk->key, entry->algorithm, entry->params, pk->rng);
+	if (!error)
+		error = botan_privkey_export_pubkey(&pk->pub, pk->key);
+	if (error)
+	{
+		printf("Error: botan_set_pk_operation(): generating a %s key has failed!\n", entry->algorithm);
+		return false;
+	}
+
+	switch (entry->type)
+	{
+	case PK_DERIVE:
+		pk->input_size = PK_MAX_SIZE;
+		error = botan_privkey_create(&pk->peer, entry->algorithm, entry->params, pk->rng);
+		if (!error)
+			error = botan_pk_op_key_agreement_export_public(pk->peer, pk->input, &pk->input_size);
+		if (!error)
+			error = botan_pk_op_key_agreement_create(&pk->ka, pk->key, entry->padding, 0);
+		break;
+	case PK_SIGN:
+		error = botan_pk_op_sign_create(&pk->sign, pk->key, entry->padding, 0);
+		break;
+	case PK_VERIFY:
+		error = botan_pk_op_sign_create(&pk->sign, pk->key, entry->padding, 0);
+		if (!error)
+			error = botan_pk_sign(pk, pk->input, &pk->input_size);
+		if (!error)
+			error = botan_pk_op_verify_create(&pk->verify, pk->pub, entry->padding, 0);
+		break;
+	case PK_DECRYPT:
+	{
+		botan_pk_op_encrypt_t encrypt = NULL;
+		pk->input_size = PK_MAX_SIZE;
+		error = botan_pk_op_encrypt_create(&encrypt, pk->pub, entry->padding, 0);
+		if (!error)
+			error = botan_pk_op_encrypt(encrypt, pk->rng, pk->input, &pk->input_size, (const uint8_t *)PK_MESSAGE,
+										PK_MESSAGE_SIZE);
+		botan_pk_op_encrypt_destroy(encrypt);
+		if (!error)
+			error = botan_pk_op_decrypt_create(&pk->decrypt, pk->key, entry->padding, 0);
+		break;
+	}
+	}
+
+	if (error)
+	{
+		printf("Error: botan_set_pk_operation(): preparing %s has failed with error %d!\n", operation, error);
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Perform the current public-key operation once.
+ * @param param A pointer to the cryptographic context.
+ * @return True on success, otherwise false.
+ */
+bool botan_pk_run(void *param)
+{
+	BotanParam *op = param;
+	BotanPK *pk = op->pk;
+	size_t size = PK_MAX_SIZE;
+
+	switch (pk->operation->type)
+	{
+	case PK_DERIVE:
+		return !botan_pk_op_key_agreement(pk->ka, pk->output, &size, pk->input, pk->input_size, NULL, 0);
+	case PK_SIGN:
+		return !botan_pk_sign(pk, pk->output, &size);
+	case PK_VERIFY:
+		return !botan_pk_op_verify_update(pk->verify, (const uint8_t *)PK_MESSAGE, PK_MESSAGE_SIZE) &&
+			   !botan_pk_op_verify_finish(pk->verify, pk->input, pk->input_size);
+	case PK_DECRYPT:
+		return !botan_pk_op_decrypt(pk->decrypt, pk->output, &size, pk->input, pk->input_size);
+	}
+
+	return false;
+}
@@ -1,7 +1,5 @@
 #include "openssl.h"
 
-#define openssl_error() (ERR_error_string(ERR_get_error(), NULL))
-
 /**
  * @return message size.
  */
@@ -28,30 +26,127 @@ const char *openssl_name()
 }
 
 /**
- * Get a list of ciphers supported by the OpenSSL library.
+ * Get the name of the OpenSSL library using pre-fetched ciphers.
+ * @return The name of the OpenSSL library as a string.
+ */
+const char *openssl_fetched_name()
+{
+	return OPENSSL_VERSION_TEXT " pre-fetched";
+}
+
+/**
+ * Load the providers listed in OPENSSL_PROVIDERS into a library context and
+ * apply OPENSSL_PROPQ as its default property query.
+ * @param libctx The library context, NULL for the default context.
+ * @return True if all providers are loaded, otherwise false.
+ */
+static bool openssl_load_providers(OSSL_LIB_CTX *libctx)
+{
+	char providers[] = OPENSSL_PROVIDERS;
+	const char *propq = OPENSSL_PROPQ;
+	char *saveptr = NULL;
+
+	for (char *provider = strtok_r(providers, ",", &saveptr); provider; provider = strtok_r(NULL, ",", &saveptr))
+	{
+		if (!OSSL_PROVIDER_load(libctx, provider))
+		{
+			printf("openssl_load_providers(): loading provider \"%s\" failed with error: %s\n", provider, openssl_error());
+			return false;
+		}
+	}
+
+	if (propq && !EVP_set_default_properties(libctx, propq))
+	{
+		printf("openssl_load_providers(): setting properties \"%s\" failed with error: %s\n", propq, openssl_error());
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * All ciphers the backend can benchmark. openssl_set_cipher() resolves names
+ * with this table at runtime.
+ */
+static const OpenSSLCipher openssl_cipher_table[] = {
+	{"AES-128-ECB", EVP_aes_128_ecb, 16, 0, false},
+	{"AES-128-CBC", EVP_aes_128_cbc, 16, IV_SIZE, false},
+	{"AES-128-CTR", EVP_aes_128_ctr, 16, IV_SIZE, false},
+	{"AES-128-CFB", EVP_aes_128_cfb, 16, IV_SIZE, false},
+	{"AES-128-XTS", EVP_aes_128_xts, 32, IV_SIZE, false},
+	{"AES-128-GCM", EVP_aes_128_gcm, 16, AEAD_IV_SIZE, true},
+	{"AES-128-CCM", EVP_aes_128_ccm, 16, AEAD_IV_SIZE, true},
+#ifndef OPENSSL_NO_OCB
+	{"AES-128-OCB", EVP_aes_128_ocb, 16, AEAD_IV_SIZE, true},
+#endif
+	{"AES-192-ECB", EVP_aes_192_ecb, 24, 0, false},
+	{"AES-192-CBC", EVP_aes_192_cbc, 24, IV_SIZE, false},
+	{"AES-192-CTR", EVP_aes_192_ctr, 24, IV_SIZE, false},
+	{"AES-192-CFB", EVP_aes_192_cfb, 24, IV_SIZE, false},
+	{"AES-192-GCM", EVP_aes_192_gcm, 24, AEAD_IV_SIZE, true},
+	{"AES-192-CCM", EVP_aes_192_ccm, 24, AEAD_IV_SIZE, true},
+#ifndef OPENSSL_NO_OCB
+	{"AES-192-OCB", EVP_aes_192_ocb, 24, AEAD_IV_SIZE, true},
+#endif
+	{"AES-256-ECB", EVP_aes_256_ecb, 32, 0, false},
+	{"AES-256-CBC", EVP_aes_256_cbc, 32, IV_SIZE, false},
+	{"AES-256-CTR", EVP_aes_256_ctr, 32, IV_SIZE, false},
+	{"AES-256-CFB", EVP_aes_256_cfb, 32, IV_SIZE, false},
+	{"AES-256-XTS", EVP_aes_256_xts, 64, IV_SIZE, false},
+	{"AES-256-GCM", EVP_aes_256_gcm, 32, AEAD_IV_SIZE, true},
+	{"AES-256-CCM", EVP_aes_256_ccm, 32, AEAD_IV_SIZE, true},
+#ifndef OPENSSL_NO_OCB
+	{"AES-256-OCB", EVP_aes_256_ocb, 32, AEAD_IV_SIZE, true},
+#endif
+#if !defined(OPENSSL_NO_CHACHA)
+	{"ChaCha20", EVP_chacha20, 32, IV_SIZE, false},
+#if !defined(OPENSSL_NO_POLY1305)
+	{"ChaCha20-Poly1305", EVP_chacha20_poly1305, 32, AEAD_IV_SIZE, true},
+#endif
+#endif
+};
+
+#define OPENSSL_CIPHER_COUNT (sizeof(openssl_cipher_table) / sizeof(openssl_cipher_table[0]))
+
+/**
+ * Look up a cipher in the cipher table.
+ * @param name The name of the cipher.
+ * @return The table entry or NULL if the cipher is unknown.
+ */
+static const OpenSSLCipher *openssl_find_cipher(const char *name)
+{
+	for (size_t i = 0; i < OPENSSL_CIPHER_COUNT; ++i)
+	{
+		if (strcmp(openssl_cipher_table[i].name, name) == 0)
+		{
+			return &openssl_cipher_table[i];
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Get a list of ciphers supported by the OpenSSL library: all AES modes with
+ * the key size selected by AES_128, AES_192 or AES_256, and ChaCha20.
  * @return An array of cipher names as strings, with a NULL-terminated sentinel.
  */
 const char **openssl_ciphers()
 {
-	static const char *names[] = {
-#if KEY_SIZE == 16
-		CIPHER_AES_128_ECB,
-		CIPHER_AES_128_CBC,
-		CIPHER_AES_128_CTR,
-		CIPHER_AES_128_CFB,
-#elif KEY_SIZE == 24
-		CIPHER_AES_192_ECB,
-		CIPHER_AES_192_CBC,
-		CIPHER_AES_192_CTR,
-		CIPHER_AES_192_CFB,
-#else
-		CIPHER_AES_256_ECB,
-		CIPHER_AES_256_CBC,
-		CIPHER_AES_256_CTR,
-		CIPHER_AES_192_CFB,
-#endif
-		NULL
-	};
+	static const char *names[OPENSSL_CIPHER_COUNT + 1];
+
+	if (!names[0])
+	{
+		size_t count = 0;
+		for (size_t i = 0; i < OPENSSL_CIPHER_COUNT; ++i)
+		{
+			const char *name = openssl_cipher_table[i].name;
+			if (strncmp(name, "AES-", 4) != 0 || atoi(name + 4) == KEY_SIZE * 8)
+			{
+				names[count++] = name;
+			}
+		}
+	}
 
 	return names;
 }
@@ -59,23 +154,74 @@ const char **openssl_ciphers()
 /**
  * Initialize the OpenSSL cryptographic context and parameter.
  * @param param A pointer to a void pointer where the context will be stored.
+ * @param prefetch Whether ciphers are fetched once from an own library context
+ * instead of implicitly on every EVP_EncryptInit_ex() call.
  * @return True if initialization is successful, otherwise false.
  */
-bool openssl_init(void **param)
+static bool openssl_init_param(void **param, const bool prefetch)
 {
+	static bool default_providers_loaded = false;
+
 	if (!param)
 	{
 		return false;
 	}
 
-	OpenSSLParam *op = malloc(sizeof(OpenSSLParam));
+	OpenSSLParam *op = calloc(1, sizeof(OpenSSLParam));
+	if (!op)
+	{
+		return false;
+	}
+
+	op->prefetch = prefetch;
+
+	if (prefetch)
+	{
+		op->libctx = OSSL_LIB_CTX_new();
+		if (!op->libctx || !openssl_load_providers(op->libctx))
+		{
+			openssl_free(op);
+			return false;
+		}
+	}
+	else if (!default_providers_loaded)
+	{
+		// The legacy getters fetch implicitly from the default library context
+		if (!openssl_load_providers(NULL))
+		{
+			openssl_free(op);
+			return false;
+		}
+		default_providers_loaded = true;
+	}
 
 	op->ctx_encrypt = EVP_CIPHER_CTX_new();
+	op->ctx_digest = EVP_MD_CTX_new();
 
 	*param = op;
 	return true;
 }
 
+/**
+ * Initialize the OpenSSL context that uses the legacy EVP_aes_*() getters.
+ * @param param A pointer to a void pointer where the context will be stored.
+ * @return True if initialization is successful, otherwise false.
+ */
+bool openssl_init(void **param)
+{
+	return openssl_init_param(param, false);
+}
+
+/**
+ * Initialize the OpenSSL context that uses ciphers fetched with EVP_CIPHER_fetch().
+ * @param param A pointer to a void pointer where the context will be stored.
+ * @return True if initialization is successful, otherwise false.
+ */
+bool openssl_fetched_init(void **param)
+{
+	return openssl_init_param(param, true);
+}
+
 /**
  * Free resources associated with the OpenSSL context.
  * @param param A pointer to the context to be freed.
@@ -90,6 +236,14 @@ bool openssl_free(void *param)
 
 	OpenSSLParam *op = param;
 
+	EVP_CIPHER_CTX_free(op->ctx_encrypt);
+	EVP_CIPHER_free(op->fetched_cipher);
+	EVP_MD_CTX_free(op->ctx_digest);
+	EVP_MD_free(op->fetched_md);
+	EVP_MAC_CTX_free(op->ctx_mac);
+	openssl_pk_free(op->pk);
+	EVP_RAND_CTX_free(op->rng);
+	OSSL_LIB_CTX_free(op->libctx);
 	free(op);
 
 	return true;
@@ -114,6 +268,88 @@ bool openssl_random(void *param, const size_t size, void *data)
 	return true;
 }
 
+/**
+ * Get a list of random number generators: RAND_bytes() with the thread-local
+ * DRBGs of OpenSSL and an own CTR-DRBG seeded from the primary DRBG.
+ * @return An array of generator names as strings, with a NULL-terminated sentinel.
+ */
+const char **openssl_rngs()
+{
+	static const char *rngs[] = {"RAND_bytes", "CTR-DRBG", NULL};
+	return rngs;
+}
+
+/**
+ * Set the random number generator used by openssl_rng_bytes().
+ * @param param A pointer to the cryptographic context.
+ * @param rng The name of the generator.
+ * @param shared Whether the generator is called from several threads, which
+ * enables the locking of an own DRBG.
+ * @return True if the generator is successfully set, otherwise false.
+ */
+bool openssl_set_rng(void *param, const char *rng, bool shared)
+{
+	if (!param || !rng)
+	{
+		return false;
+	}
+
+	OpenSSLParam *op = param;
+
+	EVP_RAND_CTX_free(op->rng);
+	op->rng = NULL;
+
+	if (strcmp(rng, "RAND_bytes") == 0)
+	{
+		return true;
+	}
+	else if (strcmp(rng, "CTR-DRBG") != 0)
+	{
+		printf("openssl_set_rng(): \"%s\" is not a recognized generator!\n", rng);
+		return false;
+	}
+
+	EVP_RAND *rand = EVP_RAND_fetch(op->libctx, "CTR-DRBG", OPENSSL_PROPQ);
+	if (rand)
+	{
+		op->rng = EVP_RAND_CTX_new(rand, RAND_get0_primary(op->libctx));
+		EVP_RAND_free(rand);
+	}
+
+	OSSL_PARAM params[] = {
+		OSSL_PARAM_construct_utf8_string(OSSL_DRBG_PARAM_CIPHER, "AES-256-CTR", 0),
+		OSSL_PARAM_construct_end(),
+	};
+
+	if (!op->rng || !EVP_RAND_instantiate(op->rng, 256, 0, NULL, 0, params) ||
+		(shared && !EVP_RAND_enable_locking(op->rng)))
+	{
+		printf("openssl_set_rng(): %s failed with error: %s\n", rng, openssl_error());
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Generate random data with the generator chosen by openssl_set_rng().
+ * @param param A pointer to the cryptographic context.
+ * @param size The size of random data to generate.
+ * @param dst A pointer to the destination buffer for the random data.
+ * @return True if random data is generated successfully, otherwise false.
+ */
+bool openssl_rng_bytes(void *param, const size_t size, void *dst)
+{
+	OpenSSLParam *op = param;
+
+	if (op->rng)
+	{
+		return EVP_RAND_generate(op->rng, dst, size, 0, 0, NULL, 0) > 0;
+	}
+
+	return RAND_bytes_ex(op->libctx, dst, size, 0) > 0;
+}
+
 /**
  * Set the cipher and keys to be used for cryptographic operations.
  * @param param A pointer to the cryptographic context.
@@ -128,84 +364,209 @@ bool openssl_set_cipher(void *param, const char *cipher)
 	}
 
 	OpenSSLParam *op = param;
-	const char **ciphers = openssl_ciphers();
+	const OpenSSLCipher *entry = openssl_find_cipher(cipher);
 
-	if (strcmp(cipher, ciphers[0]) == 0)
+	if (!entry)
 	{
-		op->current_cipher = EVP_aes_128_ecb();
+		printf("openssl_set_cipher(): \"%s\" is not a recognized cipher!\n", cipher);
+		return false;
 	}
 
-	else if (strcmp(cipher, ciphers[1]) == 0)
+	EVP_CIPHER_free(op->fetched_cipher);
+	op->fetched_cipher = NULL;
+
+	if (op->prefetch)
 	{
-		op->current_cipher = EVP_aes_128_cbc();
+		op->fetched_cipher = EVP_CIPHER_fetch(op->libctx, cipher, OPENSSL_PROPQ);
+		if (!op->fetched_cipher)
+		{
+			printf("openssl_set_cipher(): EVP_CIPHER_fetch(\"%s\") failed with error: %s\n", cipher, openssl_error());
+			return false;
+		}
+		op->current_cipher = op->fetched_cipher;
 	}
-	else if (strcmp(cipher, ciphers[2]) == 0)
+	else
 	{
-		op->current_cipher = EVP_aes_128_ctr();
+		op->current_cipher = entry->legacy_cipher();
 	}
-	else if (strcmp(cipher, ciphers[3]) == 0)
+
+	op->cipher = entry;
+	op->keyed = false;
+	op->key_once = false;
+
+	// ECB and CBC are not padded, so they are not finalized
+	op->finalize = EVP_CIPHER_mode(op->current_cipher) != EVP_CIPH_ECB_MODE &&
+				   EVP_CIPHER_mode(op->current_cipher) != EVP_CIPH_CBC_MODE;
+
+	if (!openssl_random(param, entry->key_length, op->key))
 	{
-		op->current_cipher = EVP_aes_128_cfb();
+		printf("openssl_set_cipher(): openssl_random() failed to generate the key!\n");
+		return false;
 	}
-	else
+
+	if (!openssl_random(param, MAX_IV_SIZE, op->iv))
 	{
-		printf("openssl_set_cipher(): \"%s\" is not a recognized cipher!\n", cipher);
+		printf("openssl_set_cipher(): openssl_random() failed to generate the IV!\n");
 		return false;
 	}
 
-	if (!openssl_random(param, KEY_SIZE, op->key))
+	for (size_t i = 0; i < REKEY_KEYS; ++i)
 	{
-		printf("openssl_set_cipher(): openssl_random() failed to generate the key!\n");
-		return false;
+		if (!openssl_random(param, entry->key_length, op->rekey_keys[i]))
+		{
+			printf("openssl_set_cipher(): openssl_random() failed to generate the keys of openssl_rekey()!\n");
+			return false;
+		}
 	}
+	op->next_key = 0;
 
-	if (!openssl_random(param, IV_SIZE, op->iv))
+	// Check once that the cipher accepts the parameters of the table
+	if (!EVP_EncryptInit_ex(op->ctx_encrypt, op->current_cipher, NULL, NULL, NULL))
 	{
-		printf("openssl_set_cipher(): openssl_random() failed to generate the IV!\n");
+		printf("openssl_set_cipher(): EVP_EncryptInit_ex() failed with error: %s\n", openssl_error());
 		return false;
 	}
 
-	if (!EVP_CipherInit(op->ctx_encrypt, op->current_cipher, op->key, op->iv, 1))
+	if (EVP_CIPHER_CTX_key_length(op->ctx_encrypt) != entry->key_length ||
+		EVP_CIPHER_CTX_iv_length(op->ctx_encrypt) < (entry->aead ? 1 : entry->iv_length))
 	{
-		printf("openssl_set_cipher(): [encrypt] EVP_CipherInit() failed with error: %s\n", openssl_error());
+		printf("openssl_set_cipher(): %s uses a %d bytes key and %d bytes IV, the table expects %d and %d!\n", cipher,
+			   EVP_CIPHER_CTX_key_length(op->ctx_encrypt), EVP_CIPHER_CTX_iv_length(op->ctx_encrypt),
+			   entry->key_length, entry->iv_length);
 		return false;
 	}
 
+	return true;
+}
+
+/**
+ * Run the key schedule of the current cipher, which passes the cipher to
+ * OpenSSL and so fetches the legacy objects implicitly. AEAD ciphers get
+ * their IV and tag length first, they must be set before the key.
+ * @param op The OpenSSL context with the cipher already set.
+ * @param iv The IV to start a message with, NULL to only set the key.
+ * @return True on success, otherwise false.
+ */
+static bool openssl_key_schedule(OpenSSLParam *op, const unsigned char *iv)
+{
 	EVP_CIPHER_CTX *ctx = op->ctx_encrypt;
+	const OpenSSLCipher *cipher = op->cipher;
+
+	op->keyed = false;
 
-	if (op->current_cipher == EVP_aes_128_ecb())
+	if (cipher->aead)
 	{
-		if (!EVP_EncryptInit_ex(ctx, EVP_aes_128_ecb(), NULL, op->key, NULL))
+		if (!EVP_EncryptInit_ex(ctx, op->current_cipher, NULL, NULL, NULL) ||
+			!EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_IVLEN, cipher->iv_length, NULL) ||
+			(EVP_CIPHER_CTX_mode(ctx) == EVP_CIPH_CCM_MODE &&
+			 !EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_TAG, AEAD_TAG_SIZE, NULL)) ||
+			!EVP_EncryptInit_ex(ctx, NULL, NULL, op->key, iv))
 		{
-			printf("openssl_set_cipher(): EVP_EncryptInit_ex() failed with error: %s\n", openssl_error());
-			return 0;
+			printf("openssl_key_schedule(): EVP_EncryptInit_ex() failed with error: %s\n", openssl_error());
+			return false;
 		}
 	}
-	else if (op->current_cipher == EVP_aes_128_ctr())
+	else if (!EVP_EncryptInit_ex(ctx, op->current_cipher, NULL, op->key, iv))
+	{
+		printf("openssl_key_schedule(): EVP_EncryptInit_ex() failed with error: %s\n", openssl_error());
+		return false;
+	}
+
+	op->keyed = true;
+	return true;
+}
+
+/**
+ * Start a message with the key and IV of the current cipher. Every message
+ * runs the key schedule, until openssl_rekey() keeps the key in the context:
+ * from then on messages only set their IV. AEAD ciphers get the associated
+ * data.
+ * @param op The OpenSSL context with the cipher already set.
+ * @param size The size of the message, CCM has to know it in advance.
+ * @return True on success, otherwise false.
+ */
+static inline bool openssl_start_message(OpenSSLParam *op, const size_t size)
+{
+	EVP_CIPHER_CTX *ctx = op->ctx_encrypt;
+	int out;
+
+	if (!op->key_once || !op->keyed)
 	{
-		if (!EVP_EncryptInit_ex(ctx, EVP_aes_128_ctr(), NULL, op->key, op->iv))
+		if (!openssl_key_schedule(op, op->iv))
 		{
-			printf("openssl_set_cipher(): EVP_EncryptInit_ex() failed with error: %s\n", openssl_error());
-			return 0;
+			return false;
 		}
 	}
-	else if (op->current_cipher == EVP_aes_128_cbc())
+	else if (!EVP_EncryptInit_ex(ctx, NULL, NULL, NULL, op->iv))
 	{
-		if (!EVP_EncryptInit_ex(ctx, EVP_aes_128_cbc(), NULL, op->key, op->iv))
+		printf("openssl_encrypt(): EVP_EncryptInit_ex() failed with error: %s\n", openssl_error());
+		return false;
+	}
+
+	if (op->cipher->aead)
+	{
+		// CCM has to know the message length in advance
+		if (EVP_CIPHER_CTX_mode(ctx) == EVP_CIPH_CCM_MODE && !EVP_EncryptUpdate(ctx, NULL, &out, NULL, size))
 		{
-			printf("openssl_set_cipher(): EVP_EncryptInit_ex() failed with error: %s\n", openssl_error());
-			return 0;
+			printf("openssl_encrypt(): EVP_EncryptUpdate() failed with error: %s\n", openssl_error());
+			return false;
 		}
+
+		if (!EVP_EncryptUpdate(ctx, NULL, &out, (const unsigned char *)"ADADADADADADADAD", 16))
+		{
+			printf("openssl_encrypt(): EVP_EncryptUpdate() failed with error: %s\n", openssl_error());
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Encrypt data without argument checks. Shared by openssl_encrypt() and the
+ * specialized loops of openssl_encrypt_loop().
+ * @param op The OpenSSL context with the cipher already set.
+ * @param size The size of the source data.
+ * @param dst A pointer to the destination buffer for the encrypted data.
+ * @param src A pointer to the source data to be encrypted.
+ * @param finalize Whether EVP_CipherFinal() is called after the update.
+ * @return The size of the encrypted data or zero on error.
+ */
+static inline size_t openssl_encrypt_kernel(OpenSSLParam *op, const size_t size, void *dst, const void *src,
+											const bool finalize)
+{
+	EVP_CIPHER_CTX *ctx = op->ctx_encrypt;
+	const OpenSSLCipher *cipher = op->cipher;
+	int out;
+
+	if (!openssl_start_message(op, size))
+	{
+		return 0;
 	}
-	else if (op->current_cipher == EVP_aes_128_cfb())
+
+	if (!EVP_CipherUpdate(ctx, dst, &out, src, size))
 	{
-		if (!EVP_EncryptInit_ex(ctx, EVP_aes_128_cfb(), NULL, op->key, op->iv))
+		printf("openssl_encrypt(): EVP_CipherUpdate() failed with error: %s\n", openssl_error());
+		return 0;
+	}
+
+	int out_2 = 0;
+
+	if (finalize)
+	{
+		if (!EVP_CipherFinal(ctx, (unsigned char *)dst + out, &out_2))
 		{
-			printf("openssl_set_cipher(): EVP_EncryptInit_ex() failed with error: %s\n", openssl_error());
-			return 0;
+			printf("openssl_encrypt(): EVP_CipherFinal() failed with error: %s\n", openssl_error());
 		}
 	}
-	return true;
+
+	if (cipher->aead && !EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG, AEAD_TAG_SIZE, op->tag))
+	{
+		printf("openssl_encrypt(): getting the tag failed with error: %s\n", openssl_error());
+		return 0;
+	}
+
+	return out + out_2;
 }
 
 /**
@@ -232,41 +593,417 @@ size_t openssl_encrypt(void *param, const size_t size, void *dst, const void *sr
 		return 0;
 	}
 
-	if (!EVP_EncryptInit_ex(ctx, op->current_cipher, NULL, op->key, op->iv))
+	return openssl_encrypt_kernel(op, size, dst, src, op->finalize);
+}
+
+/* Kernels with the finalization decided at compile time */
+static inline size_t openssl_kernel_update(void *param, const size_t size, void *dst, const void *src)
+{
+	return openssl_encrypt_kernel(param, size, dst, src, false);
+}
+
+static inline size_t openssl_kernel_final(void *param, const size_t size, void *dst, const void *src)
+{
+	return openssl_encrypt_kernel(param, size, dst, src, true);
+}
+
+CBOS_DEFINE_ENCRYPT_LOOP(openssl_loop_update, openssl_kernel_update, MESSAGE_SIZE)
+CBOS_DEFINE_ENCRYPT_LOOP(openssl_loop_final, openssl_kernel_final, MESSAGE_SIZE)
+
+/**
+ * Start a message that is encrypted in several openssl_stream_update() calls.
+ * ECB and CBC are not padded, like in openssl_encrypt(). CCM has to know the
+ * message length in advance and XTS encrypts every update as an own data unit,
+ * so both cannot be streamed.
+ * @param param A pointer to the cryptographic context.
+ * @return True on success, otherwise false.
+ */
+bool openssl_stream_start(void *param)
+{
+	OpenSSLParam *op = param;
+	const int mode = EVP_CIPHER_mode(op->current_cipher);
+
+	if (mode == EVP_CIPH_CCM_MODE || mode == EVP_CIPH_XTS_MODE || !openssl_start_message(op, 0))
+	{
+		return false;
+	}
+
+	return EVP_CIPHER_CTX_set_padding(op->ctx_encrypt, 0);
+}
+
+/**
+ * Encrypt the next part of the streamed message. OpenSSL buffers partial
+ * blocks internally, so fewer or more bytes than `size` may be written.
+ * @param param A pointer to the cryptographic context.
+ * @param size The size of the source data.
+ * @param dst A pointer to the destination buffer, at least size + one block.
+ * @param src A pointer to the source data to be encrypted.
+ * @param written Output for the number of bytes written to dst.
+ * @return True on success, otherwise false.
+ */
+bool openssl_stream_update(void *param, const size_t size, void *dst, const void *src, size_t *written)
+{
+	OpenSSLParam *op = param;
+	int out = 0;
+
+	if (!EVP_EncryptUpdate(op->ctx_encrypt, dst, &out, src, size))
+	{
+		printf("openssl_stream_update(): EVP_EncryptUpdate() failed with error: %s\n", openssl_error());
+		return false;
+	}
+
+	*written = out;
+	return true;
+}
+
+/**
+ * Finish the streamed message. The tag of AEAD ciphers is stored in the
+ * context like in openssl_encrypt().
+ * @param param A pointer to the cryptographic context.
+ * @param dst A pointer to the destination buffer for the buffered input.
+ * @param written Output for the number of bytes written to dst.
+ * @return True on success, otherwise false.
+ */
+bool openssl_stream_finish(void *param, void *dst, size_t *written)
+{
+	OpenSSLParam *op = param;
+	int out = 0;
+
+	if (!EVP_EncryptFinal_ex(op->ctx_encrypt, dst, &out) ||
+		(op->cipher->aead && !EVP_CIPHER_CTX_ctrl(op->ctx_encrypt, EVP_CTRL_AEAD_GET_TAG, AEAD_TAG_SIZE, op->tag)))
+	{
+		printf("openssl_stream_finish(): finishing the message failed with error: %s\n", openssl_error());
+		return false;
+	}
+
+	*written = out;
+	return true;
+}
+
+/**
+ * Replace the key of the current cipher with the next one drawn in
+ * openssl_set_cipher() and run its key schedule. From then on the context
+ * keeps the key and messages only set their IV, like in Botan, so this is
+ * the only key setup between them until the next cipher is set.
+ * @param param A pointer to the cryptographic context.
+ * @return True on success, otherwise false.
+ */
+bool openssl_rekey(void *param)
+{
+	OpenSSLParam *op = param;
+
+	if (!op || !op->cipher)
+	{
+		return false;
+	}
+
+	memcpy(op->key, op->rekey_keys[op->next_key], op->cipher->key_length);
+	op->next_key = (op->next_key + 1) % REKEY_KEYS;
+	op->key_once = true;
+	return openssl_key_schedule(op, NULL);
+}
+
+/**
+ * Encrypt one XTS data unit. The key schedule is only run for the first
+ * sector after the key changed, every other sector only sets its tweak.
+ * @param param A pointer to the cryptographic context.
+ * @param sector Number of the sector, the tweak is its little-endian encoding.
+ * @param size The size of the sector.
+ * @param dst A pointer to the destination buffer for the encrypted data.
+ * @param src A pointer to the source data to be encrypted.
+ * @return The size of the encrypted data or zero on error.
+ */
+size_t openssl_encrypt_sector(void *param, const uint64_t sector, const size_t size, void *dst, const void *src)
+{
+	OpenSSLParam *op = param;
+	unsigned char tweak[MAX_IV_SIZE] = {0};
+	int out = 0, out_2 = 0;
+
+	if (!op || !op->cipher || !dst || !src || EVP_CIPHER_mode(op->current_cipher) != EVP_CIPH_XTS_MODE)
 	{
-		printf("openssl_encrypt(): EVP_EncryptInit_ex() failed with error: %s\n", openssl_error());
 		return 0;
 	}
 
-	int out;
+	for (int i = 0; i < 8; ++i)
+	{
+		tweak[i] = (unsigned char)(sector >> (8 * i));
+	}
 
-	if (!EVP_CipherUpdate(ctx, dst, &out, src, MESSAGE_SIZE))
+	if (!op->keyed && !openssl_key_schedule(op, NULL))
 	{
-		printf("openssl_encrypt(): EVP_CipherUpdate() failed with error: %s\n", openssl_error());
 		return 0;
 	}
 
-	int out_2 = 0;
+	if (!EVP_EncryptInit_ex(op->ctx_encrypt, NULL, NULL, NULL, tweak) ||
+		!EVP_EncryptUpdate(op->ctx_encrypt, dst, &out, src, size) ||
+		!EVP_EncryptFinal_ex(op->ctx_encrypt, (unsigned char *)dst + out, &out_2))
+	{
+		printf("openssl_encrypt_sector(): encrypting sector %lu failed with error: %s\n", (unsigned long)sector,
+			   openssl_error());
+		op->keyed = false;
+		return 0;
+	}
+
+	return out + out_2;
+}
+
+/**
+ * Replace the key and IV of the current cipher, e.g. with those of a test
+ * vector. The next message is started with them.
+ * @param param A pointer to the cryptographic context.
+ * @param key The new key.
+ * @param key_size The size of the key, must be the key length of the cipher.
+ * @param iv The new IV, the counter and nonce for ChaCha20.
+ * @param iv_size The size of the IV, must be the IV length of the cipher.
+ * @return True on success, otherwise false.
+ */
+bool openssl_set_key(void *param, const uint8_t *key, const size_t key_size, const uint8_t *iv, const size_t iv_size)
+{
+	OpenSSLParam *op = param;
+
+	if (!op || !op->cipher || !key || (iv_size && !iv))
+	{
+		return false;
+	}
 
-	if (op->current_cipher == EVP_aes_128_ctr() ||
-		op->current_cipher == EVP_aes_128_cfb())
+	if (key_size != (size_t)op->cipher->key_length || iv_size != (size_t)op->cipher->iv_length)
 	{
-		if (!EVP_CipherFinal(ctx, dst + out, &out_2))
+		printf("openssl_set_key(): %s takes a %d bytes key and %d bytes IV, not %zu and %zu!\n", op->cipher->name,
+			   op->cipher->key_length, op->cipher->iv_length, key_size, iv_size);
+		return false;
+	}
+
+	memcpy(op->key, key, key_size);
+	memset(op->iv, 0, sizeof(op->iv));
+	if (iv_size)
+	{
+		memcpy(op->iv, iv, iv_size);
+	}
+	op->keyed = false;
+	return true;
+}
+
+/**
+ * Encrypt data repeatedly with the loop specialized for the current cipher.
+ * The finalization is decided once per batch instead of once per call.
+ * @param param A pointer to the cryptographic context.
+ * @param size The size of the source data, must be MESSAGE_SIZE.
+ * @param dst A pointer to the destination buffer for the encrypted data.
+ * @param src A pointer to the source data to be encrypted.
+ * @param iterations The number of encryptions.
+ * @return The number of completed encryptions.
+ */
+size_t openssl_encrypt_loop(void *param, const size_t size, void *dst, const void *src, const size_t iterations)
+{
+	if (!param || !dst || !src)
+	{
+		return 0;
+	}
+
+	OpenSSLParam *op = param;
+
+	if (op->ctx_encrypt == NULL)
+	{
+		printf("openssl_encrypt_loop(): EVP context is NULL\n");
+		return 0;
+	}
+
+	if (op->finalize)
+	{
+		return openssl_loop_final(param, size, dst, src, iterations);
+	}
+
+	return openssl_loop_update(param, size, dst, src, iterations);
+}
+
+/**
+ * All hash and MAC functions the backend can benchmark.
+ */
+static const OpenSSLDigest openssl_digest_table[] = {
+	{"SHA-256", "SHA2-256", NULL, 0, false},
+	{"SHA-512", "SHA2-512", NULL, 0, false},
+	{"SHA3-256", "SHA3-256", NULL, 0, false},
+	{"SHA3-512", "SHA3-512", NULL, 0, false},
+	{"BLAKE2b-512", "BLAKE2B-512", NULL, 0, false},
+	{"BLAKE2s-256", "BLAKE2S-256", NULL, 0, false},
+	{"HMAC-SHA-256", "HMAC", "SHA2-256", 32, false},
+	{"HMAC-SHA-512", "HMAC", "SHA2-512", 32, false},
+#if !defined(OPENSSL_NO_POLY1305)
+	{"Poly1305", "POLY1305", NULL, 32, true},
+#endif
+};
+
+#define OPENSSL_DIGEST_COUNT (sizeof(openssl_digest_table) / sizeof(openssl_digest_table[0]))
+
+/**
+ * Get a list of hash and MAC functions supported by the OpenSSL library.
+ * @return An array of names as strings, with a NULL-terminated sentinel.
+ */
+const char **openssl_digests()
+{
+	static const char *names[OPENSSL_DIGEST_COUNT + 1];
+
+	if (!names[0])
+	{
+		for (size_t i = 0; i < OPENSSL_DIGEST_COUNT; ++i)
 		{
-			printf("openssl_encrypt(): EVP_CipherFinal() failed with error: %s\n", openssl_error());
+			names[i] = openssl_digest_table[i].name;
 		}
 	}
 
-	return out + out_2;
+	return names;
+}
+
+/**
+ * Set the hash or MAC function and its key. Hash functions are fetched once in
+ * the pre-fetched variant and looked up with EVP_get_digestbyname() otherwise.
+ * MACs are always fetched, there are no legacy MAC objects.
+ * @param param A pointer to the cryptographic context.
+ * @param digest The name of the hash or MAC function.
+ * @return True if the function is successfully set, otherwise false.
+ */
+bool openssl_set_digest(void *param, const char *digest)
+{
+	if (!param || !digest)
+	{
+		return false;
+	}
+
+	OpenSSLParam *op = param;
+	const OpenSSLDigest *entry = NULL;
+
+	for (size_t i = 0; i < OPENSSL_DIGEST_COUNT && !entry; ++i)
+	{
+		if (strcmp(openssl_digest_table[i].name, digest) == 0)
+		{
+			entry = &openssl_digest_table[i];
+		}
+	}
+
+	if (!entry)
+	{
+		printf("openssl_set_digest(): \"%s\" is not a recognized hash or MAC function!\n", digest);
+		return false;
+	}
+
+	EVP_MD_free(op->fetched_md);
+	op->fetched_md = NULL;
+	op->current_md = NULL;
+	EVP_MAC_CTX_free(op->ctx_mac);
+	op->ctx_mac = NULL;
+	op->digest = entry;
+
+	if (!entry->key_length)
+	{
+		if (op->prefetch)
+		{
+			op->fetched_md = EVP_MD_fetch(op->libctx, entry->algorithm, OPENSSL_PROPQ);
+			op->current_md = op->fetched_md;
+		}
+		else
+		{
+			op->current_md = EVP_get_digestbyname(entry->algorithm);
+		}
+
+		if (!op->current_md)
+		{
+			printf("openssl_set_digest(): fetching %s failed with error: %s\n", digest, openssl_error());
+			return false;
+		}
+
+		return true;
+	}
+
+	EVP_MAC *mac = EVP_MAC_fetch(op->libctx, entry->algorithm, OPENSSL_PROPQ);
+	if (!mac)
+	{
+		printf("openssl_set_digest(): EVP_MAC_fetch(\"%s\") failed with error: %s\n", entry->algorithm, openssl_error());
+		return false;
+	}
+
+	op->ctx_mac = EVP_MAC_CTX_new(mac);
+	EVP_MAC_free(mac);
+	if (!op->ctx_mac)
+	{
+		printf("openssl_set_digest(): EVP_MAC_CTX_new() failed with error: %s\n", openssl_error());
+		return false;
+	}
+
+	if (!openssl_random(param, entry->key_length, op->mac_key))
+	{
+		printf("openssl_set_digest(): openssl_random() failed to generate the key!\n");
+		return false;
+	}
+
+	OSSL_PARAM params[2] = {OSSL_PARAM_END, OSSL_PARAM_END};
+	if (entry->mac_digest)
+	{
+		params[0] = OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, (char *)entry->mac_digest, 0);
+	}
+
+	if (!EVP_MAC_init(op->ctx_mac, op->mac_key, entry->key_length, params))
+	{
+		printf("openssl_set_digest(): EVP_MAC_init() failed with error: %s\n", openssl_error());
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Hash or authenticate data.
+ * @param param A pointer to the cryptographic context.
+ * @param size The size of the source data.
+ * @param dst A pointer to the destination buffer for the digest or tag.
+ * @param src A pointer to the source data.
+ * @return The size of the digest or tag, zero on error.
+ */
+size_t openssl_digest(void *param, const size_t size, void *dst, const void *src)
+{
+	if (!param || !dst || !src)
+	{
+		return 0;
+	}
+
+	OpenSSLParam *op = param;
+
+	if (op->current_md)
+	{
+		unsigned int out = 0;
+
+		if (!EVP_DigestInit_ex(op->ctx_digest, op->current_md, NULL) ||
+			!EVP_DigestUpdate(op->ctx_digest, src, size) ||
+			!EVP_DigestFinal_ex(op->ctx_digest, dst, &out))
+		{
+			printf("openssl_digest(): hashing failed with error: %s\n", openssl_error());
+			return 0;
+		}
+
+		return out;
+	}
+
+	size_t out = 0;
+
+	// HMAC keeps its key across messages, Poly1305 keys have to be set again
+	if (!EVP_MAC_init(op->ctx_mac, op->digest->rekey ? op->mac_key : NULL, op->digest->rekey ? op->digest->key_length : 0, NULL) ||
+		!EVP_MAC_update(op->ctx_mac, src, size) ||
+		!EVP_MAC_final(op->ctx_mac, dst, &out, MAX_DIGEST_SIZE))
+	{
+		printf("openssl_digest(): authenticating failed with error: %s\n", openssl_error());
+		return 0;
+	}
+
+	return out;
 }
 
 /**
  * Prepare OpenSSL to be called by main by defining pointers to functions containing
- * the implementation.
+ * the implementation. Ciphers are passed to EVP_EncryptInit_ex() as legacy
+ * EVP_aes_*() objects, which OpenSSL 3 fetches implicitly on every call.
  *
  * @return a pointer to a struct containing function pointers that implement OpenSSL.
  */
-const Crypto *get_lib()
+const Crypto *openssl_get()
 {
 	static const Crypto crypto = {
 		openssl_name,
@@ -276,7 +1013,64 @@ const Crypto *get_lib()
 		openssl_random,
 		openssl_set_cipher,
 		openssl_encrypt,
+		openssl_encrypt_loop,
+		openssl_digests,
+		openssl_set_digest,
+		openssl_digest,
+		openssl_pk_operations,
+		openssl_set_pk_operation,
+		openssl_pk_run,
+		openssl_rngs,
+		openssl_set_rng,
+		openssl_rng_bytes,
+		openssl_stream_start,
+		openssl_stream_update,
+		openssl_stream_finish,
+		openssl_rekey,
+		openssl_encrypt_sector,
+		openssl_set_key,
 	};
 
 	return &crypto;
-}
\ No newline at end of file
+}
+
+CBOS_REGISTER_LIB(openssl_get)
+
+/**
+ * Prepare OpenSSL with ciphers that are fetched once with EVP_CIPHER_fetch()
+ * from a library context configured by OPENSSL_PROVIDERS and OPENSSL_PROPQ.
+ *
+ * @return a pointer to a struct containing function pointers that implement OpenSSL.
+ */
+const Crypto *openssl_fetched_get()
+{
+	static const Crypto crypto = {
+		openssl_fetched_name,
+		openssl_ciphers,
+		openssl_fetched_init,
+		openssl_free,
+		openssl_random,
+		openssl_set_cipher,
+		openssl_encrypt,
+		openssl_encrypt_loop,
+		openssl_digests,
+		openssl_set_digest,
+		openssl_digest,
+		openssl_pk_operations,
+		openssl_set_pk_operation,
+		openssl_pk_run,
+		openssl_rngs,
+		openssl_set_rng,
+		openssl_rng_bytes,
+		openssl_stream_start,
+		openssl_stream_update,
+		openssl_stream_finish,
+		openssl_rekey,
+		openssl_encrypt_sector,
+		openssl_set_key,
+	};
+
+	return &crypto;
+}
+
+CBOS_REGISTER_LIB(openssl_fetched_get)
@@ -1,7 +1,17 @@
 #pragma once
 
+// AES key size of the benchmarked cipher list, the cipher table covers all sizes
+#if !defined(AES_128) && !defined(AES_192) && !defined(AES_256)
 #define AES_128
+#endif
+
 #define IV_SIZE 16
+#define AEAD_IV_SIZE 12
+#define AEAD_TAG_SIZE 16
+
+// Largest key and IV in the cipher table (AES-256-XTS, AES-CTR)
+#define MAX_KEY_SIZE 64
+#define MAX_IV_SIZE 16
 
 #ifdef AES_128
 #define KEY_SIZE 16
@@ -15,23 +25,6 @@
 #define KEY_SIZE 32
 #endif
 
-#if KEY_SIZE == 16
-#define CIPHER_AES_128_ECB "AES-128-ECB"
-#define CIPHER_AES_128_CBC "AES-128-CBC"
-#define CIPHER_AES_128_CTR "AES-128-CTR"
-#define CIPHER_AES_128_CFB "AES-128-CFB"
-#elif KEY_SIZE == 24
-#define CIPHER_AES_192_ECB "AES-192-ECB"
-#define CIPHER_AES_192_CBC "AES-192-CBC"
-#define CIPHER_AES_192_CTR "AES-192-CTR"
-#define CIPHER_AES_192_CFB "AES-192-CFB"
-#else
-#define CIPHER_AES_256_ECB "AES-256-ECB"
-#define CIPHER_AES_256_CBC "AES-256-CBC"
-#define CIPHER_AES_256_CTR "AES-256-CTR"
-#define CIPHER_AES_192_CFB "AES-256-CFB"
-#endif
-
 #ifndef MESSAGE_SIZE
 #define MESSAGE_SIZE 4096
 #endif
@@ -40,15 +33,87 @@
 #define ITERATIONS 100
 #endif
 
+// Comma separated providers to load, e.g. "default", "fips" or "default,legacy"
+#ifndef OPENSSL_PROVIDERS
+#define OPENSSL_PROVIDERS "default"
+#endif
+
+// Property query used to fetch ciphers, e.g. "provider=default" or "fips=yes"
+#ifndef OPENSSL_PROPQ
+#define OPENSSL_PROPQ NULL
+#endif
+
 #include "../../src/cbos.h"
+#include "../../src/direct.h"
 #include "openssl/err.h"
+#include "openssl/core_names.h"
 #include "openssl/evp.h"
 #include "openssl/opensslv.h"
+#include "openssl/provider.h"
+#include "openssl/rand.h"
+#include "openssl/rsa.h"
+
+#define openssl_error() (ERR_error_string(ERR_get_error(), NULL))
+
+/**
+ * Entry of the cipher table that openssl_set_cipher() resolves names with.
+ */
+typedef struct OpenSSLCipher
+{
+	const char *name;						// OpenSSL name, also used for EVP_CIPHER_fetch()
+	const EVP_CIPHER *(*legacy_cipher)(void); // Legacy getter, fetched implicitly by OpenSSL 3
+	int key_length;
+	int iv_length;
+	bool aead;
+} OpenSSLCipher;
+
+/**
+ * Entry of the hash and MAC table that openssl_set_digest() resolves names with.
+ */
+typedef struct OpenSSLDigest
+{
+	const char *name;
+	const char *algorithm;	// EVP_MD or EVP_MAC name to fetch
+	const char *mac_digest; // Digest of HMAC, otherwise NULL
+	int key_length;			// Zero for hash functions
+	bool rekey;				// One-time key, set for every message
+} OpenSSLDigest;
+
+#define MAX_MAC_KEY_SIZE 32
+
+/* keys and inputs of public-key operations, see openssl_pk.c */
+typedef struct OpenSSLPK OpenSSLPK;
 
 typedef struct OpenSSLParam
 {
-	unsigned char key[KEY_SIZE];
-	unsigned char iv[IV_SIZE];
+	unsigned char key[MAX_KEY_SIZE];
+	unsigned char iv[MAX_IV_SIZE];
+	unsigned char tag[AEAD_TAG_SIZE];
+	unsigned char rekey_keys[REKEY_KEYS][MAX_KEY_SIZE]; // Drawn in openssl_set_cipher() for openssl_rekey()
+	size_t next_key;
 	EVP_CIPHER_CTX *ctx_encrypt;
+	const OpenSSLCipher *cipher;
 	const EVP_CIPHER *current_cipher;
+	bool finalize;
+	bool prefetch;
+	bool keyed; // ctx_encrypt holds the current key, sectors only set their tweak
+	bool key_once; // Set by openssl_rekey(), messages only set their IV until the next cipher
+	OSSL_LIB_CTX *libctx;
+	EVP_CIPHER *fetched_cipher;
+	const OpenSSLDigest *digest;
+	EVP_MD_CTX *ctx_digest;
+	const EVP_MD *current_md;
+	EVP_MD *fetched_md;
+	EVP_MAC_CTX *ctx_mac;
+	unsigned char mac_key[MAX_MAC_KEY_SIZE];
+	OpenSSLPK *pk;
+	EVP_RAND_CTX *rng; // Own DRBG, NULL for the thread-local DRBGs of RAND_bytes()
 } OpenSSLParam;
+
+bool openssl_free(void *param);
+
+/* public-key operations implemented in openssl_pk.c */
+const char **openssl_pk_operations();
+bool openssl_set_pk_operation(void *param, const char *operation);
+bool openssl_pk_run(void *param);
+void openssl_pk_free(OpenSSLPK *pk);
@@ -0,0 +1,254 @@
+#include "openssl.h"
+
+#define PK_MESSAGE "CBOS public-key benchmark message"
+#define PK_MESSAGE_SIZE (sizeof(PK_MESSAGE) - 1)
+#define PK_MAX_SIZE 512
+
+typedef enum OpenSSLPKType
+{
+	PK_DERIVE,
+	PK_SIGN,
+	PK_VERIFY,
+	PK_DECRYPT
+} OpenSSLPKType;
+
+/**
+ * Entry of the public-key operation table.
+ */
+typedef struct OpenSSLPKOperation
+{
+	const char *name;
+	const char *key_type; // Key type for EVP_PKEY_Q_keygen()
+	const char *curve;	  // Curve of EC keys, otherwise NULL
+	size_t bits;		  // Size of RSA keys, otherwise 0
+	const char *md;		  // Digest of signatures, NULL for EdDSA
+	OpenSSLPKType type;
+} OpenSSLPKOperation;
+
+/**
+ * Keys and inputs of the current public-key operation, generated outside of
+ * the timed region.
+ */
+struct OpenSSLPK
+{
+	const OpenSSLPKOperation *operation;
+	EVP_PKEY *key;
+	EVP_PKEY *peer;
+	EVP_PKEY_CTX *ctx;
+	EVP_MD_CTX *md_ctx;
+	unsigned char input[PK_MAX_SIZE];
+	size_t input_size;
+	unsigned char output[PK_MAX_SIZE];
+};
+
+static const OpenSSLPKOperation openssl_pk_table[] = {
+	{"X25519", "X25519", NULL, 0, NULL, PK_DERIVE},
+	{"ECDH-P256", "EC", "P-256", 0, NULL, PK_DERIVE},
+	{"ECDSA-P256-sign", "EC", "P-256", 0, "SHA256", PK_SIGN},
+	{"ECDSA-P256-verify", "EC", "P-256", 0, "SHA256", PK_VERIFY},
+	{"Ed25519-sign", "ED25519", NULL, 0, NULL, PK_SIGN},
+	{"Ed25519-verify", "ED25519", NULL, 0, NULL, PK_VERIFY},
+	{"RSA-2048-sign", "RSA", NULL, 2048, "SHA256", PK_SIGN},
+	{"RSA-2048-verify", "RSA", NULL, 2048, "SHA256", PK_VERIFY},
+	{"RSA-2048-decrypt", "RSA", NULL, 2048, NULL, PK_DECRYPT},
+	{"RSA-3072-sign", "RSA", NULL, 3072, "SHA256", PK_SIGN},
+	{"RSA-3072-verify", "RSA", NULL, 3072, "SHA256", PK_VERIFY},
+	{"RSA-3072-decrypt", "RSA", NULL, 3072, NULL, PK_DECRYPT},
+};
+
+#define OPENSSL_PK_COUNT (sizeof(openssl_pk_table) / sizeof(openssl_pk_table[0]))
+
+/**
+ * Get a list of public-key operations supported by the OpenSSL library.
+ * @return An array of operation names as strings, with a NULL-terminated sentinel.
+ */
+const char **openssl_pk_operations()
+{
+	static const char *names[OPENSSL_PK_COUNT + 1];
+
+	if (!names[0])
+	{
+		for (size_t i = 0; i < OPENSSL_PK_COUNT; ++i)
+		{
+			names[i] = openssl_pk_table[i].name;
+		}
+	}
+
+	return names;
+}
+
+/**
+ * Free the keys and contexts of the current public-key operation.
+ * @param pk The public-key state, may be NULL.
+ */
+void openssl_pk_free(OpenSSLPK *pk)
+{
+	if (!pk)
+	{
+		return;
+	}
+
+	EVP_PKEY_free(pk->key);
+	EVP_PKEY_free(pk->peer);
+	EVP_PKEY_CTX_free(pk->ctx);
+	EVP_MD_CTX_free(pk->md_ctx);
+	free(pk);
+}
+
+/**
+ * Generate a key of the type needed by an operation.
+ * @param op The OpenSSL context with the library context to use.
+ * @param operation The operation.
+ * @return The key or NULL on error.
+ */
+static EVP_PKEY *openssl_pk_keygen(OpenSSLParam *op, const OpenSSLPKOperation *operation)
+{
+	if (operation->curve)
+	{
+		return EVP_PKEY_Q_keygen(op->libctx, OPENSSL_PROPQ, operation->key_type, operation->curve);
+	}
+	else if (operation->bits)
+	{
+		return EVP_PKEY_Q_keygen(op->libctx, OPENSSL_PROPQ, operation->key_type, operation->bits);
+	}
+
+	return EVP_PKEY_Q_keygen(op->libctx, OPENSSL_PROPQ, operation->key_type);
+}
+
+/**
+ * Sign the benchmark message with the key of the operation.
+ * @param op The OpenSSL context.
+ * @param pk The public-key state.
+ * @param sig Destination of the signature, PK_MAX_SIZE bytes.
+ * @param sig_size Output for the size of the signature.
+ * @return True on success, otherwise false.
+ */
+static bool openssl_pk_sign(OpenSSLParam *op, OpenSSLPK *pk, unsigned char *sig, size_t *sig_size)
+{
+	*sig_size = PK_MAX_SIZE;
+
+	return EVP_DigestSignInit_ex(pk->md_ctx, NULL, pk->operation->md, op->libctx, OPENSSL_PROPQ, pk->key, NULL) &&
+		   EVP_DigestSign(pk->md_ctx, sig, sig_size, (const unsigned char *)PK_MESSAGE, PK_MESSAGE_SIZE);
+}
+
+/**
+ * Select OAEP padding with SHA-256 for the label and MGF1, like Botan's
+ * OAEP(SHA-256); OpenSSL would default to SHA-1.
+ * @param ctx The context of an encryption or decryption.
+ * @return True on success, otherwise false.
+ */
+static bool openssl_pk_set_oaep(EVP_PKEY_CTX *ctx)
+{
+	return EVP_PKEY_CTX_set_rsa_padding(ctx, RSA_PKCS1_OAEP_PADDING) > 0 &&
+		   EVP_PKEY_CTX_set_rsa_oaep_md(ctx, EVP_sha256()) > 0 && EVP_PKEY_CTX_set_rsa_mgf1_md(ctx, EVP_sha256()) > 0;
+}
+
+/**
+ * Generate the keys and inputs of a public-key operation. For verification a
+ * signature and for decryption an OAEP ciphertext are prepared, so the timed
+ * region only contains the operation itself.
+ * @param param A pointer to the cryptographic context.
+ * @param operation The name of the operation.
+ * @return True if the operation is successfully set, otherwise false.
+ */
+bool openssl_set_pk_operation(void *param, const char *operation)
+{
+	if (!param || !operation)
+	{
+		return false;
+	}
+
+	OpenSSLParam *op = param;
+	const OpenSSLPKOperation *entry = NULL;
+
+	for (size_t i = 0; i < OPENSSL_PK_COUNT && !entry; ++i)
+	{
+		if (strcmp(openssl_pk_table[i].name, operation) == 0)
+		{
+			entry = &openssl_pk_table[i];
+		}
+	}
+
+	if (!entry)
+	{
+		printf("openssl_set_pk_operation(): \"%s\" is not a recognized operation!\n", operation);
+		return false;
+	}
+
+	openssl_pk_free(op->pk);
+	op->pk = calloc(1, sizeof(OpenSSLPK));
+	if (!op->pk)
+	{
+		return false;
+	}
+
+	OpenSSLPK *pk = op->pk;
+	pk->operation = entry;
+	pk->md_ctx = EVP_MD_CTX_new();
+	pk->key = openssl_pk_keygen(op, entry);
+
+	if (!pk->md_ctx || !pk->key)
+	{
+		printf("openssl_set_pk_operation(): generating a %s key failed with error: %s\n", entry->key_type, openssl_error());
+		return false;
+	}
+
+	bool ok = true;
+
+	switch (entry->type)
+	{
+	case PK_DERIVE:
+		pk->peer = openssl_pk_keygen(op, entry);
+		pk->ctx = EVP_PKEY_CTX_new_from_pkey(op->libctx, pk->key, OPENSSL_PROPQ);
+		ok = pk->peer && pk->ctx && EVP_PKEY_derive_init(pk->ctx) > 0 && EVP_PKEY_derive_set_peer(pk->ctx, pk->peer) > 0;
+		break;
+	case PK_SIGN:
+		break;
+	case PK_VERIFY:
+		ok = openssl_pk_sign(op, pk, pk->input, &pk->input_size);
+		break;
+	case PK_DECRYPT:
+		pk->ctx = EVP_PKEY_CTX_new_from_pkey(op->libctx, pk->key, OPENSSL_PROPQ);
+		pk->input_size = PK_MAX_SIZE;
+		ok = pk->ctx && EVP_PKEY_encrypt_init(pk->ctx) > 0 &&
+			 openssl_pk_set_oaep(pk->ctx) &&
+			 EVP_PKEY_encrypt(pk->ctx, pk->input, &pk->input_size, (const unsigned char *)PK_MESSAGE, PK_MESSAGE_SIZE) > 0 &&
+			 EVP_PKEY_decrypt_init(pk->ctx) > 0 &&
+			 openssl_pk_set_oaep(pk->ctx);
+		break;
+	}
+
+	if (!ok)
+	{
+		printf("openssl_set_pk_operation(): preparing %s failed with error: %s\n", operation, openssl_error());
+	}
+
+	return ok;
+}
+
+/**
+ * Perform the current public-key operation once.
+ * @param param A pointer to the cryptographic context.
+ * @return True on success, otherwise false.
+ */
+bool openssl_pk_run(void *param)
+{
+	OpenSSLParam *op = param;
+	OpenSSLPK *pk = op->pk;
+	size_t size = PK_MAX_SIZE;
+
+	switch (pk->operation->type)
+	{
+	case PK_DERIVE:
+		return EVP_PKEY_derive(pk->ctx, pk->output, &size) > 0;
+	case PK_SIGN:
+		return openssl_pk_sign(op, pk, pk->output, &size);
+	case PK_VERIFY:
+		return EVP_DigestVerifyInit_ex(pk->md_ctx, NULL, pk->operation->md, op->libctx, OPENSSL_PROPQ, pk->key, NULL) &&
+			   EVP_DigestVerify(pk->md_ctx, pk->input, pk->input_size, (const unsigned char *)PK_MESSAGE, PK_MESSAGE_SIZE) == 1;
+	case PK_DECRYPT:
+		return EVP_PKEY_decrypt(pk->ctx, pk->output, &size, pk->input, pk->input_size) > 0;
+	}
+
+	return false;
+}
@@ -1,15 +1,5 @@
 #include "template.h"
 
-int get_message_size()
-{
-	return MESSAGE_SIZE;
-}
-
-int get_iterations()
-{
-	return ITERATIONS;
-}
-
 const char *mylib_get_name()
 {
 	return "MY Crypto Library";
@@ -38,7 +28,8 @@ bool mylib_free(void *param)
 
 bool mylib_random(void *param, const size_t size, void *data)
 {
-	// here you can use the random_bytes(data, size) function from cbos.h
+	// replace random_bytes() from cbos.h with your library's generator if it has one
+	random_bytes(data, size);
 	return true;
 }
 
@@ -50,11 +41,12 @@ bool mylib_set_cipher(void *param, const char *cipher)
 
 size_t mylib_encrypt(void *param, const size_t size, void *dst, const void *src)
 {
-	// call the encryption method in your library
+	// call the encryption method in your library and return the size of the ciphertext
+	printf("Error: mylib_encrypt() is not implemented, call your library's encryption here!\n");
 	return 0;
 }
 
-const Crypto *get_lib()
+const Crypto *mylib_get()
 {
 	static const Crypto crypto = {
 		mylib_get_name,
@@ -68,3 +60,5 @@ const Crypto *get_lib()
 
 	return &crypto;
 }
+
+CBOS_REGISTER_LIB(mylib_get)
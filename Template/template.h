@@ -7,8 +7,14 @@
 #define KEY_SIZE 32
 #define IV_SIZE 32
 
+// get_message_size() and get_iterations() of utils.c return the same values of the compiler flags
+#ifndef MESSAGE_SIZE
 #define MESSAGE_SIZE 4096
+#endif
+
+#ifndef ITERATIONS
 #define ITERATIONS 1000000
+#endif
 
 #include "../src/cbos.h" 
 
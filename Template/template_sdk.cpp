@@ -0,0 +1,119 @@
+#include "../src/backend.h"
+
+/*
+ * Example backend made with the C++ SDK of backend.h. It works out of the box
+ * with a portable ChaCha20 (RFC 8439) standing in for your library: replace
+ * the State, the key schedule and the kernel with calls to your library and
+ * list your ciphers in the table. The SDK generates batch loops, pooled
+ * contexts for every thread, rekeying, known-answer tests and decryption.
+ */
+struct MyLibSDK
+{
+	static constexpr const char *name = "MY Crypto Library SDK";
+
+	/**
+	 * Everything a context of your library needs, e.g. the expanded key
+	 */
+	struct State
+	{
+		uint32_t key[8];
+	};
+
+	static const cbos::Cipher<MyLibSDK> ciphers[];
+
+	static bool key_chacha20(cbos::Context<MyLibSDK> &context);
+	static size_t encrypt_chacha20(cbos::Context<MyLibSDK> &context, size_t size, uint8_t *dst, const uint8_t *src);
+};
+
+// Name, key size and IV size of every cipher, the OpenSSL spelling lets CBOS verify it
+const cbos::Cipher<MyLibSDK> MyLibSDK::ciphers[] = {
+	cbos::cipher<MyLibSDK, MyLibSDK::key_chacha20, MyLibSDK::encrypt_chacha20, MyLibSDK::encrypt_chacha20>(
+		"ChaCha20", 32, 16),
+};
+
+/**
+ * Load a little-endian word.
+ * @param bytes Four bytes.
+ * @return The word.
+ */
+static inline uint32_t load32(const uint8_t *bytes)
+{
+	return bytes[0] | (uint32_t)bytes[1] << 8 | (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+}
+
+/**
+ * Key schedule: ChaCha20 only loads the key into the state.
+ * @param context The context with the key of the cipher.
+ * @return True on success, otherwise false.
+ */
+bool MyLibSDK::key_chacha20(cbos::Context<MyLibSDK> &context)
+{
+	for (int i = 0; i < 8; ++i)
+	{
+		context.state.key[i] = load32(context.key + 4 * i);
+	}
+
+	return true;
+}
+
+#define ROTL(x, n) ((x) << (n) | (x) >> (32 - (n)))
+#define QUARTER_ROUND(a, b, c, d)                                                                                   \
+	a += b, d = ROTL(d ^ a, 16), c += d, b = ROTL(b ^ c, 12), a += b, d = ROTL(d ^ a, 8), c += d, b = ROTL(b ^ c, 7)
+
+/**
+ * Encrypt one message. The IV is the little-endian block counter followed by
+ * the nonce, like in OpenSSL; encryption and decryption are the same.
+ * @param context The context with the key schedule and IV.
+ * @param size The size of the message.
+ * @param dst A pointer to the destination buffer for the encrypted data.
+ * @param src A pointer to the source data to be encrypted.
+ * @return The size of the encrypted data.
+ */
+size_t MyLibSDK::encrypt_chacha20(cbos::Context<MyLibSDK> &context, size_t size, uint8_t *dst, const uint8_t *src)
+{
+	uint32_t input[16] = {0x61707865, 0x3320646e, 0x79622d32, 0x6b206574};
+	uint8_t stream[64];
+
+	std::memcpy(input + 4, context.state.key, sizeof(context.state.key));
+	for (int i = 0; i < 4; ++i)
+	{
+		input[12 + i] = load32(context.iv + 4 * i);
+	}
+
+	for (size_t offset = 0; offset < size; offset += 64, ++input[12])
+	{
+		uint32_t x[16];
+		std::memcpy(x, input, sizeof(x));
+
+		for (int round = 0; round < 10; ++round)
+		{
+			QUARTER_ROUND(x[0], x[4], x[8], x[12]);
+			QUARTER_ROUND(x[1], x[5], x[9], x[13]);
+			QUARTER_ROUND(x[2], x[6], x[10], x[14]);
+			QUARTER_ROUND(x[3], x[7], x[11], x[15]);
+			QUARTER_ROUND(x[0], x[5], x[10], x[15]);
+			QUARTER_ROUND(x[1], x[6], x[11], x[12]);
+			QUARTER_ROUND(x[2], x[7], x[8], x[13]);
+			QUARTER_ROUND(x[3], x[4], x[9], x[14]);
+		}
+
+		for (int i = 0; i < 16; ++i)
+		{
+			const uint32_t word = x[i] + input[i];
+			stream[4 * i] = (uint8_t)word;
+			stream[4 * i + 1] = (uint8_t)(word >> 8);
+			stream[4 * i + 2] = (uint8_t)(word >> 16);
+			stream[4 * i + 3] = (uint8_t)(word >> 24);
+		}
+
+		const size_t block = size - offset < 64 ? size - offset : 64;
+		for (size_t i = 0; i < block; ++i)
+		{
+			dst[offset + i] = src[offset + i] ^ stream[i];
+		}
+	}
+
+	return size;
+}
+
+CBOS_REGISTER_BACKEND(MyLibSDK, mylib_sdk_get)
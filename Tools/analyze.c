@@ -0,0 +1,392 @@
+#include <fcntl.h>
+#include <math.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "capture.h"
+
+/*
+ * Offline analysis of the raw sample files written by `cbos capture`. It
+ * prints percentiles and outliers of every series, optionally histograms,
+ * and compares the series of two files without re-running the benchmark.
+ */
+
+/**
+ * Mapped raw sample file
+ */
+typedef struct SampleFile
+{
+	const CaptureHeader *header;
+	const CaptureRecord *records;
+	size_t size;
+} SampleFile;
+
+/**
+ * Samples of one series, sorted by cycles
+ */
+typedef struct SeriesSamples
+{
+	const CaptureSeries *name;
+	uint32_t *cycles;
+	size_t count;
+	uint32_t size;	   // Bytes per call of the first record
+	double extreme;	   // Upper fence of extreme outliers
+	size_t bursts;	   // Extreme outliers right after another one
+	bool last_extreme; // The previous sample was an extreme outlier
+} SeriesSamples;
+
+/**
+ * Maps a raw sample file and checks its layout.
+ *
+ * @param file The file to open.
+ * @param path Path of the file.
+ * @return True on success, otherwise false.
+ */
+static bool file_open(SampleFile *file, const char *path)
+{
+	struct stat st;
+	const int fd = open(path, O_RDONLY);
+
+	if (fd < 0 || fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(CaptureHeader))
+	{
+		printf("Error: cannot read %s\n", path);
+		if (fd >= 0)
+			close(fd);
+		return false;
+	}
+
+	void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+	{
+		printf("Error: cannot map %s\n", path);
+		return false;
+	}
+
+	file->header = map;
+	file->size = st.st_size;
+
+	const CaptureHeader *header = file->header;
+	if (memcmp(header->magic, CAPTURE_MAGIC, sizeof(header->magic)) != 0 || header->record_size != sizeof(CaptureRecord) ||
+		header->series_count > CAPTURE_MAX_SERIES ||
+		header->records_offset + header->count * sizeof(CaptureRecord) > file->size)
+	{
+		printf("Error: %s is no raw sample file of this version\n", path);
+		munmap(map, st.st_size);
+		return false;
+	}
+
+	file->records = (const CaptureRecord *)((const uint8_t *)map + header->records_offset);
+	return true;
+}
+
+/**
+ * Compares cycles for qsort().
+ */
+static int compare_cycles(const void *a, const void *b)
+{
+	const uint32_t x = *(const uint32_t *)a;
+	const uint32_t y = *(const uint32_t *)b;
+	return (x > y) - (x < y);
+}
+
+/**
+ * Returns a nearest-rank percentile of sorted cycles.
+ */
+static uint32_t cycles_percentile(const uint32_t *sorted, size_t count, double p)
+{
+	if (count == 0)
+	{
+		return 0;
+	}
+
+	size_t rank = (size_t)ceil(p / 100.0 * count);
+	return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+/**
+ * Splits the records of a file into sorted series and counts the bursts of
+ * extreme outliers.
+ *
+ * @param file The mapped file.
+ * @param series Output for header->series_count series.
+ * @return True on success, false if memory allocation failed.
+ */
+static bool load_series(const SampleFile *file, SeriesSamples *series)
+{
+	const CaptureHeader *header = file->header;
+	size_t filled[CAPTURE_MAX_SERIES] = {0};
+
+	for (uint32_t s = 0; s < header->series_count; ++s)
+	{
+		series[s] = (SeriesSamples){&header->series[s], NULL, 0, 0, 0.0, 0, false};
+	}
+
+	for (uint64_t i = 0; i < header->count; ++i)
+	{
+		if (file->records[i].series < header->series_count)
+			++series[file->records[i].series].count;
+	}
+
+	for (uint32_t s = 0; s < header->series_count; ++s)
+	{
+		series[s].cycles = malloc((series[s].count ? series[s].count : 1) * sizeof(uint32_t));
+		if (!series[s].cycles)
+		{
+			printf("Error: failed to allocate %zu samples!\n", series[s].count);
+			return false;
+		}
+	}
+
+	for (uint64_t i = 0; i < header->count; ++i)
+	{
+		const CaptureRecord *record = &file->records[i];
+		if (record->series >= header->series_count)
+			continue;
+
+		SeriesSamples *target = &series[record->series];
+		if (filled[record->series] == 0)
+			target->size = record->size;
+		target->cycles[filled[record->series]++] = record->cycles;
+	}
+
+	for (uint32_t s = 0; s < header->series_count; ++s)
+	{
+		qsort(series[s].cycles, series[s].count, sizeof(uint32_t), compare_cycles);
+
+		const double q1 = cycles_percentile(series[s].cycles, series[s].count, 25);
+		const double q3 = cycles_percentile(series[s].cycles, series[s].count, 75);
+		series[s].extreme = q3 + 3.0 * (q3 - q1);
+	}
+
+	// Records are in time order, so one pass finds the bursts of all series
+	for (uint64_t i = 0; i < header->count; ++i)
+	{
+		const CaptureRecord *record = &file->records[i];
+		if (record->series >= header->series_count)
+			continue;
+
+		SeriesSamples *target = &series[record->series];
+		const bool extreme = record->cycles > target->extreme;
+		if (extreme && target->last_extreme)
+			++target->bursts;
+		target->last_extreme = extreme;
+	}
+
+	return true;
+}
+
+/**
+ * Prints percentiles and outliers of a series. Outliers lie outside Tukey's
+ * fences of 1.5 (mild) and 3 (extreme) interquartile ranges. Extreme ones
+ * that directly follow another one are counted as bursts, a slowdown lasting
+ * several calls such as preemption or a frequency change; isolated ones are
+ * typical of a single interrupt.
+ *
+ * @param samples The sorted samples of the series.
+ */
+static void print_series(const SeriesSamples *samples)
+{
+	const uint32_t *sorted = samples->cycles;
+	const size_t count = samples->count;
+
+	if (count == 0)
+	{
+		return;
+	}
+
+	const double q1 = cycles_percentile(sorted, count, 25);
+	const double q3 = cycles_percentile(sorted, count, 75);
+	const double mild = q3 + 1.5 * (q3 - q1);
+	const double extreme = samples->extreme;
+	const double low = q1 - 1.5 * (q3 - q1);
+	const uint32_t median = cycles_percentile(sorted, count, 50);
+
+	double sum = 0.0;
+	size_t mild_count = 0, extreme_count = 0, low_count = 0;
+	for (size_t i = 0; i < count; ++i)
+	{
+		sum += sorted[i];
+		if (sorted[i] > extreme)
+			++extreme_count;
+		else if (sorted[i] > mild)
+			++mild_count;
+		else if (sorted[i] < low)
+			++low_count;
+	}
+
+	printf("%s / %s: %zu samples, %u bytes, %.4f bytes/cycle at the median\n", samples->name->library,
+		   samples->name->algorithm, count, samples->size, median ? (double)samples->size / median : 0.0);
+	printf("  cycles: min %u, p50 %u, p90 %u, p99 %u, p99.9 %u, max %u, mean %.1f\n", sorted[0], median,
+		   cycles_percentile(sorted, count, 90), cycles_percentile(sorted, count, 99),
+		   cycles_percentile(sorted, count, 99.9), sorted[count - 1], sum / count);
+	printf("  outliers: %zu mild (> %.0f), %zu extreme (> %.0f, %zu in bursts, %zu isolated), %zu low (< %.0f)\n",
+		   mild_count, mild, extreme_count, extreme, samples->bursts, extreme_count - samples->bursts, low_count, low);
+}
+
+/**
+ * Prints a histogram of a series with linear bins from the minimum to the
+ * 99.9th percentile; slower samples are counted in the last bin.
+ *
+ * @param samples The sorted samples of the series.
+ * @param bins Number of bins.
+ */
+static void print_histogram(const SeriesSamples *samples, int bins)
+{
+	const uint32_t *sorted = samples->cycles;
+	const size_t count = samples->count;
+	size_t counts[bins];
+	size_t highest = 0;
+
+	if (count == 0)
+	{
+		return;
+	}
+
+	const double min = sorted[0];
+	const double max = cycles_percentile(sorted, count, 99.9) + 1.0;
+	const double width = (max - min) / bins;
+
+	memset(counts, 0, sizeof(counts));
+	for (size_t i = 0; i < count; ++i)
+	{
+		int bin = (int)((sorted[i] - min) / width);
+		counts[bin < bins ? bin : bins - 1]++;
+	}
+
+	for (int b = 0; b < bins; ++b)
+	{
+		if (counts[b] > highest)
+			highest = counts[b];
+	}
+
+	for (int b = 0; b < bins; ++b)
+	{
+		const int bar = (int)(50.0 * counts[b] / highest + 0.5);
+		printf("  %10.0f%s %10zu %.*s\n", min + b * width, b == bins - 1 ? "+" : " ", counts[b], bar,
+			   "##################################################");
+	}
+}
+
+/**
+ * Compares a series with the same series of a baseline. The Mann-Whitney U
+ * test tells whether the shift of the medians is more than noise.
+ *
+ * @param samples The sorted samples.
+ * @param baseline The sorted samples of the baseline.
+ */
+static void print_comparison(const SeriesSamples *samples, const SeriesSamples *baseline)
+{
+	const size_t n1 = samples->count, n2 = baseline->count;
+	double rank_sum = 0.0;
+	size_t i = 0, j = 0;
+
+	if (n1 == 0 || n2 == 0)
+	{
+		return;
+	}
+
+	// Ranks of the merged samples, ties share their mean rank
+	while (i < n1 || j < n2)
+	{
+		const uint32_t value = j >= n2 || (i < n1 && samples->cycles[i] <= baseline->cycles[j]) ? samples->cycles[i]
+																								 : baseline->cycles[j];
+		size_t ties1 = 0, ties2 = 0;
+		while (i + ties1 < n1 && samples->cycles[i + ties1] == value)
+			++ties1;
+		while (j + ties2 < n2 && baseline->cycles[j + ties2] == value)
+			++ties2;
+
+		const double first_rank = i + j + 1.0;
+		const double mean_rank = first_rank + (ties1 + ties2 - 1) / 2.0;
+		rank_sum += ties1 * mean_rank;
+		i += ties1;
+		j += ties2;
+	}
+
+	const double u = rank_sum - n1 * (n1 + 1.0) / 2.0;
+	const double z = (u - n1 * (double)n2 / 2.0) / sqrt(n1 * (double)n2 * (n1 + n2 + 1.0) / 12.0);
+
+	const double median = cycles_percentile(samples->cycles, n1, 50);
+	const double base_median = cycles_percentile(baseline->cycles, n2, 50);
+	const double p99 = cycles_percentile(samples->cycles, n1, 99);
+	const double base_p99 = cycles_percentile(baseline->cycles, n2, 99);
+
+	printf("  vs baseline: median %+.2f%%, p99 %+.2f%%, Mann-Whitney z %.1f (%s)\n",
+		   100.0 * (median - base_median) / base_median, 100.0 * (p99 - base_p99) / base_p99, z,
+		   fabs(z) > 3.29 ? "significant at p < 0.001" : "not significant");
+}
+
+/**
+ * Prints the usage.
+ */
+static void usage(const char *program)
+{
+	printf("Usage: %s [-h bins] file [baseline]\n", program);
+	printf("  -h bins   print a histogram of every series\n");
+	printf("  baseline  compare every series with the same series of another file\n");
+}
+
+int main(int argc, char **argv)
+{
+	int bins = 0;
+	int arg = 1;
+
+	if (arg + 1 < argc && strcmp(argv[arg], "-h") == 0)
+	{
+		bins = atoi(argv[arg + 1]);
+		arg += 2;
+	}
+
+	if (arg >= argc || bins < 0)
+	{
+		usage(argv[0]);
+		return 1;
+	}
+
+	SampleFile file, base_file;
+	SeriesSamples series[CAPTURE_MAX_SERIES];
+	SeriesSamples base_series[CAPTURE_MAX_SERIES];
+	const bool compare = arg + 1 < argc;
+
+	if (!file_open(&file, argv[arg]) || !load_series(&file, series))
+	{
+		return 1;
+	}
+
+	if (compare && (!file_open(&base_file, argv[arg + 1]) || !load_series(&base_file, base_series)))
+	{
+		return 1;
+	}
+
+	printf("%s: %llu samples in %u series", argv[arg], (unsigned long long)file.header->count,
+		   file.header->series_count);
+	if (file.header->dropped)
+		printf(", %llu dropped while capturing", (unsigned long long)file.header->dropped);
+	printf("\n\n");
+
+	for (uint32_t s = 0; s < file.header->series_count; ++s)
+	{
+		print_series(&series[s]);
+
+		if (bins > 0)
+			print_histogram(&series[s], bins);
+
+		for (uint32_t b = 0; compare && b < base_file.header->series_count; ++b)
+		{
+			if (strcmp(series[s].name->library, base_series[b].name->library) == 0 &&
+				strcmp(series[s].name->algorithm, base_series[b].name->algorithm) == 0)
+				print_comparison(&series[s], &base_series[b]);
+		}
+	}
+
+	for (uint32_t s = 0; s < file.header->series_count; ++s)
+		free(series[s].cycles);
+	for (uint32_t s = 0; compare && s < base_file.header->series_count; ++s)
+		free(base_series[s].cycles);
+	munmap((void *)file.header, file.size);
+	if (compare)
+		munmap((void *)base_file.header, base_file.size);
+
+	return 0;
+}
@@ -0,0 +1,192 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <malloc.h>
+#include <stdint.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "alloc.h"
+
+/*
+ * The executable defines the allocation functions, so the dynamic linker
+ * binds the calls of the libraries to them as well. They forward to the glibc
+ * implementations, which stay reachable under their __libc_ names.
+ */
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void *__libc_memalign(size_t alignment, size_t size);
+extern void __libc_free(void *ptr);
+
+static __thread bool tracking;
+static __thread AllocStats stats;
+
+/**
+ * Counts an allocated block.
+ *
+ * @param ptr The block, NULL if the allocation failed.
+ */
+static inline void count_allocation(void *ptr)
+{
+	if (tracking && ptr)
+	{
+		const size_t size = malloc_usable_size(ptr);
+		++stats.allocations;
+		stats.allocated_bytes += size;
+		stats.live_bytes += size;
+	}
+}
+
+/**
+ * Counts a block that is about to be freed.
+ *
+ * @param ptr The block, may be NULL.
+ */
+static inline void count_free(void *ptr)
+{
+	if (tracking && ptr)
+	{
+		++stats.frees;
+		stats.live_bytes -= malloc_usable_size(ptr);
+	}
+}
+
+void *malloc(size_t size)
+{
+	void *ptr = __libc_malloc(size);
+	count_allocation(ptr);
+	return ptr;
+}
+
+void *calloc(size_t count, size_t size)
+{
+	void *ptr = __libc_calloc(count, size);
+	count_allocation(ptr);
+	return ptr;
+}
+
+void *realloc(void *ptr, size_t size)
+{
+	count_free(ptr);
+	void *result = __libc_realloc(ptr, size);
+	count_allocation(result);
+	return result;
+}
+
+void *memalign(size_t alignment, size_t size)
+{
+	void *ptr = __libc_memalign(alignment, size);
+	count_allocation(ptr);
+	return ptr;
+}
+
+void *aligned_alloc(size_t alignment, size_t size)
+{
+	return memalign(alignment, size);
+}
+
+int posix_memalign(void **ptr, size_t alignment, size_t size)
+{
+	if (alignment < sizeof(void *) || (alignment & (alignment - 1)) != 0)
+	{
+		return EINVAL;
+	}
+
+	void *result = memalign(alignment, size);
+	if (!result)
+	{
+		return ENOMEM;
+	}
+
+	*ptr = result;
+	return 0;
+}
+
+void *valloc(size_t size)
+{
+	return memalign((size_t)sysconf(_SC_PAGESIZE), size);
+}
+
+void *pvalloc(size_t size)
+{
+	const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+
+	// Rounded up to whole pages, at least one
+	if (size > SIZE_MAX - page)
+	{
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	return memalign(page, size ? (size + page - 1) & ~(page - 1) : page);
+}
+
+void free(void *ptr)
+{
+	count_free(ptr);
+	__libc_free(ptr);
+}
+
+/**
+ * Enable or disable counting the heap usage of the calling thread.
+ *
+ * @param enable True to count, false to stop counting.
+ */
+void alloc_tracking(bool enable)
+{
+	tracking = enable;
+}
+
+/**
+ * @return The heap usage of the calling thread counted so far.
+ */
+AllocStats alloc_stats(void)
+{
+	return stats;
+}
+
+/**
+ * Reset the high-water mark of the resident set size (Linux 4.0 and later).
+ *
+ * @return True on success, false otherwise.
+ */
+bool reset_peak_rss(void)
+{
+	FILE *file = fopen("/proc/self/clear_refs", "w");
+
+	if (!file)
+	{
+		return false;
+	}
+
+	const bool ok = fputs("5", file) >= 0;
+	return fclose(file) == 0 && ok;
+}
+
+/**
+ * @return Peak resident set size of the process in KiB since the last reset,
+ * 0 on error.
+ */
+long peak_rss_kib(void)
+{
+	FILE *file = fopen("/proc/self/status", "r");
+	char line[128];
+	long peak = -1;
+
+	while (file && peak < 0 && fgets(line, sizeof(line), file))
+	{
+		if (sscanf(line, "VmHWM: %ld kB", &peak) != 1)
+			peak = -1;
+	}
+	if (file)
+		fclose(file);
+
+	// getrusage() only knows the peak since the start of the process
+	struct rusage usage;
+	if (peak < 0 && getrusage(RUSAGE_SELF, &usage) == 0)
+	{
+		peak = usage.ru_maxrss;
+	}
+
+	return peak > 0 ? peak : 0;
+}
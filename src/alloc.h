@@ -0,0 +1,47 @@
+#pragma once
+
+#include "cbos.h"
+
+/**
+ * Heap usage counted by the interposed malloc(), calloc(), realloc(), the
+ * aligned allocations and free() of one thread while tracking is enabled
+ */
+typedef struct AllocStats
+{
+	size_t allocations;		// malloc, calloc, realloc and aligned allocations
+	size_t frees;			// free and realloc of a previous block
+	size_t allocated_bytes; // Usable size of every allocated block
+	long long live_bytes;	// Allocated minus freed bytes
+} AllocStats;
+
+/**
+ * @brief Enables or disables counting the heap usage of the calling thread.
+ * Disabled tracking costs one thread-local load per allocation.
+ *
+ * @param enable True to count, false to stop counting.
+ */
+void alloc_tracking(bool enable);
+
+/**
+ * @brief Returns the counters of the calling thread, which only grow, so a
+ * region is measured by the difference of two snapshots.
+ *
+ * @return The heap usage counted so far.
+ */
+AllocStats alloc_stats(void);
+
+/**
+ * @brief Resets the peak resident set size of the process to its current
+ * resident set size, so peak_rss_kib() measures from now on.
+ *
+ * @return True on success, false if the kernel does not support it.
+ */
+bool reset_peak_rss(void);
+
+/**
+ * @brief Returns the peak resident set size of the process since the last
+ * reset_peak_rss(), or since its start if it was never reset.
+ *
+ * @return Peak RSS in KiB.
+ */
+long peak_rss_kib(void);
@@ -0,0 +1,513 @@
+#pragma once
+
+#ifndef __cplusplus
+#error "backend.h is the C++ backend SDK, include it from a .cpp file"
+#endif
+
+#include "cbos.h"
+
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+// Contexts of every backend that stay allocated for init() to reuse, e.g. one per thread
+#ifndef CBOS_BACKEND_POOL
+#define CBOS_BACKEND_POOL 64
+#endif
+
+// Largest key and IV of a cipher table
+#define CBOS_BACKEND_MAX_KEY 64
+#define CBOS_BACKEND_MAX_IV 16
+
+/*
+ * C++ SDK for backends. A library describes its ciphers in a table and
+ * implements one key schedule and one encryption kernel per cipher:
+ *
+ *   struct MyLib
+ *   {
+ *       static constexpr const char *name = "MyLib";
+ *       struct State { ... };     // Expanded keys and handles of the library
+ *       static const cbos::Cipher<MyLib> ciphers[];
+ *       static bool key_ctr(cbos::Context<MyLib> &context);
+ *       static size_t encrypt_ctr(cbos::Context<MyLib> &context, size_t size, uint8_t *dst, const uint8_t *src);
+ *   };
+ *
+ *   const cbos::Cipher<MyLib> MyLib::ciphers[] = {
+ *       cbos::cipher<MyLib, MyLib::key_ctr, MyLib::encrypt_ctr>("AES-128-CTR", 16, 16),
+ *   };
+ *
+ *   CBOS_REGISTER_BACKEND(MyLib, mylib_get)
+ *
+ * cbos::Backend<MyLib> generates every hook of the Crypto struct from it.
+ */
+namespace cbos
+{
+
+template <typename Library> struct Cipher;
+
+/**
+ * Context of one user of a backend, e.g. one thread. Contexts are taken from
+ * a pool allocated once, so init() does not allocate after the first use.
+ */
+template <typename Library> struct Context
+{
+	const Cipher<Library> *cipher = nullptr;
+	typename Library::State state{}; // Kept when the context returns to the pool
+	uint8_t key[CBOS_BACKEND_MAX_KEY] = {};
+	uint8_t iv[CBOS_BACKEND_MAX_IV] = {};
+	uint8_t rekey_keys[REKEY_KEYS][CBOS_BACKEND_MAX_KEY] = {}; // Drawn in set_cipher() for rekey()
+	size_t next_key = 0;
+	std::vector<uint8_t> buffer; // Scratch space of get_message_size() + MAX_DIGEST_SIZE bytes
+	bool pooled = false;
+	bool used = false;
+};
+
+/**
+ * One entry of the cipher table of a backend. Entries are made with
+ * cbos::cipher(), which binds the kernels at compile time.
+ */
+template <typename Library> struct Cipher
+{
+	const char *name;
+	size_t key_size;
+	size_t iv_size;
+	bool (*set_key)(Context<Library> &context); // Key schedule of context.key
+	size_t (*encrypt)(void *param, const size_t size, void *dst, const void *src);
+	size_t (*encrypt_loop)(void *param, const size_t size, void *dst, const void *src, const size_t iterations);
+	size_t (*decrypt)(void *param, const size_t size, void *dst, const void *src); // NULL without a kernel
+};
+
+/**
+ * Calls a kernel with the context of a Crypto hook. Exceptions of the library
+ * end the call with zero, they cost nothing while none is thrown.
+ */
+template <typename Library, auto Kernel>
+static size_t call_kernel(void *param, const size_t size, void *dst, const void *src)
+{
+	Context<Library> *context = static_cast<Context<Library> *>(param);
+
+	try
+	{
+		return Kernel(*context, size, static_cast<uint8_t *>(dst), static_cast<const uint8_t *>(src));
+	}
+	catch (const std::exception &e)
+	{
+		printf("Error: [%s] %s: %s\n", Library::name, context->cipher->name, e.what());
+		return 0;
+	}
+}
+
+/**
+ * Batch loop of a kernel. The kernel is a template argument, so it is inlined
+ * into the loop like with CBOS_DEFINE_ENCRYPT_LOOP.
+ */
+template <typename Library, auto Kernel>
+static size_t kernel_loop(void *param, const size_t size, void *dst, const void *src, const size_t iterations)
+{
+	Context<Library> *context = static_cast<Context<Library> *>(param);
+
+	try
+	{
+		for (size_t i = 0; i < iterations; ++i)
+		{
+			if (!Kernel(*context, size, static_cast<uint8_t *>(dst), static_cast<const uint8_t *>(src)))
+			{
+				return i;
+			}
+		}
+	}
+	catch (const std::exception &e)
+	{
+		printf("Error: [%s] %s: %s\n", Library::name, context->cipher->name, e.what());
+		return 0;
+	}
+
+	return iterations;
+}
+
+/**
+ * Makes an entry of the cipher table.
+ *
+ * @tparam SetKey `bool set_key(Context &)`, the key schedule of context.key.
+ * @tparam Encrypt `size_t encrypt(Context &, size_t size, uint8_t *dst, const uint8_t *src)`,
+ * one message with context.iv, returns the bytes written or zero on error.
+ * @tparam Decrypt Like Encrypt for the inverse direction, nullptr if there is none.
+ * @param name Name of the cipher, the OpenSSL spelling lets CBOS verify it.
+ * @param key_size Size of the key.
+ * @param iv_size Size of the IV, zero for none.
+ * @return The table entry.
+ */
+template <typename Library, auto SetKey, auto Encrypt, auto Decrypt = nullptr>
+constexpr Cipher<Library> cipher(const char *name, const size_t key_size, const size_t iv_size)
+{
+	size_t (*decrypt)(void *, const size_t, void *, const void *) = nullptr;
+	if constexpr (!std::is_same_v<decltype(Decrypt), std::nullptr_t>)
+	{
+		decrypt = call_kernel<Library, Decrypt>;
+	}
+
+	return Cipher<Library>{name, key_size, iv_size, SetKey, call_kernel<Library, Encrypt>,
+						   kernel_loop<Library, Encrypt>, decrypt};
+}
+
+/**
+ * Generates the Crypto struct of a library from its cipher table. Optional
+ * members of the library:
+ *
+ * + `static bool startup()`, run once before the first context is used,
+ * + `static void release(State &)`, run when a context returns to the pool.
+ */
+template <typename Library> class Backend
+{
+  public:
+	/**
+	 * @return The Crypto struct of the library.
+	 */
+	static const Crypto *crypto()
+	{
+		static const Crypto crypto = {
+			name,
+			ciphers,
+			init,
+			free,
+			random,
+			set_cipher,
+			encrypt,
+			encrypt_loop,
+			nullptr,
+			nullptr,
+			nullptr,
+			nullptr,
+			nullptr,
+			nullptr,
+			nullptr,
+			nullptr,
+			nullptr,
+			nullptr,
+			nullptr,
+			nullptr,
+			rekey,
+			encrypt_sector,
+			set_key,
+			decrypt,
+		};
+
+		return &crypto;
+	}
+
+  private:
+	static constexpr size_t cipher_count = sizeof(Library::ciphers) / sizeof(Library::ciphers[0]);
+
+	/**
+	 * The pool of contexts, guarded by its mutex so threads can init at once.
+	 */
+	struct Pool
+	{
+		std::mutex mutex;
+		Context<Library> contexts[CBOS_BACKEND_POOL];
+	};
+
+	static Pool &pool()
+	{
+		static Pool pool;
+		return pool;
+	}
+
+	static const char *name()
+	{
+		return Library::name;
+	}
+
+	static const char **ciphers()
+	{
+		static const char *names[cipher_count + 1];
+
+		if (!names[0])
+		{
+			for (size_t i = 0; i < cipher_count; ++i)
+			{
+				names[i] = Library::ciphers[i].name;
+			}
+		}
+
+		return names;
+	}
+
+	/**
+	 * Takes a context from the pool, or allocates one if all are in use.
+	 */
+	static bool init(void **param)
+	{
+		static std::once_flag started;
+		static bool startup_ok = true;
+
+		if constexpr (requires { Library::startup(); })
+		{
+			std::call_once(started, [] { startup_ok = Library::startup(); });
+		}
+
+		if (!param || !startup_ok)
+		{
+			return false;
+		}
+
+		Pool &contexts = pool();
+		Context<Library> *context = nullptr;
+
+		{
+			std::lock_guard<std::mutex> lock(contexts.mutex);
+			for (size_t i = 0; !context && i < CBOS_BACKEND_POOL; ++i)
+			{
+				if (!contexts.contexts[i].used)
+				{
+					context = &contexts.contexts[i];
+					context->pooled = true;
+					context->used = true;
+				}
+			}
+		}
+
+		try
+		{
+			if (!context)
+			{
+				context = new Context<Library>();
+				context->used = true;
+			}
+
+			// Only the first user of a pooled context allocates its buffer
+			context->buffer.resize(get_message_size() + MAX_DIGEST_SIZE);
+		}
+		catch (const std::exception &e)
+		{
+			printf("Error: [%s] init(): %s\n", Library::name, e.what());
+			// The hook of this class, which returns a pooled context and deletes any other
+			Backend::free(context);
+			return false;
+		}
+
+		*param = context;
+		return true;
+	}
+
+	/**
+	 * Returns a context to the pool with its key material cleared.
+	 */
+	static bool free(void *param)
+	{
+		Context<Library> *context = static_cast<Context<Library> *>(param);
+
+		if (!context)
+		{
+			return false;
+		}
+
+		if constexpr (requires(typename Library::State &state) { Library::release(state); })
+		{
+			Library::release(context->state);
+		}
+
+		context->cipher = nullptr;
+		std::memset(context->key, 0, sizeof(context->key));
+		std::memset(context->iv, 0, sizeof(context->iv));
+
+		if (!context->pooled)
+		{
+			delete context;
+			return true;
+		}
+
+		std::lock_guard<std::mutex> lock(pool().mutex);
+		context->used = false;
+		return true;
+	}
+
+	static bool random(void *param, const size_t size, void *dst)
+	{
+		random_bytes(static_cast<uint8_t *>(dst), size);
+		return true;
+	}
+
+	/**
+	 * Runs the key schedule of the current cipher, exceptions are errors.
+	 */
+	static bool schedule(Context<Library> *context)
+	{
+		try
+		{
+			return context->cipher->set_key(*context);
+		}
+		catch (const std::exception &e)
+		{
+			printf("Error: [%s] %s: %s\n", Library::name, context->cipher->name, e.what());
+			return false;
+		}
+	}
+
+	/**
+	 * Resolves the name with the cipher table once, the kernels of the entry
+	 * are called without any lookup afterwards. The key, the IV and the keys of
+	 * rekey() are random.
+	 */
+	static bool set_cipher(void *param, const char *cipher)
+	{
+		Context<Library> *context = static_cast<Context<Library> *>(param);
+
+		if (!context || !cipher)
+		{
+			return false;
+		}
+
+		context->cipher = nullptr;
+		for (size_t i = 0; i < cipher_count; ++i)
+		{
+			if (std::strcmp(Library::ciphers[i].name, cipher) == 0)
+			{
+				context->cipher = &Library::ciphers[i];
+			}
+		}
+
+		if (!context->cipher)
+		{
+			printf("Error: [%s] \"%s\" is not in the cipher table!\n", Library::name, cipher);
+			return false;
+		}
+
+		if (context->cipher->key_size > CBOS_BACKEND_MAX_KEY || context->cipher->iv_size > CBOS_BACKEND_MAX_IV)
+		{
+			printf("Error: [%s] %s needs a larger CBOS_BACKEND_MAX_KEY or CBOS_BACKEND_MAX_IV!\n", Library::name,
+				   cipher);
+			context->cipher = nullptr;
+			return false;
+		}
+
+		random_bytes(context->key, context->cipher->key_size);
+		random_bytes(context->iv, context->cipher->iv_size);
+		for (size_t i = 0; i < REKEY_KEYS; ++i)
+		{
+			random_bytes(context->rekey_keys[i], context->cipher->key_size);
+		}
+		context->next_key = 0;
+		return schedule(context);
+	}
+
+	static size_t encrypt(void *param, const size_t size, void *dst, const void *src)
+	{
+		Context<Library> *context = static_cast<Context<Library> *>(param);
+
+		if (!context || !context->cipher || !dst || !src)
+		{
+			return 0;
+		}
+
+		return context->cipher->encrypt(param, size, dst, src);
+	}
+
+	/**
+	 * Selects the loop of the current cipher once per batch.
+	 */
+	static size_t encrypt_loop(void *param, const size_t size, void *dst, const void *src, const size_t iterations)
+	{
+		Context<Library> *context = static_cast<Context<Library> *>(param);
+
+		if (!context || !context->cipher || !dst || !src)
+		{
+			return 0;
+		}
+
+		return context->cipher->encrypt_loop(param, size, dst, src, iterations);
+	}
+
+	static size_t decrypt(void *param, const size_t size, void *dst, const void *src)
+	{
+		Context<Library> *context = static_cast<Context<Library> *>(param);
+
+		if (!context || !context->cipher || !context->cipher->decrypt || !dst || !src)
+		{
+			return 0;
+		}
+
+		return context->cipher->decrypt(param, size, dst, src);
+	}
+
+	static bool rekey(void *param)
+	{
+		Context<Library> *context = static_cast<Context<Library> *>(param);
+
+		if (!context || !context->cipher)
+		{
+			return false;
+		}
+
+		std::memcpy(context->key, context->rekey_keys[context->next_key], context->cipher->key_size);
+		context->next_key = (context->next_key + 1) % REKEY_KEYS;
+		return schedule(context);
+	}
+
+	static bool set_key(void *param, const uint8_t *key, const size_t key_size, const uint8_t *iv,
+						const size_t iv_size)
+	{
+		Context<Library> *context = static_cast<Context<Library> *>(param);
+
+		if (!context || !context->cipher || !key || (iv_size && !iv))
+		{
+			return false;
+		}
+
+		if (key_size != context->cipher->key_size || iv_size != context->cipher->iv_size)
+		{
+			printf("Error: [%s] %s takes a %zu bytes key and %zu bytes IV, not %zu and %zu!\n", Library::name,
+				   context->cipher->name, context->cipher->key_size, context->cipher->iv_size, key_size, iv_size);
+			return false;
+		}
+
+		std::memcpy(context->key, key, key_size);
+		if (iv_size)
+		{
+			std::memcpy(context->iv, iv, iv_size);
+		}
+
+		return schedule(context);
+	}
+
+	/**
+	 * Encrypts one data unit of an XTS cipher with the sector number as the
+	 * tweak, the IV of the kernel.
+	 */
+	static size_t encrypt_sector(void *param, const uint64_t sector, const size_t size, void *dst, const void *src)
+	{
+		Context<Library> *context = static_cast<Context<Library> *>(param);
+
+		if (!context || !context->cipher || !std::strstr(context->cipher->name, "XTS") || !dst || !src)
+		{
+			return 0;
+		}
+
+		std::memset(context->iv, 0, sizeof(context->iv));
+		for (int i = 0; i < 8; ++i)
+		{
+			context->iv[i] = static_cast<uint8_t>(sector >> (8 * i));
+		}
+
+		return context->cipher->encrypt(param, size, dst, src);
+	}
+};
+
+} // namespace cbos
+
+/**
+ * @brief Defines the getter of a backend made with cbos::Backend and
+ * registers it when the program starts, like CBOS_REGISTER_LIB().
+ *
+ * @param library The class of the library.
+ * @param getter Name of the generated getter.
+ */
+#define CBOS_REGISTER_BACKEND(library, getter)           \
+	const Crypto *getter()                               \
+	{                                                    \
+		return cbos::Backend<library>::crypto();         \
+	}                                                    \
+	CBOS_REGISTER_LIB(getter)
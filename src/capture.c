@@ -0,0 +1,112 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+
+#include "capture.h"
+
+_Static_assert(sizeof(CaptureRecord) == 24, "the record layout is part of the file format");
+
+/**
+ * Create a raw sample file of header and `capacity` records, reserve its
+ * blocks and map it.
+ *
+ * @param capture The capture to open.
+ * @param path Path of the file.
+ * @param capacity Number of records to preallocate.
+ * @return True on success, otherwise false.
+ */
+bool capture_open(Capture *capture, const char *path, size_t capacity)
+{
+	const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+	const size_t records_offset = (sizeof(CaptureHeader) + page - 1) / page * page;
+
+	memset(capture, 0, sizeof(Capture));
+	capture->map_size = records_offset + capacity * sizeof(CaptureRecord);
+	capture->capacity = capacity;
+
+	capture->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (capture->fd < 0)
+	{
+		printf("Error: cannot create %s: %s\n", path, strerror(errno));
+		return false;
+	}
+
+	// Reserve the blocks now, so no sample waits for the file system to allocate one
+	int error = posix_fallocate(capture->fd, 0, capture->map_size);
+	if (error == EOPNOTSUPP || error == EINVAL)
+	{
+		error = ftruncate(capture->fd, capture->map_size) ? errno : 0;
+	}
+
+	void *map = error ? MAP_FAILED : mmap(NULL, capture->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, capture->fd, 0);
+	if (map == MAP_FAILED)
+	{
+		printf("Error: cannot map %zu bytes of %s: %s\n", capture->map_size, path, strerror(error ? error : errno));
+		close(capture->fd);
+		return false;
+	}
+
+	madvise(map, capture->map_size, MADV_SEQUENTIAL);
+
+	capture->header = map;
+	capture->records = (CaptureRecord *)((uint8_t *)map + records_offset);
+
+	memcpy(capture->header->magic, CAPTURE_MAGIC, sizeof(capture->header->magic));
+	capture->header->record_size = sizeof(CaptureRecord);
+	capture->header->records_offset = records_offset;
+
+	return true;
+}
+
+/**
+ * Add a series for the samples of an algorithm.
+ *
+ * @param capture The open capture.
+ * @param library Name of the library.
+ * @param algorithm Name of the algorithm.
+ * @return Index of the series, -1 if all series are in use.
+ */
+int capture_series(Capture *capture, const char *library, const char *algorithm)
+{
+	CaptureHeader *header = capture->header;
+
+	if (header->series_count >= CAPTURE_MAX_SERIES)
+	{
+		return -1;
+	}
+
+	CaptureSeries *series = &header->series[header->series_count];
+	snprintf(series->library, sizeof(series->library), "%s", library);
+	snprintf(series->algorithm, sizeof(series->algorithm), "%s", algorithm);
+
+	return (int)header->series_count++;
+}
+
+/**
+ * Write the counts to the header, trim the unused preallocation and unmap
+ * the file.
+ *
+ * @param capture The open capture.
+ * @return True on success, otherwise false.
+ */
+bool capture_close(Capture *capture)
+{
+	const size_t used = capture->header->records_offset + capture->count * sizeof(CaptureRecord);
+	bool ok = true;
+
+	capture->header->count = capture->count;
+	capture->header->dropped = capture->dropped;
+
+	if (msync(capture->header, capture->map_size, MS_SYNC) != 0 || munmap(capture->header, capture->map_size) != 0 ||
+		ftruncate(capture->fd, used) != 0)
+	{
+		printf("Error: failed to write the raw samples: %s\n", strerror(errno));
+		ok = false;
+	}
+
+	close(capture->fd);
+	capture->header = NULL;
+	capture->records = NULL;
+
+	return ok;
+}
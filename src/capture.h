@@ -0,0 +1,134 @@
+#pragma once
+
+#include <time.h>
+
+#include "cbos.h"
+
+/*
+ * Raw sample files have a fixed layout in host byte order: a CaptureHeader
+ * at offset 0, followed by `count` CaptureRecords starting at
+ * `records_offset`. Records of all benchmarked algorithms are interleaved in
+ * the order they were measured, each one refers to its algorithm by the
+ * index into `series`.
+ */
+
+#define CAPTURE_MAGIC "CBOSRAW1"
+#define CAPTURE_MAX_SERIES 256
+#define CAPTURE_NAME_SIZE 64
+
+/**
+ * One measured call
+ */
+typedef struct CaptureRecord
+{
+	uint64_t timestamp_ns; // CLOCK_MONOTONIC_RAW at the end of the call
+	uint32_t cycles;       // Cycles of the call from timestamp()
+	uint32_t size;         // Bytes processed by the call
+	uint16_t thread;       // Index of the measuring thread
+	uint16_t series;       // Index into CaptureHeader::series
+	uint32_t reserved;
+} CaptureRecord;
+
+/**
+ * Name of the library and algorithm of a series
+ */
+typedef struct CaptureSeries
+{
+	char library[CAPTURE_NAME_SIZE];
+	char algorithm[CAPTURE_NAME_SIZE];
+} CaptureSeries;
+
+/**
+ * Header of a raw sample file
+ */
+typedef struct CaptureHeader
+{
+	char magic[8];
+	uint32_t record_size;
+	uint32_t series_count;
+	uint64_t records_offset;
+	uint64_t count;   // Records in the file
+	uint64_t dropped; // Samples that did not fit into the preallocated file
+	CaptureSeries series[CAPTURE_MAX_SERIES];
+} CaptureHeader;
+
+/**
+ * Open raw sample file that samples are appended to by one thread
+ */
+typedef struct Capture
+{
+	CaptureHeader *header;
+	CaptureRecord *records;
+	size_t capacity;
+	size_t count;
+	size_t dropped;
+	size_t map_size;
+	int fd;
+} Capture;
+
+/**
+ * @brief Creates a raw sample file with room for `capacity` records and maps
+ * it, so appending a sample is a store to memory.
+ *
+ * @param capture The capture to open.
+ * @param path Path of the file, replaced if it exists.
+ * @param capacity Number of records to preallocate.
+ * @return True on success, otherwise false.
+ */
+bool capture_open(Capture *capture, const char *path, size_t capacity);
+
+/**
+ * @brief Adds a series for the samples of an algorithm.
+ *
+ * @param capture The open capture.
+ * @param library Name of the library.
+ * @param algorithm Name of the algorithm.
+ * @return Index of the series, -1 if CAPTURE_MAX_SERIES are in use.
+ */
+int capture_series(Capture *capture, const char *library, const char *algorithm);
+
+/**
+ * @brief Writes the header, trims the file to the records written and unmaps
+ * it.
+ *
+ * @param capture The open capture.
+ * @return True on success, otherwise false.
+ */
+bool capture_close(Capture *capture);
+
+/**
+ * @brief Returns the time stored in CaptureRecord::timestamp_ns.
+ *
+ * @return CLOCK_MONOTONIC_RAW in nanoseconds.
+ */
+static inline uint64_t capture_now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Appends a sample. Samples beyond the preallocated capacity are
+ * counted as dropped.
+ *
+ * @param capture The open capture.
+ * @param series Index of the series.
+ * @param timestamp_ns Time of the sample.
+ * @param cycles Cycles of the call.
+ * @param size Bytes processed by the call.
+ * @param thread Index of the measuring thread.
+ */
+static inline void capture_add(Capture *capture, int series, uint64_t timestamp_ns, uint32_t cycles, uint32_t size,
+							   uint16_t thread)
+{
+	if (capture->count < capture->capacity)
+	{
+		capture->records[capture->count++] =
+			(CaptureRecord){timestamp_ns, cycles, size, thread, (uint16_t)series, 0};
+	}
+	else
+	{
+		++capture->dropped;
+	}
+}
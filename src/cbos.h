@@ -7,6 +7,17 @@
 #include <string.h>
 #include <unistd.h>
 
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Largest output of Crypto::digest
+#define MAX_DIGEST_SIZE 64
+
+// Keys a backend draws in set_cipher for Crypto::rekey to cycle through
+#define REKEY_KEYS 16
+
 /**
  * @struct Crypto
  * @brief This struct defines function pointers that can be used to interact
@@ -21,33 +32,87 @@ typedef struct Crypto
 	bool (*random)(void *param, const size_t size, void *dst);
 	bool (*set_cipher)(void *param, const char *cipher);
 	size_t (*encrypt)(void *param, const size_t size, void *dst, const void *src);
+	// Optional: encrypts `iterations` times without per-call dispatch, returns completed iterations
+	size_t (*encrypt_loop)(void *param, const size_t size, void *dst, const void *src, const size_t iterations);
+	// Optional: hash and MAC functions, the output has at most MAX_DIGEST_SIZE bytes
+	const char **(*digests)(); // Function to get supported hash and MAC functions
+	bool (*set_digest)(void *param, const char *digest);
+	size_t (*digest)(void *param, const size_t size, void *dst, const void *src); // Returns the output size
+	// Optional: public-key operations, set_pk_operation generates all keys and inputs
+	const char **(*pk_operations)(); // Function to get supported public-key operations
+	bool (*set_pk_operation)(void *param, const char *operation);
+	bool (*pk_run)(void *param); // Performs the public-key operation once
+	// Optional: random number generators, shared ones may be called from several threads at once
+	const char **(*rngs)(); // Function to get supported random number generators
+	bool (*set_rng)(void *param, const char *rng, bool shared);
+	bool (*rng_bytes)(void *param, const size_t size, void *dst);
+	// Optional: one message encrypted in several updates with the key and IV of set_cipher
+	bool (*stream_start)(void *param);
+	bool (*stream_update)(void *param, const size_t size, void *dst, const void *src, size_t *written);
+	bool (*stream_finish)(void *param, void *dst, size_t *written); // Writes buffered input and the tag
+	// Optional: replaces the key of the current cipher with the next of REKEY_KEYS random ones, the next message uses it.
+	// Until the next set_cipher, messages may keep the key set up and only set their IV.
+	bool (*rekey)(void *param);
+	// Optional: encrypts one XTS data unit with the tweak of its sector number, little-endian like dm-crypt's plain64
+	size_t (*encrypt_sector)(void *param, const uint64_t sector, const size_t size, void *dst, const void *src);
+	// Optional: replaces the key and IV of the current cipher, fails if their sizes do not fit it
+	bool (*set_key)(void *param, const uint8_t *key, const size_t key_size, const uint8_t *iv, const size_t iv_size);
+	// Optional: decrypts a message of encrypt with the key and IV of the current cipher
+	size_t (*decrypt)(void *param, const size_t size, void *dst, const void *src);
 } Crypto;
 
 /**
- * @brief Function to get the implementation of the current cryptographic library.
+ * @brief Registers a cryptographic library to be benchmarked.
+ *
+ * Libraries register themselves before main() runs through CBOS_REGISTER_LIB(),
+ * so several implementations can be linked into one executable.
+ *
+ * @param crypto_library A pointer to the library implementation (Crypto struct).
+ */
+void register_lib(const Crypto *crypto_library);
+
+/**
+ * @brief Function to get the implementations of all registered cryptographic libraries.
  *
- * @return A pointer to the current cryptographic library (Crypto struct).
+ * @return A NULL-terminated array of pointers to Crypto structs in registration order.
  */
-const Crypto *get_lib();
+const Crypto **get_libs();
 
 /**
- * @brief Gets the message size for benchmarking defined by user.
+ * @brief Registers the library returned by `getter` when the program starts.
+ *
+ * @param getter Function returning a pointer to the library's Crypto struct.
+ */
+#define CBOS_REGISTER_LIB(getter)                                        \
+	__attribute__((constructor)) static void register_##getter(void) \
+	{                                                                \
+		register_lib(getter());                                      \
+	}
+
+/**
+ * @brief Gets the message size for benchmarking defined by user. A backend
+ * may define it, otherwise MESSAGE_SIZE of the compiler flags is used.
  *
  * @return The message size.
  */
 int get_message_size();
 
 /**
- * @brief Gets the number of iterations defined by user.
+ * @brief Gets the number of iterations defined by user. A backend may define
+ * it, otherwise ITERATIONS of the compiler flags is used.
  *
  * @return The number of iterations.
  */
 int get_iterations();
 
 /**
- * @brief Function to generate random bytes.
+ * @brief Function to generate random bytes with getrandom().
  *
  * @param data Pointer to the destination buffer.
  * @param size Number of random bytes to generate.
  */
 void random_bytes(uint8_t *data, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,681 @@
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "daemon.h"
+#include "utils.h"
+
+// Encrypt calls between two checks of the clock
+#define DAEMON_BATCH 16
+
+// Bytes of the JSON of one cipher, names included
+#define DAEMON_ENTRY_JSON 1024
+
+/**
+ * Rolling statistics of one cipher of one library
+ */
+typedef struct CipherStats
+{
+	size_t lib; // Index into the libraries
+	const char *lib_name;
+	const char *cipher;
+	double window[DAEMON_WINDOW]; // MB/s of the last slices, a ring indexed by slices
+	size_t slices;
+	double bytes;
+	double seconds;
+	double last;
+	double minimum;
+	double maximum;
+	double first_window; // Mean of the first DAEMON_WINDOW slices
+	bool failed;
+} CipherStats;
+
+/**
+ * State shared by the measuring thread and the socket thread
+ */
+typedef struct Daemon
+{
+	CipherStats *stats;
+	size_t count;
+	size_t rounds;
+	size_t message_size;
+	double start;
+	pthread_mutex_t lock; // Guards stats and rounds
+	char *json;			  // Snapshot buffer of the socket thread
+	size_t json_size;
+	int listen_fd;
+	int clients[DAEMON_MAX_CLIENTS]; // Tailing clients
+	size_t client_count;
+} Daemon;
+
+static volatile sig_atomic_t daemon_stop = 0;
+
+static void daemon_signal(int signal)
+{
+	(void)signal;
+	daemon_stop = 1;
+}
+
+/**
+ * Appends formatted text to a buffer, cutting it at its end.
+ */
+static void json_append(char *buffer, size_t size, size_t *length, const char *format, ...)
+{
+	va_list args;
+
+	if (*length + 1 >= size)
+		return;
+
+	va_start(args, format);
+	const int written = vsnprintf(buffer + *length, size - *length, format, args);
+	va_end(args);
+
+	if (written > 0)
+		*length = *length + written < size ? *length + written : size - 1;
+}
+
+/**
+ * Appends a JSON string with quotes, backslashes and control characters
+ * escaped.
+ */
+static void json_string(char *buffer, size_t size, size_t *length, const char *text)
+{
+	json_append(buffer, size, length, "\"");
+	for (const unsigned char *c = (const unsigned char *)text; *c; ++c)
+	{
+		if (*c == '"' || *c == '\\')
+			json_append(buffer, size, length, "\\%c", *c);
+		else if (*c < 0x20)
+			json_append(buffer, size, length, "\\u%04x", *c);
+		else
+			json_append(buffer, size, length, "%c", *c);
+	}
+	json_append(buffer, size, length, "\"");
+}
+
+/**
+ * Adds the throughput of a slice to the statistics of a cipher.
+ */
+static void stats_add(CipherStats *stats, double bytes, double elapsed)
+{
+	const double mb_per_s = bytes / elapsed / 1e6;
+
+	if (stats->slices < DAEMON_WINDOW)
+	{
+		stats->first_window = (stats->first_window * stats->slices + mb_per_s) / (stats->slices + 1);
+	}
+
+	if (stats->slices == 0 || mb_per_s < stats->minimum)
+		stats->minimum = mb_per_s;
+	if (stats->slices == 0 || mb_per_s > stats->maximum)
+		stats->maximum = mb_per_s;
+
+	stats->window[stats->slices % DAEMON_WINDOW] = mb_per_s;
+	stats->slices++;
+	stats->bytes += bytes;
+	stats->seconds += elapsed;
+	stats->last = mb_per_s;
+}
+
+/**
+ * Computes the mean, minimum, maximum and standard deviation of the rolling
+ * window of a cipher.
+ */
+static void stats_window(const CipherStats *stats, double *mean, double *minimum, double *maximum, double *stddev)
+{
+	const size_t count = stats->slices < DAEMON_WINDOW ? stats->slices : DAEMON_WINDOW;
+	double sum = 0.0, squares = 0.0;
+
+	*minimum = count ? stats->window[0] : 0.0;
+	*maximum = *minimum;
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		sum += stats->window[i];
+		squares += stats->window[i] * stats->window[i];
+		if (stats->window[i] < *minimum)
+			*minimum = stats->window[i];
+		if (stats->window[i] > *maximum)
+			*maximum = stats->window[i];
+	}
+
+	*mean = count ? sum / count : 0.0;
+	const double variance = count ? squares / count - *mean * *mean : 0.0;
+	*stddev = variance > 0.0 ? sqrt(variance) : 0.0;
+}
+
+/**
+ * Writes a JSON snapshot of all ciphers as one line into the snapshot buffer.
+ *
+ * @param daemon The daemon.
+ * @param final Whether the daemon is stopping.
+ * @return Length of the snapshot.
+ */
+static size_t daemon_snapshot(Daemon *daemon, bool final)
+{
+	char *buffer = daemon->json;
+	const size_t size = daemon->json_size;
+	size_t length = 0;
+
+	pthread_mutex_lock(&daemon->lock);
+
+	json_append(buffer, size, &length,
+				"{\"final\":%s,\"uptime_s\":%.3f,\"rounds\":%zu,\"message_size\":%zu,\"slice_s\":%.3f,"
+				"\"window_slices\":%d,\"ciphers\":[",
+				final ? "true" : "false", seconds() - daemon->start, daemon->rounds, daemon->message_size,
+				DAEMON_SLICE, DAEMON_WINDOW);
+
+	for (size_t i = 0; i < daemon->count; ++i)
+	{
+		const CipherStats *stats = &daemon->stats[i];
+		double mean, minimum, maximum, stddev;
+
+		stats_window(stats, &mean, &minimum, &maximum, &stddev);
+
+		json_append(buffer, size, &length, "%s{\"library\":", i ? "," : "");
+		json_string(buffer, size, &length, stats->lib_name);
+		json_append(buffer, size, &length, ",\"cipher\":");
+		json_string(buffer, size, &length, stats->cipher);
+		json_append(buffer, size, &length,
+					",\"failed\":%s,\"slices\":%zu,\"mb_per_s\":%.3f,\"last_mb_per_s\":%.3f,\"min_mb_per_s\":%.3f,"
+					"\"max_mb_per_s\":%.3f,\"window\":{\"mean_mb_per_s\":%.3f,\"min_mb_per_s\":%.3f,"
+					"\"max_mb_per_s\":%.3f,\"stddev_mb_per_s\":%.3f},\"first_window_mb_per_s\":%.3f,"
+					"\"change_percent\":%.3f}",
+					stats->failed ? "true" : "false", stats->slices,
+					stats->seconds > 0.0 ? stats->bytes / stats->seconds / 1e6 : 0.0, stats->last, stats->minimum,
+					stats->maximum, mean, minimum, maximum, stddev, stats->first_window,
+					stats->first_window > 0.0 ? 100.0 * (mean / stats->first_window - 1.0) : 0.0);
+	}
+
+	pthread_mutex_unlock(&daemon->lock);
+
+	json_append(buffer, size, &length, "]}\n");
+	return length;
+}
+
+/**
+ * Sends a whole buffer without raising SIGPIPE.
+ *
+ * @return True on success, false if the client is gone.
+ */
+static bool send_all(int fd, const char *buffer, size_t length)
+{
+	while (length > 0)
+	{
+		const ssize_t sent = send(fd, buffer, length, MSG_NOSIGNAL);
+		if (sent < 0 && errno == EINTR)
+			continue;
+		if (sent <= 0)
+			return false;
+		buffer += sent;
+		length -= sent;
+	}
+
+	return true;
+}
+
+/**
+ * Sends a snapshot to every tailing client and drops the ones that are gone.
+ */
+static void daemon_broadcast(Daemon *daemon, bool final)
+{
+	if (daemon->client_count == 0)
+		return;
+
+	const size_t length = daemon_snapshot(daemon, final);
+
+	for (size_t i = daemon->client_count; i-- > 0;)
+	{
+		if (!send_all(daemon->clients[i], daemon->json, length))
+		{
+			close(daemon->clients[i]);
+			daemon->clients[i] = daemon->clients[--daemon->client_count];
+		}
+	}
+}
+
+/**
+ * Accepts a client and answers its command.
+ */
+static void daemon_accept(Daemon *daemon)
+{
+	const struct timeval timeout = {1, 0};
+	char command[32] = "";
+
+	const int fd = accept(daemon->listen_fd, NULL, NULL);
+	if (fd < 0)
+		return;
+
+	// A client that does not send its command in time gets a snapshot
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+	const ssize_t received = recv(fd, command, sizeof(command) - 1, 0);
+	if (received > 0)
+		command[received] = '\0';
+
+	if (strncmp(command, "tail", 4) == 0)
+	{
+		if (daemon->client_count == DAEMON_MAX_CLIENTS)
+		{
+			static const char busy[] = "{\"error\":\"too many clients\"}\n";
+			send_all(fd, busy, sizeof(busy) - 1);
+			close(fd);
+			return;
+		}
+
+		const size_t length = daemon_snapshot(daemon, false);
+		if (send_all(fd, daemon->json, length))
+			daemon->clients[daemon->client_count++] = fd;
+		else
+			close(fd);
+	}
+	else if (command[0] == '\0' || strncmp(command, "snapshot", 8) == 0)
+	{
+		const size_t length = daemon_snapshot(daemon, false);
+		send_all(fd, daemon->json, length);
+		close(fd);
+	}
+	else
+	{
+		static const char unknown[] = "{\"error\":\"unknown command, use snapshot or tail\"}\n";
+		send_all(fd, unknown, sizeof(unknown) - 1);
+		close(fd);
+	}
+}
+
+/**
+ * Socket thread: answers clients and sends a snapshot to the tailing ones
+ * after every round of the matrix.
+ *
+ * @param arg The daemon.
+ * @return NULL.
+ */
+static void *daemon_serve(void *arg)
+{
+	Daemon *daemon = arg;
+	struct pollfd fds[1 + DAEMON_MAX_CLIENTS];
+	size_t sent_rounds = 0;
+
+	while (!daemon_stop)
+	{
+		fds[0] = (struct pollfd){daemon->listen_fd, POLLIN, 0};
+		for (size_t i = 0; i < daemon->client_count; ++i)
+		{
+			fds[1 + i] = (struct pollfd){daemon->clients[i], POLLIN, 0};
+		}
+
+		const size_t polled = daemon->client_count;
+		if (poll(fds, 1 + polled, 100) > 0)
+		{
+			// Input of tailing clients is ignored, they are dropped when they disconnect
+			for (size_t i = polled; i-- > 0;)
+			{
+				char ignored[64];
+
+				if (fds[1 + i].revents &&
+					((fds[1 + i].revents & (POLLHUP | POLLERR)) ||
+					 recv(daemon->clients[i], ignored, sizeof(ignored), MSG_DONTWAIT) <= 0))
+				{
+					close(daemon->clients[i]);
+					daemon->clients[i] = daemon->clients[--daemon->client_count];
+				}
+			}
+
+			if (fds[0].revents & POLLIN)
+			{
+				daemon_accept(daemon);
+			}
+		}
+
+		pthread_mutex_lock(&daemon->lock);
+		const size_t rounds = daemon->rounds;
+		pthread_mutex_unlock(&daemon->lock);
+
+		if (rounds != sent_rounds)
+		{
+			daemon_broadcast(daemon, false);
+			sent_rounds = rounds;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Creates the listening socket, replacing a stale one.
+ *
+ * @return The socket, -1 on error.
+ */
+static int daemon_listen(const char *path)
+{
+	struct sockaddr_un address = {0};
+
+	if (strlen(path) >= sizeof(address.sun_path))
+	{
+		printf("Error: the socket path %s is too long!\n", path);
+		return -1;
+	}
+
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, path);
+
+	const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+	{
+		printf("Error: cannot create a Unix socket: %s\n", strerror(errno));
+		return -1;
+	}
+
+	unlink(path);
+	if (bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(fd, DAEMON_MAX_CLIENTS) != 0)
+	{
+		printf("Error: cannot listen on %s: %s\n", path, strerror(errno));
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+/**
+ * Checks whether a cipher is in a comma-separated list.
+ */
+static bool cipher_selected(const char *list, const char *cipher)
+{
+	const size_t length = strlen(cipher);
+
+	if (!list)
+		return true;
+
+	for (const char *item = list; item; item = strchr(item, ','))
+	{
+		if (*item == ',')
+			++item;
+		if (strncmp(item, cipher, length) == 0 && (item[length] == ',' || item[length] == '\0'))
+			return true;
+	}
+
+	return false;
+}
+
+/**
+ * Encrypts with one cipher for one slice.
+ *
+ * @param crypto_library Pointer to the cryptographic library.
+ * @param param The context with the cipher already set.
+ * @param message_size Size of every message.
+ * @param dst Output buffer.
+ * @param src Input message.
+ * @param bytes Output for the bytes encrypted.
+ * @param elapsed Output for the duration.
+ * @return True on success, false if encryption failed or the daemon stops.
+ */
+static bool daemon_slice(const Crypto *crypto_library, void *param, const size_t message_size, uint8_t *dst,
+						 const uint8_t *src, double *bytes, double *elapsed)
+{
+	const double start = seconds();
+	const double deadline = start + DAEMON_SLICE;
+	size_t calls = 0;
+	double now = start;
+
+	while (now < deadline)
+	{
+		if (daemon_stop)
+			return false;
+
+		for (int i = 0; i < DAEMON_BATCH; ++i)
+		{
+			if (!crypto_library->encrypt(param, message_size, dst, src))
+				return false;
+		}
+		calls += DAEMON_BATCH;
+		now = seconds();
+	}
+
+	*bytes = (double)calls * message_size;
+	*elapsed = now - start;
+	return true;
+}
+
+/**
+ * Prints the final statistics of every cipher.
+ */
+static void daemon_report(const Daemon *daemon)
+{
+	printf("Stopped after %.0f s and %zu rounds\n", seconds() - daemon->start, daemon->rounds);
+
+	for (size_t i = 0; i < daemon->count; ++i)
+	{
+		const CipherStats *stats = &daemon->stats[i];
+		double mean, minimum, maximum, stddev;
+
+		if (stats->slices == 0)
+		{
+			printf("[%s] %s: no slice measured%s\n", stats->lib_name, stats->cipher, stats->failed ? ", failed" : "");
+			continue;
+		}
+
+		stats_window(stats, &mean, &minimum, &maximum, &stddev);
+		printf("[%s] %s: %.1f MB/s over %zu slices, last %d: mean %.1f (min %.1f, max %.1f, sd %.1f), %+.1f%% "
+			   "against the first %d\n",
+			   stats->lib_name, stats->cipher, stats->bytes / stats->seconds / 1e6, stats->slices, DAEMON_WINDOW, mean,
+			   minimum, maximum, stddev, 100.0 * (mean / stats->first_window - 1.0), DAEMON_WINDOW);
+	}
+}
+
+/**
+ * Runs the matrix continuously and serves snapshots until SIGTERM or SIGINT.
+ *
+ * @param libs NULL-terminated list of the libraries.
+ * @param message_size Size of every message.
+ * @param path Path of the socket.
+ * @param ciphers Comma-separated ciphers to run, NULL for all of them.
+ * @param results_path File the final snapshot is written to.
+ * @return True if the benchmark succeeds; otherwise, false.
+ */
+bool benchmark_daemon(const Crypto **libs, const size_t message_size, const char *path, const char *ciphers,
+					  const char *results_path)
+{
+	Daemon daemon = {0};
+	size_t lib_count = 0;
+	bool ok = true;
+
+	for (lib_count = 0; libs[lib_count] != NULL; ++lib_count)
+	{
+		const char **names = libs[lib_count]->ciphers();
+		for (size_t j = 0; names[j] != NULL; ++j)
+			daemon.count += cipher_selected(ciphers, names[j]);
+	}
+
+	if (daemon.count == 0)
+	{
+		printf("Error: no library supports the selected ciphers!\n");
+		return false;
+	}
+
+	// Everything the daemon needs is allocated here, memory stays constant while it runs
+	void **params = calloc(lib_count, sizeof(void *));
+	uint8_t *src = malloc(message_size);
+	uint8_t *dst = malloc(message_size + MAX_DIGEST_SIZE);
+	daemon.stats = calloc(daemon.count, sizeof(CipherStats));
+	daemon.json_size = 512 + daemon.count * DAEMON_ENTRY_JSON;
+	daemon.json = malloc(daemon.json_size);
+	daemon.message_size = message_size;
+
+	ok = params && src && dst && daemon.stats && daemon.json;
+	for (size_t l = 0, s = 0; ok && l < lib_count; ++l)
+	{
+		const char **names = libs[l]->ciphers();
+
+		if (!libs[l]->init(&params[l]) || !libs[l]->random(params[l], message_size, src))
+		{
+			printf("Error: [%s] daemon initialization failed!\n", libs[l]->name());
+			ok = false;
+			break;
+		}
+
+		for (size_t j = 0; names[j] != NULL; ++j)
+		{
+			if (cipher_selected(ciphers, names[j]))
+				daemon.stats[s++] = (CipherStats){.lib = l, .lib_name = libs[l]->name(), .cipher = names[j]};
+		}
+	}
+
+	daemon.listen_fd = ok ? daemon_listen(path) : -1;
+	ok = ok && daemon.listen_fd >= 0;
+
+	if (ok)
+	{
+		struct sigaction action = {0};
+		pthread_t server;
+
+		action.sa_handler = daemon_signal;
+		sigemptyset(&action.sa_mask);
+		sigaction(SIGTERM, &action, NULL);
+		sigaction(SIGINT, &action, NULL);
+
+		pthread_mutex_init(&daemon.lock, NULL);
+		daemon.start = seconds();
+		pthread_create(&server, NULL, daemon_serve, &daemon);
+
+		// The socket thread keeps the affinity of the process, only the measuring thread is pinned
+		pin_thread(0);
+
+		printf("Serving %zu ciphers on %s, stop with SIGTERM\n", daemon.count, path);
+		fflush(stdout);
+
+		size_t running = daemon.count;
+		while (!daemon_stop && running > 0)
+		{
+			running = 0;
+			for (size_t i = 0; i < daemon.count && !daemon_stop; ++i)
+			{
+				CipherStats *stats = &daemon.stats[i];
+				const Crypto *crypto_library = libs[stats->lib];
+				double bytes, elapsed;
+
+				if (stats->failed)
+					continue;
+
+				if (!crypto_library->set_cipher(params[stats->lib], stats->cipher) ||
+					!daemon_slice(crypto_library, params[stats->lib], message_size, dst, src, &bytes, &elapsed))
+				{
+					// A slice cut short by the signal is not counted
+					if (!daemon_stop)
+					{
+						printf("Error: [%s] %s failed, it is not run again!\n", stats->lib_name, stats->cipher);
+						stats->failed = true;
+						ok = false;
+					}
+					continue;
+				}
+
+				pthread_mutex_lock(&daemon.lock);
+				stats_add(stats, bytes, elapsed);
+				pthread_mutex_unlock(&daemon.lock);
+				++running;
+			}
+
+			pthread_mutex_lock(&daemon.lock);
+			daemon.rounds += !daemon_stop;
+			pthread_mutex_unlock(&daemon.lock);
+		}
+
+		// Every cipher failed, stop the socket thread as well
+		daemon_stop = 1;
+		pthread_join(server, NULL);
+
+		daemon_broadcast(&daemon, true);
+		for (size_t i = 0; i < daemon.client_count; ++i)
+			close(daemon.clients[i]);
+		close(daemon.listen_fd);
+		unlink(path);
+
+		FILE *file = fopen(results_path, "w");
+		if (file)
+		{
+			const size_t length = daemon_snapshot(&daemon, true);
+			fwrite(daemon.json, 1, length, file);
+			fclose(file);
+			printf("Final snapshot written to %s\n", results_path);
+		}
+		else
+		{
+			printf("Error: cannot write %s: %s\n", results_path, strerror(errno));
+			ok = false;
+		}
+
+		daemon_report(&daemon);
+		pthread_mutex_destroy(&daemon.lock);
+	}
+
+	for (size_t l = 0; params && l < lib_count; ++l)
+	{
+		if (params[l])
+			libs[l]->free(params[l]);
+	}
+
+	free(params);
+	free(src);
+	free(dst);
+	free(daemon.stats);
+	free(daemon.json);
+	return ok;
+}
+
+/**
+ * Sends a command to a running daemon and prints its answer.
+ *
+ * @param path Path of the socket.
+ * @param command "snapshot" or "tail".
+ * @return True on success, otherwise false.
+ */
+bool daemon_client(const char *path, const char *command)
+{
+	struct sockaddr_un address = {0};
+	char buffer[4096];
+	ssize_t received;
+
+	snprintf(buffer, sizeof(buffer), "%s\n", command);
+
+	if (strlen(path) >= sizeof(address.sun_path))
+	{
+		printf("Error: the socket path %s is too long!\n", path);
+		return false;
+	}
+
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, path);
+
+	const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0 || connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0)
+	{
+		printf("Error: cannot connect to %s: %s\n", path, strerror(errno));
+		if (fd >= 0)
+			close(fd);
+		return false;
+	}
+
+	if (!send_all(fd, buffer, strlen(buffer)))
+	{
+		printf("Error: cannot send to %s: %s\n", path, strerror(errno));
+		close(fd);
+		return false;
+	}
+
+	while ((received = recv(fd, buffer, sizeof(buffer), 0)) > 0 || (received < 0 && errno == EINTR))
+	{
+		if (received > 0)
+		{
+			fwrite(buffer, 1, received, stdout);
+			fflush(stdout);
+		}
+	}
+
+	close(fd);
+	return received == 0;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "cbos.h"
+
+// Length of one measurement of a cipher in seconds
+#ifndef DAEMON_SLICE
+#define DAEMON_SLICE 1.0
+#endif
+
+// Slices per cipher the rolling statistics cover
+#ifndef DAEMON_WINDOW
+#define DAEMON_WINDOW 60
+#endif
+
+// Clients tailing the snapshots at the same time
+#ifndef DAEMON_MAX_CLIENTS
+#define DAEMON_MAX_CLIENTS 16
+#endif
+
+/**
+ * @brief Encrypts with the matrix of every library and the selected ciphers
+ * round-robin, one slice of DAEMON_SLICE seconds per cipher, until SIGTERM or
+ * SIGINT. Every cipher keeps its overall throughput and the rolling mean,
+ * minimum, maximum and standard deviation of its last DAEMON_WINDOW slices in
+ * memory allocated once at the start, so it can run for days.
+ *
+ * A Unix domain socket at `path` serves JSON snapshots of all ciphers: a
+ * client sending "snapshot" gets the current one, a client sending "tail" gets
+ * one line after every round of the matrix until it disconnects. On SIGTERM
+ * the final snapshot is sent to the tailing clients, written to
+ * `results_path` and printed as a table.
+ *
+ * @param libs NULL-terminated list of the libraries.
+ * @param message_size Size of every message.
+ * @param path Path of the socket, replaced if it exists.
+ * @param ciphers Comma-separated ciphers to run, NULL for all of them.
+ * @param results_path File the final snapshot is written to.
+ * @return True if the benchmark succeeds; otherwise, false.
+ */
+bool benchmark_daemon(const Crypto **libs, const size_t message_size, const char *path, const char *ciphers,
+					  const char *results_path);
+
+/**
+ * @brief Sends a command to a running daemon and copies its answer to
+ * stdout until the daemon closes the connection.
+ *
+ * @param path Path of the socket.
+ * @param command "snapshot" or "tail".
+ * @return True on success, otherwise false.
+ */
+bool daemon_client(const char *path, const char *command);
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "cbos.h"
+
+/**
+ * @brief Defines a batch encryption loop whose kernel is bound at compile time.
+ *
+ * The generated function has the signature of Crypto::encrypt_loop. The kernel
+ * is called directly instead of through the Crypto struct, so when it is a
+ * static inline function of the same translation unit the compiler can inline
+ * it into the loop. Together with a compile-time message size this removes the
+ * per-call dispatch and argument checks from the measured loop.
+ *
+ * A backend instantiates the macro once per kernel (e.g. per cipher family)
+ * and selects the matching loop once per batch in its encrypt_loop function.
+ *
+ * @param loop_name Name of the generated (static) function.
+ * @param kernel Function `size_t kernel(void *param, size_t size, void *dst, const void *src)`
+ * returning zero on failure.
+ * @param message_size Compile-time message size the loop is specialized for.
+ */
+#define CBOS_DEFINE_ENCRYPT_LOOP(loop_name, kernel, message_size)                                        \
+	static size_t loop_name(void *param, const size_t size, void *dst, const void *src, const size_t iterations) \
+	{                                                                                                    \
+		if (size != (message_size))                                                                      \
+		{                                                                                                \
+			return 0;                                                                                    \
+		}                                                                                                \
+		for (size_t i = 0; i < iterations; ++i)                                                          \
+		{                                                                                                \
+			if (!kernel(param, (message_size), dst, src))                                                \
+			{                                                                                            \
+				return i;                                                                                \
+			}                                                                                            \
+		}                                                                                                \
+		return iterations;                                                                               \
+	}
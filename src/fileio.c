@@ -0,0 +1,674 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#include "fileio.h"
+#include "utils.h"
+
+// Alignment of O_DIRECT buffers, offsets and lengths
+#define FILE_ALIGNMENT 4096
+
+/**
+ * State of one file encryption
+ */
+typedef struct FileJob
+{
+	const Crypto *crypto_library;
+	void *param;
+	const char *input;
+	const char *output;
+	size_t size;		  // Size of the input file
+	size_t piece;		  // Bytes per encrypt call, MESSAGE_SIZE
+	uint8_t *scratch_in;  // Last piece of a chunk that is shorter than `piece`
+	uint8_t *scratch_out;
+	double cipher_time;
+	double io_time; // Time the encrypting thread waits for I/O
+} FileJob;
+
+/**
+ * Result of an I/O path. Paths the system does not support are skipped.
+ */
+typedef enum FileStatus
+{
+	FILE_OK,
+	FILE_FAILED,
+	FILE_UNSUPPORTED
+} FileStatus;
+
+/**
+ * Encrypts a chunk in pieces of MESSAGE_SIZE bytes, each one message of the
+ * cipher. A shorter last piece is padded in a scratch buffer, because backends
+ * may always process MESSAGE_SIZE bytes.
+ *
+ * @param job The file job, its cipher time is increased.
+ * @param dst Destination of the ciphertext.
+ * @param src The plaintext.
+ * @param size Size of the chunk.
+ * @return True on success, otherwise false.
+ */
+static bool encrypt_chunk(FileJob *job, uint8_t *dst, const uint8_t *src, const size_t size)
+{
+	const double start = seconds();
+	size_t offset = 0;
+	bool ok = true;
+
+	for (; ok && offset + job->piece <= size; offset += job->piece)
+	{
+		ok = job->crypto_library->encrypt(job->param, job->piece, dst + offset, src + offset) != 0;
+	}
+
+	if (ok && offset < size)
+	{
+		memcpy(job->scratch_in, src + offset, size - offset);
+		memset(job->scratch_in + size - offset, 0, job->piece - (size - offset));
+		ok = job->crypto_library->encrypt(job->param, job->piece, job->scratch_out, job->scratch_in) != 0;
+		memcpy(dst + offset, job->scratch_out, size - offset);
+	}
+
+	job->cipher_time += seconds() - start;
+	return ok;
+}
+
+/**
+ * Encrypts through shared mappings of both files. Page faults are moved out of
+ * the cipher time by touching every page of a chunk first, and the final
+ * msync() is counted as I/O.
+ */
+static FileStatus file_mmap(FileJob *job)
+{
+	const long page = sysconf(_SC_PAGESIZE);
+	FileStatus status = FILE_FAILED;
+	uint8_t *src = MAP_FAILED, *dst = MAP_FAILED;
+	int in = open(job->input, O_RDONLY);
+	int out = open(job->output, O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+	if (in < 0 || out < 0 || ftruncate(out, job->size) != 0)
+	{
+		printf("Error: mmap: opening the files failed: %s\n", strerror(errno));
+	}
+	else if ((src = mmap(NULL, job->size, PROT_READ, MAP_SHARED, in, 0)) == MAP_FAILED ||
+			 (dst = mmap(NULL, job->size, PROT_READ | PROT_WRITE, MAP_SHARED, out, 0)) == MAP_FAILED)
+	{
+		printf("Error: mmap: mapping the files failed: %s\n", strerror(errno));
+	}
+	else
+	{
+		volatile uint8_t sink = 0;
+		status = FILE_OK;
+		madvise(src, job->size, MADV_SEQUENTIAL);
+
+		for (size_t offset = 0; status == FILE_OK && offset < job->size; offset += FILE_CHUNK_SIZE)
+		{
+			const size_t length = job->size - offset < FILE_CHUNK_SIZE ? job->size - offset : FILE_CHUNK_SIZE;
+
+			const double start = seconds();
+			for (size_t p = 0; p < length; p += page)
+			{
+				sink += src[offset + p];
+				dst[offset + p] = 0;
+			}
+			job->io_time += seconds() - start;
+
+			if (!encrypt_chunk(job, dst + offset, src + offset, length))
+				status = FILE_FAILED;
+		}
+
+		const double start = seconds();
+		if (status == FILE_OK && msync(dst, job->size, MS_SYNC) != 0)
+		{
+			printf("Error: mmap: msync() failed: %s\n", strerror(errno));
+			status = FILE_FAILED;
+		}
+		job->io_time += seconds() - start;
+	}
+
+	if (src != MAP_FAILED)
+		munmap(src, job->size);
+	if (dst != MAP_FAILED)
+		munmap(dst, job->size);
+	if (in >= 0)
+		close(in);
+	if (out >= 0)
+		close(out);
+
+	return status;
+}
+
+/**
+ * I/O thread of the double-buffered path. In step s it writes chunk s - 1 and
+ * reads chunk s + 1 while the main thread encrypts chunk s.
+ */
+typedef struct FileIO
+{
+	FileJob *job;
+	int in;
+	int out;
+	bool direct;
+	size_t chunks;
+	uint8_t *in_buffers[2];
+	uint8_t *out_buffers[2];
+	pthread_barrier_t barrier;
+	bool failed;
+} FileIO;
+
+/**
+ * Length of a chunk, with O_DIRECT rounded up to the alignment.
+ */
+static size_t chunk_length(const FileIO *io, const size_t chunk)
+{
+	const size_t offset = chunk * FILE_CHUNK_SIZE;
+	size_t length = io->job->size - offset < FILE_CHUNK_SIZE ? io->job->size - offset : FILE_CHUNK_SIZE;
+
+	if (io->direct)
+	{
+		length = (length + FILE_ALIGNMENT - 1) / FILE_ALIGNMENT * FILE_ALIGNMENT;
+	}
+
+	return length;
+}
+
+/**
+ * Reads or writes a whole chunk, continuing after short transfers.
+ */
+static bool transfer_chunk(const FileIO *io, const size_t chunk, const bool write)
+{
+	uint8_t *buffer = write ? io->out_buffers[chunk % 2] : io->in_buffers[chunk % 2];
+	const size_t offset = chunk * FILE_CHUNK_SIZE;
+	const size_t length = chunk_length(io, chunk);
+	size_t done = 0;
+
+	while (done < length)
+	{
+		const ssize_t n = write ? pwrite(io->out, buffer + done, length - done, offset + done)
+								: pread(io->in, buffer + done, length - done, offset + done);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n < 0)
+		{
+			printf("Error: %s failed: %s\n", write ? "pwrite()" : "pread()", strerror(errno));
+			return false;
+		}
+		if (n == 0)
+			break; // End of file, O_DIRECT reads are rounded up
+		done += n;
+	}
+
+	return true;
+}
+
+static void *file_io_thread(void *arg)
+{
+	FileIO *io = arg;
+
+	for (size_t step = 0; step <= io->chunks; ++step)
+	{
+		if (!io->failed && step > 0 && !transfer_chunk(io, step - 1, true))
+			io->failed = true;
+		if (!io->failed && step + 1 < io->chunks && !transfer_chunk(io, step + 1, false))
+			io->failed = true;
+
+		pthread_barrier_wait(&io->barrier);
+	}
+
+	return NULL;
+}
+
+/**
+ * Encrypts with pread()/pwrite() and two buffers per direction, so the I/O of
+ * the previous and the next chunk overlaps with encrypting the current one.
+ * The time the cipher waits for the I/O thread is counted as I/O wait. With
+ * O_DIRECT the page cache is bypassed and the output is truncated to the input
+ * size at the end.
+ */
+static FileStatus file_pread(FileJob *job, const bool direct)
+{
+	FileIO io = {job, -1, -1, direct, (job->size + FILE_CHUNK_SIZE - 1) / FILE_CHUNK_SIZE};
+	FileStatus status = FILE_FAILED;
+	const int flags = direct ? O_DIRECT : 0;
+
+	io.in = open(job->input, O_RDONLY | flags);
+	io.out = open(job->output, O_WRONLY | O_CREAT | O_TRUNC | flags, 0644);
+
+	if (io.in < 0 || io.out < 0)
+	{
+		if (direct && errno == EINVAL)
+		{
+			status = FILE_UNSUPPORTED;
+		}
+		else
+		{
+			printf("Error: opening the files failed: %s\n", strerror(errno));
+		}
+	}
+	else
+	{
+		bool allocated = true;
+		for (int i = 0; i < 2; ++i)
+		{
+			allocated = allocated && !posix_memalign((void **)&io.in_buffers[i], FILE_ALIGNMENT, FILE_CHUNK_SIZE) &&
+						!posix_memalign((void **)&io.out_buffers[i], FILE_ALIGNMENT, FILE_CHUNK_SIZE);
+		}
+
+		double start = seconds();
+		if (allocated && transfer_chunk(&io, 0, false))
+		{
+			pthread_t thread;
+			job->io_time += seconds() - start;
+			status = FILE_OK;
+
+			pthread_barrier_init(&io.barrier, NULL, 2);
+			pthread_create(&thread, NULL, file_io_thread, &io);
+
+			for (size_t step = 0; step <= io.chunks; ++step)
+			{
+				if (step < io.chunks && status == FILE_OK)
+				{
+					const size_t offset = step * FILE_CHUNK_SIZE;
+					const size_t length = job->size - offset < FILE_CHUNK_SIZE ? job->size - offset : FILE_CHUNK_SIZE;
+					if (!encrypt_chunk(job, io.out_buffers[step % 2], io.in_buffers[step % 2], length))
+						status = FILE_FAILED;
+				}
+
+				start = seconds();
+				pthread_barrier_wait(&io.barrier);
+				job->io_time += seconds() - start;
+			}
+
+			pthread_join(thread, NULL);
+			pthread_barrier_destroy(&io.barrier);
+
+			start = seconds();
+			if (io.failed || ftruncate(io.out, job->size) != 0 || fsync(io.out) != 0)
+			{
+				status = FILE_FAILED;
+			}
+			job->io_time += seconds() - start;
+		}
+		else if (direct && errno == EINVAL)
+		{
+			status = FILE_UNSUPPORTED;
+		}
+
+		for (int i = 0; i < 2; ++i)
+		{
+			free(io.in_buffers[i]);
+			free(io.out_buffers[i]);
+		}
+	}
+
+	if (io.in >= 0)
+		close(io.in);
+	if (io.out >= 0)
+		close(io.out);
+
+	return status;
+}
+
+/**
+ * Submission and completion queues of an io_uring instance, set up with raw
+ * system calls.
+ */
+typedef struct Uring
+{
+	int fd;
+	unsigned *sq_tail;
+	unsigned *sq_mask;
+	unsigned *sq_array;
+	struct io_uring_sqe *sqes;
+	unsigned *cq_head;
+	unsigned *cq_tail;
+	unsigned *cq_mask;
+	struct io_uring_cqe *cqes;
+	void *sq_ring;
+	size_t sq_ring_size;
+	void *cq_ring;
+	size_t cq_ring_size;
+	size_t sqes_size;
+	unsigned pending; // Queued but not yet submitted entries
+} Uring;
+
+static bool uring_init(Uring *ring, const unsigned entries)
+{
+	struct io_uring_params params = {0};
+
+	memset(ring, 0, sizeof(Uring));
+	ring->fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+	if (ring->fd < 0)
+	{
+		return false;
+	}
+
+	ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	if (params.features & IORING_FEAT_SINGLE_MMAP)
+	{
+		if (ring->cq_ring_size > ring->sq_ring_size)
+			ring->sq_ring_size = ring->cq_ring_size;
+		ring->cq_ring_size = ring->sq_ring_size;
+	}
+
+	ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd,
+						 IORING_OFF_SQ_RING);
+	ring->cq_ring = params.features & IORING_FEAT_SINGLE_MMAP
+						? ring->sq_ring
+						: mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd,
+							   IORING_OFF_CQ_RING);
+	ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+	ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd,
+					  IORING_OFF_SQES);
+
+	if (ring->sq_ring == MAP_FAILED || ring->cq_ring == MAP_FAILED || ring->sqes == MAP_FAILED)
+	{
+		return false;
+	}
+
+	uint8_t *sq = ring->sq_ring, *cq = ring->cq_ring;
+	ring->sq_tail = (unsigned *)(sq + params.sq_off.tail);
+	ring->sq_mask = (unsigned *)(sq + params.sq_off.ring_mask);
+	ring->sq_array = (unsigned *)(sq + params.sq_off.array);
+	ring->cq_head = (unsigned *)(cq + params.cq_off.head);
+	ring->cq_tail = (unsigned *)(cq + params.cq_off.tail);
+	ring->cq_mask = (unsigned *)(cq + params.cq_off.ring_mask);
+	ring->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+
+	return true;
+}
+
+static void uring_free(Uring *ring)
+{
+	if (ring->sqes && ring->sqes != MAP_FAILED)
+		munmap(ring->sqes, ring->sqes_size);
+	if (ring->cq_ring && ring->cq_ring != MAP_FAILED && ring->cq_ring != ring->sq_ring)
+		munmap(ring->cq_ring, ring->cq_ring_size);
+	if (ring->sq_ring && ring->sq_ring != MAP_FAILED)
+		munmap(ring->sq_ring, ring->sq_ring_size);
+	if (ring->fd >= 0)
+		close(ring->fd);
+}
+
+/**
+ * Queues a read or write of one buffer, submitted with the next uring_wait().
+ */
+static void uring_queue(Uring *ring, const int opcode, const int fd, void *buffer, const size_t length,
+						const size_t offset, const uint64_t user_data)
+{
+	const unsigned tail = *ring->sq_tail;
+	const unsigned index = tail & *ring->sq_mask;
+	struct io_uring_sqe *sqe = &ring->sqes[index];
+
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = opcode;
+	sqe->fd = fd;
+	sqe->addr = (uint64_t)(uintptr_t)buffer;
+	sqe->len = length;
+	sqe->off = offset;
+	sqe->user_data = user_data;
+	ring->sq_array[index] = index;
+
+	__atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+	++ring->pending;
+}
+
+/**
+ * Submits the queued entries and waits for at least one completion.
+ */
+static bool uring_wait(Uring *ring)
+{
+	for (;;)
+	{
+		const int ret = (int)syscall(__NR_io_uring_enter, ring->fd, ring->pending, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+		if (ret >= 0)
+		{
+			ring->pending -= ret;
+			return true;
+		}
+		if (errno != EINTR)
+		{
+			printf("Error: io_uring_enter() failed: %s\n", strerror(errno));
+			return false;
+		}
+	}
+}
+
+/**
+ * Encrypts with FILE_QUEUE_DEPTH chunks in flight on an io_uring. Every slot
+ * reads a chunk, encrypts it and writes it back before it reads the next one,
+ * so the reads and writes of the other slots proceed while a chunk is
+ * encrypted. Time spent in io_uring_enter() waiting for completions is I/O
+ * wait.
+ */
+static FileStatus file_io_uring(FileJob *job)
+{
+	const size_t chunks = (job->size + FILE_CHUNK_SIZE - 1) / FILE_CHUNK_SIZE;
+	uint8_t *buffers = NULL;
+	FileStatus status = FILE_FAILED;
+	Uring ring;
+	int in = open(job->input, O_RDONLY);
+	int out = open(job->output, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+	if (in < 0 || out < 0)
+	{
+		printf("Error: io_uring: opening the files failed: %s\n", strerror(errno));
+	}
+	else if (!uring_init(&ring, FILE_QUEUE_DEPTH))
+	{
+		status = errno == ENOSYS || errno == EPERM ? FILE_UNSUPPORTED : FILE_FAILED;
+		if (status == FILE_FAILED)
+			printf("Error: io_uring: setup failed: %s\n", strerror(errno));
+		uring_free(&ring);
+	}
+	else if (posix_memalign((void **)&buffers, FILE_ALIGNMENT, 2 * FILE_QUEUE_DEPTH * FILE_CHUNK_SIZE))
+	{
+		uring_free(&ring);
+	}
+	else
+	{
+		// user_data: slot in the low 8 bits, the chunk above them, bit 63 for writes
+		const uint64_t write_flag = 1ULL << 63;
+		size_t next = 0, written = 0;
+		status = FILE_OK;
+
+		for (size_t slot = 0; slot < FILE_QUEUE_DEPTH && next < chunks; ++slot, ++next)
+		{
+			const size_t length = job->size - next * FILE_CHUNK_SIZE < FILE_CHUNK_SIZE ? job->size - next * FILE_CHUNK_SIZE
+																						: FILE_CHUNK_SIZE;
+			uring_queue(&ring, IORING_OP_READ, in, buffers + 2 * slot * FILE_CHUNK_SIZE, length,
+						next * FILE_CHUNK_SIZE, slot | next << 8);
+		}
+
+		while (status == FILE_OK && written < chunks)
+		{
+			const double start = seconds();
+			if (!uring_wait(&ring))
+			{
+				status = FILE_FAILED;
+				break;
+			}
+			job->io_time += seconds() - start;
+
+			unsigned head = *ring.cq_head;
+			while (status == FILE_OK && head != __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE))
+			{
+				const struct io_uring_cqe *cqe = &ring.cqes[head & *ring.cq_mask];
+				const uint64_t user_data = cqe->user_data;
+				const size_t slot = user_data & 0xff;
+				const size_t chunk = (user_data & ~write_flag) >> 8;
+				const size_t offset = chunk * FILE_CHUNK_SIZE;
+				const size_t length = job->size - offset < FILE_CHUNK_SIZE ? job->size - offset : FILE_CHUNK_SIZE;
+				uint8_t *plaintext = buffers + 2 * slot * FILE_CHUNK_SIZE;
+				uint8_t *ciphertext = plaintext + FILE_CHUNK_SIZE;
+
+				if (cqe->res != (int)length)
+				{
+					printf("Error: io_uring: %s of chunk %zu returned %d\n", user_data & write_flag ? "write" : "read",
+						   chunk, cqe->res);
+					status = FILE_FAILED;
+				}
+				else if (!(user_data & write_flag))
+				{
+					if (!encrypt_chunk(job, ciphertext, plaintext, length))
+						status = FILE_FAILED;
+					uring_queue(&ring, IORING_OP_WRITE, out, ciphertext, length, offset, user_data | write_flag);
+				}
+				else
+				{
+					++written;
+					if (next < chunks)
+					{
+						const size_t next_offset = next * FILE_CHUNK_SIZE;
+						const size_t next_length = job->size - next_offset < FILE_CHUNK_SIZE ? job->size - next_offset
+																							 : FILE_CHUNK_SIZE;
+						uring_queue(&ring, IORING_OP_READ, in, plaintext, next_length, next_offset, slot | next << 8);
+						++next;
+					}
+				}
+
+				++head;
+			}
+			__atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+		}
+
+		const double start = seconds();
+		if (status == FILE_OK && fsync(out) != 0)
+		{
+			status = FILE_FAILED;
+		}
+		job->io_time += seconds() - start;
+
+		uring_free(&ring);
+		free(buffers);
+	}
+
+	if (in >= 0)
+		close(in);
+	if (out >= 0)
+		close(out);
+
+	return status;
+}
+
+/**
+ * Creates the input file with FILE_SIZE random bytes if it does not exist.
+ *
+ * @param path Path of the input file.
+ * @param size Output for the size of the file.
+ * @return True on success, otherwise false.
+ */
+static bool prepare_input(const char *path, size_t *size)
+{
+	struct stat st;
+
+	if (stat(path, &st) == 0)
+	{
+		*size = st.st_size;
+		return *size > 0;
+	}
+
+	printf("Creating %s with %lu MiB of random data...\n", path, FILE_SIZE >> 20);
+
+	uint8_t *buffer = malloc(FILE_CHUNK_SIZE);
+	int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	bool ok = buffer && fd >= 0;
+
+	if (ok)
+	{
+		random_bytes(buffer, FILE_CHUNK_SIZE);
+	}
+
+	for (size_t offset = 0; ok && offset < FILE_SIZE; offset += FILE_CHUNK_SIZE)
+	{
+		const size_t length = FILE_SIZE - offset < FILE_CHUNK_SIZE ? FILE_SIZE - offset : FILE_CHUNK_SIZE;
+		buffer[0] ^= (uint8_t)offset; // Avoid identical chunks for deduplicating file systems
+		ok = write(fd, buffer, length) == (ssize_t)length;
+	}
+
+	if (!ok)
+	{
+		printf("Error: creating %s failed: %s\n", path, strerror(errno));
+	}
+
+	if (fd >= 0)
+		close(fd);
+	free(buffer);
+	*size = FILE_SIZE;
+	return ok;
+}
+
+/**
+ * Encrypts the input file with every cipher of a library whose name contains
+ * CTR, XTS or GCM, once for every I/O path.
+ *
+ * @param crypto_library Pointer to the cryptographic library.
+ * @param input Path of the input file.
+ * @param output Path of the output file.
+ * @return True if the benchmark succeeds; otherwise, false.
+ */
+bool benchmark_file(const Crypto *crypto_library, const char *input, const char *output)
+{
+	static const char *paths[] = {"mmap", "pread/pwrite", "O_DIRECT", "io_uring"};
+	const char *name = crypto_library->name();
+	const char **ciphers = crypto_library->ciphers();
+	FileJob job = {crypto_library, NULL, input, output, 0, get_message_size()};
+	bool ok = prepare_input(input, &job.size);
+
+	job.scratch_in = malloc(job.piece);
+	job.scratch_out = malloc(job.piece + MAX_DIGEST_SIZE);
+
+	if (!ok || !job.scratch_in || !job.scratch_out || !crypto_library->init(&job.param))
+	{
+		printf("Error: [%s] file benchmark initialization failed!\n", name);
+		free(job.scratch_in);
+		free(job.scratch_out);
+		return false;
+	}
+
+	for (size_t i = 0; ciphers[i] != NULL; ++i)
+	{
+		const char *cipher = ciphers[i];
+		if (!strstr(cipher, "CTR") && !strstr(cipher, "XTS") && !strstr(cipher, "GCM"))
+		{
+			continue;
+		}
+
+		for (size_t p = 0; p < sizeof(paths) / sizeof(paths[0]); ++p)
+		{
+			if (!crypto_library->set_cipher(job.param, cipher))
+			{
+				printf("Error: [%s] failed to set %s, skipping it...\n", name, cipher);
+				ok = false;
+				break;
+			}
+
+			job.cipher_time = 0.0;
+			job.io_time = 0.0;
+
+			const double start = seconds();
+			const FileStatus status = p == 0 ? file_mmap(&job) : p == 3 ? file_io_uring(&job) : file_pread(&job, p == 2);
+			const double elapsed = seconds() - start;
+
+			if (status == FILE_UNSUPPORTED)
+			{
+				printf("[%s] %s %s: not supported on this system, skipped\n", name, cipher, paths[p]);
+			}
+			else if (status == FILE_FAILED)
+			{
+				printf("Error: [%s] %s %s failed!\n", name, cipher, paths[p]);
+				ok = false;
+			}
+			else
+			{
+				printf("[%s] %s %-12s %.3f GB/s, %.3f s: cipher %.3f s (%.1f%%), I/O wait %.3f s (%.1f%%)\n", name,
+					   cipher, paths[p], job.size / elapsed / 1e9, elapsed, job.cipher_time,
+					   100.0 * job.cipher_time / elapsed, job.io_time, 100.0 * job.io_time / elapsed);
+			}
+		}
+	}
+
+	crypto_library->free(job.param);
+	free(job.scratch_in);
+	free(job.scratch_out);
+	return ok;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "cbos.h"
+
+// Size of the input file that is created if it does not exist
+#ifndef FILE_SIZE
+#define FILE_SIZE (256UL << 20)
+#endif
+
+// Bytes read, encrypted and written at once, a multiple of 4096 for O_DIRECT
+#ifndef FILE_CHUNK_SIZE
+#define FILE_CHUNK_SIZE (1UL << 20)
+#endif
+
+// Chunks in flight on the io_uring path, at most 256
+#ifndef FILE_QUEUE_DEPTH
+#define FILE_QUEUE_DEPTH 8
+#endif
+
+/**
+ * @brief Encrypts a file into another file with the CTR, XTS and GCM ciphers
+ * of a library, once for every I/O path: mmap, pread/pwrite with double
+ * buffering, O_DIRECT and io_uring. Reports the end-to-end throughput and how
+ * the time splits between cipher and I/O wait.
+ *
+ * @param crypto_library Pointer to the cryptographic library.
+ * @param input Path of the input file, created with FILE_SIZE random bytes if
+ * it does not exist.
+ * @param output Path of the output file.
+ * @return True if the benchmark succeeds; otherwise, false.
+ */
+bool benchmark_file(const Crypto *crypto_library, const char *input, const char *output);
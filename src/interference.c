@@ -0,0 +1,430 @@
+#include <sched.h>
+#include <stdatomic.h>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "interference.h"
+#include "utils.h"
+
+// Smallest buffer of every antagonist, more than a last-level cache
+#define ANTAGONIST_MIN_BUFFER (64UL << 20)
+
+// Time the antagonists run before the measurement starts
+#define ANTAGONIST_WARMUP 0.1
+
+/**
+ * Where the antagonists run relative to the measured CPU
+ */
+typedef enum Placement
+{
+	PLACEMENT_SMT,	  // Other hardware thread of the same core
+	PLACEMENT_SOCKET, // Other core of the same socket
+	PLACEMENT_REMOTE, // Core of another socket
+	PLACEMENTS
+} Placement;
+
+static const char *placement_names[PLACEMENTS] = {"SMT sibling", "same socket", "remote socket"};
+
+/**
+ * What the antagonists do
+ */
+typedef enum Load
+{
+	LOAD_STREAM, // Copy through a buffer larger than the LLC
+	LOAD_LLC,	 // Touch random cache lines of a buffer larger than the LLC
+	LOAD_AVX512, // 512-bit fused multiply-adds
+	LOADS
+} Load;
+
+static const char *load_names[LOADS] = {"memory streaming", "LLC thrashing", "AVX-512"};
+
+/**
+ * State of one antagonist thread
+ */
+typedef struct Antagonist
+{
+	Load load;
+	int cpu;
+	uint8_t *buffer;
+	size_t size;
+	atomic_bool *stop;
+	atomic_int *started;
+	volatile uint64_t sink; // Keeps the work from being optimized away
+} Antagonist;
+
+/**
+ * Copies the first half of the buffer to the second half until stopped.
+ */
+static void stream_load(Antagonist *antagonist)
+{
+	const size_t half = antagonist->size / 2;
+	const size_t chunk = 1UL << 20;
+
+	while (!atomic_load_explicit(antagonist->stop, memory_order_relaxed))
+	{
+		for (size_t offset = 0; offset + chunk <= half; offset += chunk)
+		{
+			memcpy(antagonist->buffer + half + offset, antagonist->buffer + offset, chunk);
+			if (atomic_load_explicit(antagonist->stop, memory_order_relaxed))
+				break;
+		}
+	}
+}
+
+/**
+ * Increments random cache lines of the buffer until stopped, which evicts
+ * the lines of every other core sharing the LLC.
+ */
+static void llc_load(Antagonist *antagonist)
+{
+	const size_t lines = antagonist->size / 64;
+	uint64_t state = 0x9E3779B97F4A7C15ULL ^ (uint64_t)antagonist->cpu;
+
+	while (!atomic_load_explicit(antagonist->stop, memory_order_relaxed))
+	{
+		for (int i = 0; i < 4096; ++i)
+		{
+			state ^= state << 13;
+			state ^= state >> 7;
+			state ^= state << 17;
+			antagonist->buffer[(state % lines) * 64]++;
+		}
+	}
+}
+
+#if defined(__x86_64__)
+/**
+ * Runs independent 512-bit fused multiply-adds until stopped, which lowers
+ * the frequency license of the core.
+ */
+__attribute__((target("avx512f"))) static void avx512_load(Antagonist *antagonist)
+{
+	const __m512 factor = _mm512_set1_ps(0.999999f);
+	const __m512 addend = _mm512_set1_ps(1e-6f);
+	__m512 acc[8];
+
+	for (int i = 0; i < 8; ++i)
+	{
+		acc[i] = _mm512_set1_ps((float)i);
+	}
+
+	while (!atomic_load_explicit(antagonist->stop, memory_order_relaxed))
+	{
+		for (int n = 0; n < 4096; ++n)
+		{
+			for (int i = 0; i < 8; ++i)
+			{
+				acc[i] = _mm512_fmadd_ps(acc[i], factor, addend);
+			}
+		}
+	}
+
+	for (int i = 1; i < 8; ++i)
+	{
+		acc[0] = _mm512_add_ps(acc[0], acc[i]);
+	}
+	antagonist->sink = (uint64_t)_mm512_reduce_add_ps(acc[0]);
+}
+#endif
+
+/**
+ * @return True if the CPU executes AVX-512 instructions.
+ */
+static bool avx512_supported(void)
+{
+#if defined(__x86_64__)
+	return __builtin_cpu_supports("avx512f");
+#else
+	return false;
+#endif
+}
+
+/**
+ * Runs the load of an antagonist on its pinned CPU.
+ *
+ * @param arg Pointer to an Antagonist structure.
+ * @return NULL.
+ */
+static void *antagonist_thread(void *arg)
+{
+	Antagonist *antagonist = arg;
+
+	pin_thread(antagonist->cpu);
+	atomic_fetch_add(antagonist->started, 1);
+
+	switch (antagonist->load)
+	{
+	case LOAD_STREAM:
+		stream_load(antagonist);
+		break;
+	case LOAD_LLC:
+		llc_load(antagonist);
+		break;
+	case LOAD_AVX512:
+#if defined(__x86_64__)
+		avx512_load(antagonist);
+#endif
+		break;
+	default:
+		break;
+	}
+
+	return NULL;
+}
+
+/**
+ * Reads a value of /sys/devices/system/cpu/cpuN/topology.
+ *
+ * @param cpu The CPU.
+ * @param name File name, e.g. "core_id".
+ * @return The value, -1 if it cannot be read.
+ */
+static int topology(int cpu, const char *name)
+{
+	char path[128];
+	int value = -1;
+
+	snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/%s", cpu, name);
+
+	FILE *file = fopen(path, "r");
+	if (file)
+	{
+		if (fscanf(file, "%d", &value) != 1)
+			value = -1;
+		fclose(file);
+	}
+
+	return value;
+}
+
+/**
+ * Finds the CPUs of a placement relative to the measured CPU.
+ *
+ * @param placement The placement.
+ * @param measured The measured CPU.
+ * @param cpus Output for up to INTERFERENCE_ANTAGONISTS CPUs.
+ * @return Number of CPUs found.
+ */
+static int placement_cpus(Placement placement, int measured, int *cpus)
+{
+	const int package = topology(measured, "physical_package_id");
+	const int core = topology(measured, "core_id");
+	int count = 0;
+
+	for (int cpu = 0; cpu < cpu_count() && count < INTERFERENCE_ANTAGONISTS; ++cpu)
+	{
+		if (cpu == measured)
+			continue;
+
+		const bool same_package = topology(cpu, "physical_package_id") == package;
+		const bool same_core = same_package && topology(cpu, "core_id") == core;
+
+		if ((placement == PLACEMENT_SMT && same_core) || (placement == PLACEMENT_SOCKET && same_package && !same_core) ||
+			(placement == PLACEMENT_REMOTE && !same_package))
+		{
+			cpus[count++] = cpu;
+		}
+	}
+
+	return count;
+}
+
+/**
+ * Reads the size of the last-level cache of a CPU.
+ *
+ * @param cpu The CPU.
+ * @return Size in bytes, 0 if unknown.
+ */
+static size_t llc_size(int cpu)
+{
+	char path[128];
+	size_t size = 0;
+	char unit = '\0';
+
+	snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index3/size", cpu);
+
+	FILE *file = fopen(path, "r");
+	if (file)
+	{
+		if (fscanf(file, "%zu%c", &size, &unit) < 1)
+			size = 0;
+		fclose(file);
+	}
+
+	return unit == 'K' ? size << 10 : unit == 'M' ? size << 20 : size;
+}
+
+/**
+ * Encrypts INTERFERENCE_ITERATIONS messages on the calling thread and
+ * measures every call.
+ *
+ * @param crypto_library Pointer to the cryptographic library.
+ * @param param The context with the cipher already set.
+ * @param message_size Size of every message.
+ * @param dst Output buffer.
+ * @param src Input message.
+ * @param latencies Output for the sorted latencies.
+ * @param bytes_per_second Output for the throughput.
+ * @return True on success, otherwise false.
+ */
+static bool measure_calls(const Crypto *crypto_library, void *param, const size_t message_size, uint8_t *dst,
+						  const uint8_t *src, double *latencies, double *bytes_per_second)
+{
+	const double start = seconds();
+
+	for (size_t i = 0; i < INTERFERENCE_ITERATIONS; ++i)
+	{
+		const double call_start = seconds();
+		if (!crypto_library->encrypt(param, message_size, dst, src))
+		{
+			return false;
+		}
+		latencies[i] = seconds() - call_start;
+	}
+
+	*bytes_per_second = INTERFERENCE_ITERATIONS * message_size / (seconds() - start);
+	sort_samples(latencies, INTERFERENCE_ITERATIONS);
+	return true;
+}
+
+/**
+ * Benchmarks every cipher of a library without and with antagonists.
+ *
+ * @param crypto_library Pointer to the cryptographic library.
+ * @param message_size Size of every message.
+ * @return True if the benchmark succeeds; otherwise, false.
+ */
+bool benchmark_interference(const Crypto *crypto_library, const size_t message_size)
+{
+	const char *name = crypto_library->name();
+	const int measured = INTERFERENCE_CPU % cpu_count();
+	const size_t buffer_size = 2 * llc_size(measured) > ANTAGONIST_MIN_BUFFER ? 2 * llc_size(measured)
+																			   : ANTAGONIST_MIN_BUFFER;
+	int cpus[PLACEMENTS][INTERFERENCE_ANTAGONISTS];
+	int counts[PLACEMENTS];
+	bool ok = true;
+
+	pin_thread(measured);
+
+	for (int p = 0; p < PLACEMENTS; ++p)
+	{
+		counts[p] = placement_cpus(p, measured, cpus[p]);
+		if (counts[p] == 0)
+			printf("[%s] no CPU on the %s of CPU %d, skipped\n", name, placement_names[p], measured);
+	}
+
+	if (!avx512_supported())
+	{
+		printf("[%s] the CPU does not support AVX-512, skipped\n", name);
+	}
+
+	void *param = NULL;
+	uint8_t *src = malloc(message_size);
+	uint8_t *dst = malloc(message_size + MAX_DIGEST_SIZE);
+	double *baseline = malloc(INTERFERENCE_ITERATIONS * sizeof(double));
+	double *latencies = malloc(INTERFERENCE_ITERATIONS * sizeof(double));
+	uint8_t *buffers = malloc(INTERFERENCE_ANTAGONISTS * buffer_size);
+
+	// A failing cipher is skipped, only a failed initialization ends the benchmark
+	const bool ready = src && dst && baseline && latencies && buffers && crypto_library->init(&param) &&
+					   crypto_library->random(param, message_size, src);
+
+	if (!ready)
+	{
+		printf("Error: [%s] interference benchmark initialization failed!\n", name);
+		ok = false;
+	}
+	else
+	{
+		// Fault the pages in before any measurement
+		memset(buffers, 1, INTERFERENCE_ANTAGONISTS * buffer_size);
+	}
+
+	const char **ciphers = crypto_library->ciphers();
+	for (size_t i = 0; ready && ciphers[i] != NULL; ++i)
+	{
+		const char *cipher = ciphers[i];
+		double unloaded = 0.0;
+
+		if (!crypto_library->set_cipher(param, cipher))
+		{
+			printf("Error: [%s] failed to set %s, skipping it...\n", name, cipher);
+			ok = false;
+			continue;
+		}
+
+		printf("[%s] running %s interference benchmark on CPU %d...\n", name, cipher, measured);
+
+		if (!measure_calls(crypto_library, param, message_size, dst, src, baseline, &unloaded))
+		{
+			printf("Error: [%s] %s failed!\n", name, cipher);
+			ok = false;
+			continue;
+		}
+
+		const double p99 = percentile(baseline, INTERFERENCE_ITERATIONS, 99);
+		const double p999 = percentile(baseline, INTERFERENCE_ITERATIONS, 99.9);
+
+		printf("[%s] %s unloaded: %.1f MB/s, p50 %.2f us, p99 %.2f us, p99.9 %.2f us\n", name, cipher, unloaded / 1e6,
+			   1e6 * percentile(baseline, INTERFERENCE_ITERATIONS, 50), 1e6 * p99, 1e6 * p999);
+
+		for (int p = 0; p < PLACEMENTS; ++p)
+		{
+			for (int l = 0; l < LOADS && counts[p] > 0; ++l)
+			{
+				if (l == LOAD_AVX512 && !avx512_supported())
+					continue;
+
+				Antagonist antagonists[INTERFERENCE_ANTAGONISTS];
+				pthread_t ids[INTERFERENCE_ANTAGONISTS];
+				atomic_bool stop = false;
+				atomic_int started = 0;
+				double loaded = 0.0;
+
+				for (int a = 0; a < counts[p]; ++a)
+				{
+					antagonists[a] = (Antagonist){l, cpus[p][a], buffers + a * buffer_size, buffer_size, &stop, &started, 0};
+					pthread_create(&ids[a], NULL, antagonist_thread, &antagonists[a]);
+				}
+
+				while (atomic_load(&started) < counts[p])
+					sched_yield();
+				wait_until(seconds() + ANTAGONIST_WARMUP);
+
+				const bool measured_ok = measure_calls(crypto_library, param, message_size, dst, src, latencies, &loaded);
+
+				atomic_store(&stop, true);
+				for (int a = 0; a < counts[p]; ++a)
+					pthread_join(ids[a], NULL);
+
+				if (!measured_ok)
+				{
+					printf("Error: [%s] %s failed under %s!\n", name, cipher, load_names[l]);
+					ok = false;
+					continue;
+				}
+
+				const double loaded_p99 = percentile(latencies, INTERFERENCE_ITERATIONS, 99);
+				const double loaded_p999 = percentile(latencies, INTERFERENCE_ITERATIONS, 99.9);
+
+				printf("[%s] %s with %s on the %s: %.1f MB/s (%.1f%% of unloaded), p99 %.2f us (%.2fx), p99.9 %.2f us "
+					   "(%.2fx)\n",
+					   name, cipher, load_names[l], placement_names[p], loaded / 1e6, 100.0 * loaded / unloaded,
+					   1e6 * loaded_p99, loaded_p99 / p99, 1e6 * loaded_p999, loaded_p999 / p999);
+			}
+		}
+	}
+
+	if (param)
+	{
+		crypto_library->free(param);
+	}
+	free(src);
+	free(dst);
+	free(baseline);
+	free(latencies);
+	free(buffers);
+
+	return ok;
+}
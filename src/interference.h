@@ -0,0 +1,33 @@
+#pragma once
+
+#include "cbos.h"
+
+// Encrypt calls measured per cipher and antagonist
+#ifndef INTERFERENCE_ITERATIONS
+#define INTERFERENCE_ITERATIONS 200000
+#endif
+
+// Antagonist threads per placement, limited to the CPUs of the placement
+#ifndef INTERFERENCE_ANTAGONISTS
+#define INTERFERENCE_ANTAGONISTS 1
+#endif
+
+// CPU of the measured thread
+#ifndef INTERFERENCE_CPU
+#define INTERFERENCE_CPU 0
+#endif
+
+/**
+ * @brief Benchmarks every cipher of a library while antagonist threads load
+ * the machine. Antagonists stream through memory, thrash the last-level cache
+ * or run AVX-512 arithmetic, each on the SMT sibling of the measured CPU, on
+ * another core of its socket or on a remote socket, as read from
+ * /sys/devices/system/cpu/cpuN/topology. Reports throughput and tail latency
+ * relative to an unloaded run; placements without a matching CPU and AVX-512
+ * on CPUs without it are skipped.
+ *
+ * @param crypto_library Pointer to the cryptographic library.
+ * @param message_size Size of every message.
+ * @return True if the benchmark succeeds; otherwise, false.
+ */
+bool benchmark_interference(const Crypto *crypto_library, const size_t message_size);
@@ -1,18 +1,322 @@
+#include "alloc.h"
+#include "capture.h"
 #include "cbos.h"
+#include "daemon.h"
+#include "fileio.h"
+#include "interference.h"
+#include "nodes.h"
+#include "openloop.h"
+#include "pipeline.h"
+#include "pubkey.h"
+#include "rekey.h"
+#include "rng.h"
+#include "schedule.h"
+#include "sector.h"
+#include "stats.h"
+#include "stream.h"
+#include "timeseries.h"
 #include "utils.h"
+#include "verify.h"
+
+// Alternating repeats of the dispatched and the direct loop, odd for a single median
+#ifndef DISPATCH_REPEATS
+#define DISPATCH_REPEATS 5
+#endif
+
+/**
+ * Signature of the measured operations of a library, i.e. Crypto::encrypt and
+ * Crypto::digest.
+ */
+typedef size_t (*Operation)(void *param, const size_t size, void *dst, const void *src);
+typedef size_t (*OperationLoop)(void *param, const size_t size, void *dst, const void *src, const size_t iterations);
 
 /**
- * Main benchmarking function. It monitors the encryption process over time,
- * calculates CPU cycles used in the encryption process and evaluates performance
- * metrics, including the average bytes per cycle, variance, and standard deviation.
+ * Measures the per-call cost of the dispatch through `operation` against its
+ * batch version. Both run warm, after the first timed loop, and alternate
+ * DISPATCH_REPEATS times with an equal share of the iterations, so frequency
+ * changes and other load hit both alike. The loop that runs first swaps
+ * every repeat. The overhead is the median of the differences of the two
+ * loops of every repeat, with 1.4826 MAD of the differences as noise floor;
+ * an overhead within the noise floor is reported as such, not as a number.
+ *
+ * @param name Name of the library.
+ * @param operation The operation to measure.
+ * @param operation_loop Batch version of the operation.
+ * @param param The parameters of the library.
+ * @param message_size Size of the message.
+ * @param iterations Number of benchmark iterations.
+ * @param dst Output buffer.
+ * @param src Input message.
+ *
+ * @return True if both loops succeed; otherwise, false.
+ */
+static bool measure_dispatch(const char *name, Operation operation, OperationLoop operation_loop, void *param,
+							 const size_t message_size, const size_t iterations, uint8_t *dst, const uint8_t *src)
+{
+	const size_t chunk = iterations / DISPATCH_REPEATS ? iterations / DISPATCH_REPEATS : 1;
+	double dispatched[DISPATCH_REPEATS], direct[DISPATCH_REPEATS], differences[DISPATCH_REPEATS];
+	double fastest_direct = 0.0;
+
+	for (int run = 0; run < 2 * DISPATCH_REPEATS; ++run)
+	{
+		// The loop that runs first swaps every repeat
+		const bool run_direct = (run + run / 2) % 2;
+		const double start = seconds();
+		size_t completed = 0;
+
+		if (run_direct)
+		{
+			completed = operation_loop(param, message_size, dst, src, chunk);
+		}
+		else
+		{
+			while (completed < chunk && operation(param, message_size, dst, src))
+			{
+				++completed;
+			}
+		}
+		const double elapsed = seconds() - start;
+
+		if (completed != chunk)
+		{
+			printf("Error: [%s] %s loop failed after %zu iterations!\n", name, run_direct ? "direct" : "dispatched",
+				   completed);
+			return false;
+		}
+
+		if (run_direct)
+		{
+			direct[run / 2] = elapsed;
+			if (run < 2 || elapsed < fastest_direct)
+				fastest_direct = elapsed;
+		}
+		else
+		{
+			dispatched[run / 2] = elapsed;
+		}
+	}
+
+	for (int repeat = 0; repeat < DISPATCH_REPEATS; ++repeat)
+	{
+		differences[repeat] = 1e9 * (dispatched[repeat] - direct[repeat]) / chunk;
+	}
+
+	const double overhead = sample_median(differences, DISPATCH_REPEATS);
+	for (int repeat = 0; repeat < DISPATCH_REPEATS; ++repeat)
+	{
+		differences[repeat] = fabs(differences[repeat] - overhead);
+	}
+	const double noise = 1.4826 * sample_median(differences, DISPATCH_REPEATS);
+
+	printf("[%s] %f seconds for %zu iterations with direct dispatch (best of %d), ", name, fastest_direct, chunk,
+		   DISPATCH_REPEATS);
+	if (overhead <= noise)
+	{
+		printf("dispatch overhead below the noise floor of %.2f ns/call\n", noise);
+	}
+	else
+	{
+		printf("%.2f ns/call dispatch overhead, noise floor %.2f ns/call (median of %d paired repeats)\n", overhead,
+			   noise, DISPATCH_REPEATS);
+	}
+	return true;
+}
+
+/**
+ * Benchmarks one algorithm that is already set up in `param`. It monitors the
+ * operation over time, calculates CPU cycles used per call and evaluates
+ * performance metrics, including the average bytes per cycle, variance, and
+ * standard deviation.
+ *
+ * @param name Name of the library.
+ * @param algorithm Name of the cipher, hash or MAC.
+ * @param operation The operation to measure.
+ * @param operation_loop Optional batch version of the operation, may be NULL.
+ * @param param The parameters of the library.
+ * @param message_size Size of the message.
+ * @param iterations Number of benchmark iterations.
+ * @param dst Output buffer.
+ * @param src Input message.
+ * @param results List the result is appended to.
+ * @param capture Raw sample file every cycle sample is appended to, may be NULL.
+ *
+ * @return True if the benchmark succeeds; otherwise, false.
+ */
+static bool measure(const char *name, const char *algorithm, Operation operation, OperationLoop operation_loop,
+					void *param, const size_t message_size, const size_t iterations, uint8_t *dst, const uint8_t *src,
+					Results *results, Capture *capture)
+{
+	bool ok = true;
+
+	// Create a progress thread to monitor the benchmark progress
+	pthread_t progress_thread;
+	Progress progress;
+	progress.iterations_total = iterations;
+	progress.iterations_completed = 0;
+	progress.lib_name = name;
+
+	printf("[%s] running %s benchmark...\n", name, algorithm);
+
+	const double start = seconds();
+	progress.start_time = start;
+
+	pthread_create(&progress_thread, NULL, progress_function, &progress);
+
+	// Count heap allocations on the hot path, free when nothing is allocated
+	const AllocStats alloc_start = alloc_stats();
+	alloc_tracking(true);
+
+	// Perform the operation for the specified number of iterations
+	for (size_t i = 0; i < iterations; ++i)
+	{
+		size_t ret = operation(param, message_size, dst, src);
+		if (!ret)
+		{
+			printf("Error: [%s] %s failed!\n", name, algorithm);
+			ok = false;
+			progress.iterations_completed = iterations;
+			break;
+		}
+		progress.iterations_completed = i;
+	}
+
+	const double elapsed = seconds() - start;
+
+	alloc_tracking(false);
+	const AllocStats alloc_end = alloc_stats();
+
+	pthread_join(progress_thread, NULL);
+	if (!ok)
+	{
+		return false;
+	}
+	printf("[%s] %f seconds for %zu iterations, %zu bytes message\n", name, elapsed, iterations, message_size);
+	printf("[%s] %.3f allocations and %.1f bytes allocated per call\n", name,
+		   (double)(alloc_end.allocations - alloc_start.allocations) / iterations,
+		   (double)(alloc_end.allocated_bytes - alloc_start.allocated_bytes) / iterations);
+
+	// Repeat the loop without per-call dispatch to quantify its cost
+	if (operation_loop && !measure_dispatch(name, operation, operation_loop, param, message_size, iterations, dst, src))
+	{
+		ok = false;
+	}
+
+	// Measure the performance of a computation process.
+	double *bytes_per_cycle = malloc(iterations * sizeof(double));
+	WindowCounters *windows = malloc((iterations + STATS_WINDOW - 1) / STATS_WINDOW * sizeof(WindowCounters));
+	WindowCounters window_start, window_end;
+	long cycles_start, cycles_end, cycles_used;
+	double total_bytes_per_cycle = 0.0;
+
+	if (!bytes_per_cycle || !windows)
+	{
+		printf("Error: [%s] failed to allocate %zu samples!\n", name, iterations);
+		free(bytes_per_cycle);
+		free(windows);
+		return false;
+	}
+
+	const int series = capture ? capture_series(capture, name, algorithm) : -1;
+	if (capture && series < 0)
+	{
+		printf("Error: [%s] no series left to capture %s!\n", name, algorithm);
+	}
+
+#ifdef __aarch64__
+	ccnt_init();
+#endif
+
+	for (int test = 0; test < iterations; ++test)
+	{
+		// Interrupts and rusage are read per window, outside of the counted cycles
+		if (test % STATS_WINDOW == 0)
+		{
+			window_counters(&window_start);
+
+			// One discarded call refills the caches and TLB that reading the counters evicted
+			if (!operation(param, message_size, dst, src))
+			{
+				printf("Error: [%s] %s failed!\n", name, algorithm);
+				ok = false;
+				break;
+			}
+		}
+
+		cycles_start = timestamp();
+		size_t ret = operation(param, message_size, dst, src);
+		cycles_end = timestamp();
+		if (!ret)
+		{
+			printf("Error: [%s] %s failed!\n", name, algorithm);
+			ok = false;
+			break;
+		}
+
+		cycles_used = cycles_end - cycles_start;
+
+		// Stored outside of the counted cycles
+		if (series >= 0)
+		{
+			capture_add(capture, series, capture_now_ns(), (uint32_t)cycles_used, message_size, 0);
+		}
+
+		// Calculate bytes/cycle for this test round
+		bytes_per_cycle[test] = (double)message_size / (double)cycles_used;
+		total_bytes_per_cycle += (double)bytes_per_cycle[test];
+
+		if ((test + 1) % STATS_WINDOW == 0 || test + 1 == iterations)
+		{
+			window_counters(&window_end);
+			windows[test / STATS_WINDOW] = window_delta(&window_start, &window_end);
+		}
+	}
+
+	double variance = 0.0;
+	double average_bytes_per_cycle = total_bytes_per_cycle / iterations;
+
+	for (int i = 0; i < iterations; ++i)
+	{
+		variance += pow(bytes_per_cycle[i] - average_bytes_per_cycle, 2);
+	}
+	variance /= iterations;
+
+	double std_deviation = sqrt(variance);
+
+	printf("[%s] Average Bytes/cycle count: %lf \n", name, average_bytes_per_cycle);
+	printf("[%s] Variance: %lf\n", name, variance);
+	printf("[%s] Standard Deviation: %lf\n", name, std_deviation);
+
+	if (ok)
+	{
+		print_robust_stats(name, bytes_per_cycle, iterations, windows, "bytes/cycle");
+	}
+
+	free(bytes_per_cycle);
+	free(windows);
+
+	Result result = {name, algorithm, message_size, iterations, elapsed, average_bytes_per_cycle, std_deviation};
+	if (!results_add(results, &result))
+	{
+		printf("Error: [%s] failed to store the result of %s!\n", name, algorithm);
+	}
+
+	return ok;
+}
+
+/**
+ * Main benchmarking function. It benchmarks every cipher and, if the library
+ * supports them, every hash and MAC function of a library.
  *
  * @param crypto_library Pointer to the cryptographic library and ciphers.
  * @param message_size Size of the message to encrypt.
  * @param iterations Number of benchmark iterations.
+ * @param results List the result of every benchmarked algorithm is appended to.
+ * @param capture Raw sample file every cycle sample is appended to, may be NULL.
  *
  * @return True if the benchmark succeeds; otherwise, false.
  */
-bool benchmark(const Crypto *crypto_library, const size_t message_size, const size_t iterations)
+bool benchmark(const Crypto *crypto_library, const size_t message_size, const size_t iterations, Results *results,
+			   Capture *capture)
 {
 	bool ok = true;
 
@@ -29,123 +333,438 @@ bool benchmark(const Crypto *crypto_library, const size_t message_size, const si
 
 	const char *name = crypto_library->name();
 
+	// Several libraries share the process, each one reports its own peak
+	const bool own_peak = reset_peak_rss();
+
+	// The context is measured as the heap it holds after init and set_cipher
+	const AllocStats context_start = alloc_stats();
 	void *cipher_parameters = NULL;
-	if (!crypto_library->init(&cipher_parameters))
+
+	alloc_tracking(true);
+	const bool initialized = crypto_library->init(&cipher_parameters);
+	alloc_tracking(false);
+
+	if (!initialized)
 	{
 		printf("Error: [%s] cipher parameters initialization failed!\n", name);
 		return !ok;
 	}
 
+	// The output buffer also has to hold digests of messages shorter than a digest
 	uint8_t *src = malloc(message_size);
-	uint8_t *dst = malloc(message_size);
+	uint8_t *dst = malloc(message_size + MAX_DIGEST_SIZE);
 
 	if (!crypto_library->random(cipher_parameters, message_size, src))
 	{
 		printf("Error: [%s] input randomization failed!\n", name);
 	}
 
+	const AllocStats init_end = alloc_stats();
+	printf("[%s] init made %zu allocations, the context holds %lld bytes\n", name,
+		   init_end.allocations - context_start.allocations, init_end.live_bytes - context_start.live_bytes);
+
 	const char **ciphers = crypto_library->ciphers();
 	for (size_t i = 0; ciphers[i] != NULL; ++i)
 	{
 		const char *cipher = ciphers[i];
-		if (!crypto_library->set_cipher(cipher_parameters, cipher))
+		const AllocStats set_start = alloc_stats();
+
+		alloc_tracking(true);
+		const bool set = crypto_library->set_cipher(cipher_parameters, cipher);
+		alloc_tracking(false);
+
+		if (!set)
 		{
 			printf("Error: [%s] failed to set %s, skipping it...\n", name, cipher);
 			continue;
 		}
 
-		// Create a progress thread to monitor the benchmark progress
-		pthread_t progress_thread;
-		Progress progress;
-		progress.iterations_total = iterations;
-		progress.lib_name = name;
+		const AllocStats set_end = alloc_stats();
+		printf("[%s] %s: set_cipher made %zu allocations (%zu bytes), the context holds %lld bytes\n", name, cipher,
+			   set_end.allocations - set_start.allocations, set_end.allocated_bytes - set_start.allocated_bytes,
+			   set_end.live_bytes - context_start.live_bytes);
 
-		printf("[%s] running %s benchmark...\n", name, cipher);
+		// Known answers and the other libraries are checked with an own context, the timed one is checked after its loops
+		Verification verification;
+		if (!verify_cipher(crypto_library, cipher, message_size, &verification))
+		{
+			printf("Error: [%s] %s failed its verification, skipping it...\n", name, cipher);
+			ok = false;
+			continue;
+		}
+		else if (!verification.verifiable)
+		{
+			printf("[%s] %s: not verifiable, no set_key or unknown key and IV sizes\n", name, cipher);
+		}
+		else
+		{
+			printf("[%s] %s: verified with %zu known answer(s)%s%s%s%s\n", name, cipher, verification.known_answers,
+				   verification.round_trip ? ", decrypted" : "", verification.same_as ? ", same ciphertext as [" : "",
+				   verification.same_as ? verification.same_as : "", verification.same_as ? "]" : "");
+		}
 
-		pthread_create(&progress_thread, NULL, progress_function, &progress);
+		const size_t stored = results->count;
+		if (!measure(name, cipher, crypto_library->encrypt, crypto_library->encrypt_loop, cipher_parameters,
+					 message_size, iterations, dst, src, results, capture))
+		{
+			ok = false;
+		}
 
-		const double start = seconds();
-		progress.start_time = start;
+		if (!verify_context(crypto_library, cipher_parameters, message_size, &verification))
+		{
+			printf("Error: [%s] %s failed its verification after the benchmark, dropping its result...\n", name,
+				   cipher);
+			results->count = stored;
+			ok = false;
+		}
+	}
+
+	const char **digests = crypto_library->digests ? crypto_library->digests() : NULL;
+	for (size_t i = 0; digests && digests[i] != NULL; ++i)
+	{
+		const char *digest = digests[i];
+		if (!crypto_library->set_digest(cipher_parameters, digest))
+		{
+			printf("Error: [%s] failed to set %s, skipping it...\n", name, digest);
+			continue;
+		}
 
-		// Perform encryption for the specified number of iterations
-		for (size_t i = 0; i < iterations; ++i)
+		if (!measure(name, digest, crypto_library->digest, NULL, cipher_parameters, message_size, iterations, dst,
+					 src, results, capture))
 		{
-			size_t ret = crypto_library->encrypt(cipher_parameters, message_size, dst, src);
-			if (!ret)
+			ok = false;
+		}
+	}
+
+	crypto_library->free(cipher_parameters);
+
+	free(src);
+	free(dst);
+
+	printf("[%s] peak RSS %ld KiB%s\n", name, peak_rss_kib(), own_peak ? "" : " (process-wide)");
+
+	return ok;
+}
+
+/**
+ * Prints the results of all libraries side by side, one row per algorithm and
+ * one column per library. Rows list the throughput of each library relative to
+ * the first library that benchmarked the algorithm.
+ *
+ * @param results The results of all benchmarked libraries.
+ */
+void print_summary(const Results *results)
+{
+	const char *libs[results->count];
+	size_t lib_count = 0;
+
+	for (size_t i = 0; i < results->count; ++i)
+	{
+		size_t j = 0;
+		while (j < lib_count && strcmp(libs[j], results->items[i].lib_name) != 0)
+			++j;
+		if (j == lib_count)
+			libs[lib_count++] = results->items[i].lib_name;
+	}
+
+	printf("\nSummary (Bytes/cycle relative to the first library, time per call):\n");
+	printf("%-24s", "Algorithm");
+	for (size_t j = 0; j < lib_count; ++j)
+		printf(" | %-36s", libs[j]);
+	printf("\n");
+
+	for (size_t i = 0; i < results->count; ++i)
+	{
+		const char *algorithm = results->items[i].algorithm;
+
+		// Print every algorithm once, at its first occurrence
+		size_t first = 0;
+		while (strcmp(results->items[first].algorithm, algorithm) != 0)
+			++first;
+		if (first != i)
+			continue;
+
+		printf("%-24s", algorithm);
+		for (size_t j = 0; j < lib_count; ++j)
+		{
+			const Result *match = NULL;
+			for (size_t k = i; k < results->count && !match; ++k)
 			{
-				printf("Error: [%s] encryption failed!\n", name);
-				ok = false;
-				break;
+				if (strcmp(results->items[k].algorithm, algorithm) == 0 &&
+					strcmp(results->items[k].lib_name, libs[j]) == 0)
+					match = &results->items[k];
 			}
-			progress.iterations_completed = i;
+
+			char cell[64] = "-";
+			if (match)
+				snprintf(cell, sizeof(cell), "%9.4lf (%7.2lf%%) %10.1lf ns", match->bytes_per_cycle,
+						 100.0 * match->bytes_per_cycle / results->items[first].bytes_per_cycle,
+						 1e9 * match->elapsed_time / match->iterations);
+			printf(" | %-36s", cell);
 		}
+		printf("\n");
+	}
+}
 
-		const double elapsed = seconds() - start;
+/**
+ * Prints the command line usage.
+ *
+ * @param program Name of the executable.
+ */
+static void usage(const char *program)
+{
+	printf("Usage: %s [mode]\n", program);
+	printf("  (no mode)                    closed-loop cipher, digest, public-key and RNG benchmarks\n");
+	printf("  open-loop [poisson|constant] latency versus offered load with a worker pool\n");
+	printf("  pipeline                     producer, encrypt and consumer stages over lock-free rings\n");
+	printf("  file [input [output]]        encrypt a file with mmap, pread/pwrite, O_DIRECT and io_uring\n");
+	printf("  stream                       one message encrypted in updates of 16 bytes to 64 KiB\n");
+	printf("  schedule [jobs [seed]]       cipher matrix in random order, every run in a pinned child process\n");
+	printf("  interference                 memory, LLC and AVX-512 antagonists on the SMT sibling and other cores\n");
+	printf("  timeseries [csv|prometheus [file]] per-second throughput, frequency and temperature of a sustained load\n");
+	printf("  capture [file]               closed-loop cipher and digest benchmarks with every raw sample stored\n");
+	printf("  rekey                        throughput with a new key every N messages or N bytes\n");
+	printf("  numa [node|core]             one worker process per NUMA node or core with local and remote memory\n");
+	printf("  sector                       XTS encryption of 512-byte and 4096-byte sectors with their sector numbers\n");
+	printf("  daemon [socket [ciphers]]    run the matrix until SIGTERM, JSON snapshots on a Unix socket\n");
+	printf("  query [socket]               print the current snapshot of a running daemon\n");
+	printf("  tail [socket]                print a snapshot of a running daemon after every round\n");
+	printf("  verify [file]                known answers of every cipher and ciphertexts compared across executables\n");
+}
 
-		pthread_join(progress_thread, NULL);
-		printf("[%s] %f seconds for %zu iterations, %zu bytes message\n", name, elapsed, iterations, message_size);
+int main(int argc, char **argv)
+{
 
-		// Measure the performance of a computation process.
-		double bytes_per_cycle[iterations];
-		long cycles_start, cycles_end, cycles_used;
-		double total_bytes_per_cycle = 0.0;
+	bool ok = true;
+	Results results = {0};
 
-#ifdef __aarch64__
-		ccnt_init();
-#endif
+	const Crypto **libs = get_libs();
+	if (!libs[0])
+	{
+		fprintf(stderr, "Error: no crypto library is registered.\n");
+		return 1;
+	}
 
-		for (int test = 0; test < iterations; ++test)
+	if (argc > 1 && strcmp(argv[1], "open-loop") == 0)
+	{
+		Arrival arrival = ARRIVAL_POISSON;
+		if (argc > 2 && strcmp(argv[2], "constant") == 0)
+		{
+			arrival = ARRIVAL_CONSTANT;
+		}
+		else if (argc > 2 && strcmp(argv[2], "poisson") != 0)
 		{
+			usage(argv[0]);
+			return 1;
+		}
 
-			cycles_start = timestamp();
-			size_t ret = crypto_library->encrypt(cipher_parameters, message_size, dst, src);
-			cycles_end = timestamp();
-			if (!ret)
-			{
-				printf("Error: [%s] encryption failed!\n", name);
-				ok = false;
-				break;
-			}
+		for (size_t i = 0; libs[i] != NULL; ++i)
+		{
+			ok = benchmark_open_loop(libs[i], get_message_size(), arrival) && ok;
+		}
+
+		return !ok;
+	}
+	else if (argc > 1 && strcmp(argv[1], "pipeline") == 0)
+	{
+		for (size_t i = 0; libs[i] != NULL; ++i)
+		{
+			ok = benchmark_pipeline(libs[i], get_message_size()) && ok;
+		}
+
+		return !ok;
+	}
+	else if (argc > 1 && strcmp(argv[1], "file") == 0)
+	{
+		const char *input = argc > 2 ? argv[2] : "cbos_input.bin";
+		const char *output = argc > 3 ? argv[3] : "cbos_output.bin";
+
+		for (size_t i = 0; libs[i] != NULL; ++i)
+		{
+			ok = benchmark_file(libs[i], input, output) && ok;
+		}
+
+		return !ok;
+	}
+	else if (argc > 1 && strcmp(argv[1], "stream") == 0)
+	{
+		for (size_t i = 0; libs[i] != NULL; ++i)
+		{
+			ok = benchmark_stream(libs[i]) && ok;
+		}
+
+		return !ok;
+	}
+	else if (argc > 1 && strcmp(argv[1], "schedule") == 0)
+	{
+		const int jobs = argc > 2 ? atoi(argv[2]) : 0;
+		unsigned int seed = 0;
+
+		if (argc > 3)
+		{
+			seed = (unsigned int)strtoul(argv[3], NULL, 10);
+		}
+		else
+		{
+			random_bytes((uint8_t *)&seed, sizeof(seed));
+		}
+
+		return !benchmark_schedule(libs, jobs, seed);
+	}
+	else if (argc > 1 && strcmp(argv[1], "interference") == 0)
+	{
+		for (size_t i = 0; libs[i] != NULL; ++i)
+		{
+			ok = benchmark_interference(libs[i], get_message_size()) && ok;
+		}
 
-			cycles_used = cycles_end - cycles_start;
+		return !ok;
+	}
+	else if (argc > 1 && strcmp(argv[1], "timeseries") == 0)
+	{
+		SeriesFormat format = SERIES_CSV;
+		const char *path = "cbos_timeseries.csv";
 
-			// Calculate bytes/cycle for this test round
-			bytes_per_cycle[test] = (double)message_size / (double)cycles_used;
-			total_bytes_per_cycle += (double)bytes_per_cycle[test];
+		if (argc > 2 && strcmp(argv[2], "prometheus") == 0)
+		{
+			format = SERIES_PROMETHEUS;
+			path = "cbos_timeseries.prom";
+		}
+		else if (argc > 2 && strcmp(argv[2], "csv") != 0)
+		{
+			usage(argv[0]);
+			return 1;
 		}
 
-		double variance = 0.0;
-		double average_bytes_per_cycle = total_bytes_per_cycle / iterations;
+		return !benchmark_timeseries(libs, get_message_size(), format, argc > 3 ? argv[3] : path);
+	}
+	else if (argc > 1 && strcmp(argv[1], "capture") == 0)
+	{
+		const char *path = argc > 2 ? argv[2] : "cbos_samples.bin";
+		size_t algorithms = 0;
+		Capture capture;
 
-		for (int i = 0; i < iterations; ++i)
+		// Exactly one record per measured call of every cipher and digest
+		for (size_t i = 0; libs[i] != NULL; ++i)
 		{
-			variance += pow(bytes_per_cycle[i] - average_bytes_per_cycle, 2);
+			const char **ciphers = libs[i]->ciphers();
+			const char **digests = libs[i]->digests ? libs[i]->digests() : NULL;
+			for (size_t j = 0; ciphers[j] != NULL; ++j)
+				++algorithms;
+			for (size_t j = 0; digests && digests[j] != NULL; ++j)
+				++algorithms;
 		}
-		variance /= iterations;
 
-		double std_deviation = sqrt(variance);
+		if (!capture_open(&capture, path, algorithms * get_iterations()))
+		{
+			return 1;
+		}
+
+		for (size_t i = 0; libs[i] != NULL; ++i)
+		{
+			ok = benchmark(libs[i], get_message_size(), get_iterations(), &results, &capture) && ok;
+		}
 
-		printf("[%s] Average Bytes/cycle count: %lf \n", name, average_bytes_per_cycle);
-		printf("[%s] Variance: %lf\n", name, variance);
-		printf("[%s] Standard Deviation: %lf\n", name, std_deviation);
+		printf("%zu samples written to %s", capture.count, path);
+		if (capture.dropped > 0)
+			printf(", %zu dropped", capture.dropped);
+		printf("\n");
+
+		ok = capture_close(&capture) && ok;
+
+		if (libs[1] && results.count > 0)
+		{
+			print_summary(&results);
+		}
+
+		results_free(&results);
+		return !ok;
 	}
+	else if (argc > 1 && strcmp(argv[1], "rekey") == 0)
+	{
+		for (size_t i = 0; libs[i] != NULL; ++i)
+		{
+			ok = benchmark_rekey(libs[i], get_message_size()) && ok;
+		}
 
-	crypto_library->free(cipher_parameters);
+		return !ok;
+	}
+	else if (argc > 1 && strcmp(argv[1], "numa") == 0)
+	{
+		NodeWorkers workers = WORKERS_PER_NODE;
+		if (argc > 2 && strcmp(argv[2], "core") == 0)
+		{
+			workers = WORKERS_PER_CORE;
+		}
+		else if (argc > 2 && strcmp(argv[2], "node") != 0)
+		{
+			usage(argv[0]);
+			return 1;
+		}
 
-	free(src);
-	free(dst);
+		for (size_t i = 0; libs[i] != NULL; ++i)
+		{
+			ok = benchmark_nodes(libs[i], get_message_size(), workers) && ok;
+		}
 
-	return ok;
-}
+		return !ok;
+	}
+	else if (argc > 1 && strcmp(argv[1], "sector") == 0)
+	{
+		for (size_t i = 0; libs[i] != NULL; ++i)
+		{
+			ok = benchmark_sector(libs[i]) && ok;
+		}
 
-int main()
-{
+		return !ok;
+	}
+	else if (argc > 1 && strcmp(argv[1], "daemon") == 0)
+	{
+		return !benchmark_daemon(libs, get_message_size(), argc > 2 ? argv[2] : "cbos.sock", argc > 3 ? argv[3] : NULL,
+								 "cbos_daemon.json");
+	}
+	else if (argc > 1 && (strcmp(argv[1], "query") == 0 || strcmp(argv[1], "tail") == 0))
+	{
+		return !daemon_client(argc > 2 ? argv[2] : "cbos.sock", strcmp(argv[1], "tail") == 0 ? "tail" : "snapshot");
+	}
+	else if (argc > 1 && strcmp(argv[1], "verify") == 0)
+	{
+		return !verify_libraries(libs, get_message_size(), argc > 2 ? argv[2] : "cbos_verify.txt");
+	}
+	else if (argc > 1)
+	{
+		usage(argv[0]);
+		return 1;
+	}
 
-	bool ok = true;
+	for (size_t i = 0; libs[i] != NULL; ++i)
+	{
+		if (!benchmark(libs[i], get_message_size(), get_iterations(), &results, NULL))
+		{
+			ok = false;
+		}
+
+		if (!benchmark_pk(libs[i], PK_ITERATIONS))
+		{
+			ok = false;
+		}
 
-	if (!benchmark(get_lib(), get_message_size(), get_iterations()))
+		if (!benchmark_rng(libs[i], RNG_ITERATIONS))
+		{
+			ok = false;
+		}
+	}
+
+	if (!benchmark_getrandom(RNG_ITERATIONS))
 	{
 		ok = false;
 	}
+
+	if (libs[1] && results.count > 0)
+	{
+		print_summary(&results);
+	}
+
+	results_free(&results);
 	return !ok;
-}
\ No newline at end of file
+}
@@ -0,0 +1,454 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <linux/mempolicy.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+#include "nodes.h"
+#include "utils.h"
+
+#define NODE_MASK_WORDS ((NODES_MAX + 63) / 64)
+
+/**
+ * Where the memory of the workers is placed
+ */
+typedef enum NodePlacement
+{
+	NODE_LOCAL,  // The node of the worker's CPU
+	NODE_REMOTE, // The next node with memory
+	NODE_PLACEMENTS
+} NodePlacement;
+
+static const char *node_placement_names[NODE_PLACEMENTS] = {"local", "remote"};
+
+/**
+ * A worker process and the nodes its memory is bound to
+ */
+typedef struct NodeWorker
+{
+	int cpu;
+	int node;                    // Node of the CPU
+	int memory[NODE_PLACEMENTS]; // Node of the memory per placement, -1 if there is none
+} NodeWorker;
+
+/**
+ * Entry of the result table in shared memory, written by one worker
+ */
+typedef struct NodeSlot
+{
+	double start;
+	double end;
+	int buffer_node; // Node the kernel reports for the buffers
+	bool ok;
+} NodeSlot;
+
+/**
+ * Shared memory of one run: the start barrier and the result table
+ */
+typedef struct NodeShared
+{
+	pthread_barrier_t barrier;
+	NodeSlot slots[];
+} NodeShared;
+
+/**
+ * Reads a CPU or node list of the form "0-3,8-11" from sysfs.
+ *
+ * @param path The file.
+ * @param items Output for the entries.
+ * @param max Size of items.
+ * @return Number of entries, -1 if the file cannot be read.
+ */
+static int read_list(const char *path, int *items, int max)
+{
+	char list[4096] = "";
+	int count = 0;
+
+	FILE *file = fopen(path, "r");
+	if (!file)
+	{
+		return -1;
+	}
+	if (!fgets(list, sizeof(list), file))
+	{
+		list[0] = '\0';
+	}
+	fclose(file);
+
+	for (char *range = strtok(list, ",\n"); range; range = strtok(NULL, ",\n"))
+	{
+		int first = 0, last = 0;
+		const int fields = sscanf(range, "%d-%d", &first, &last);
+		if (fields < 1)
+			continue;
+		if (fields == 1)
+			last = first;
+		for (int item = first; item <= last && count < max; ++item)
+			items[count++] = item;
+	}
+
+	return count;
+}
+
+/**
+ * Finds the workers and the nodes of their memory.
+ *
+ * @param mode Workers per node or per core.
+ * @param workers Output for up to cpu_count() workers.
+ * @return Number of workers.
+ */
+static int find_workers(NodeWorkers mode, NodeWorker *workers)
+{
+	int nodes[NODES_MAX], memory[NODES_MAX];
+	const int max_cpus = cpu_count();
+	int cpus[max_cpus];
+	int count = 0;
+
+	int node_count = read_list("/sys/devices/system/node/has_cpu", nodes, NODES_MAX);
+	int memory_count = read_list("/sys/devices/system/node/has_memory", memory, NODES_MAX);
+
+	// Kernels without NUMA have one node with all CPUs and memory
+	if (node_count <= 0 || memory_count <= 0)
+	{
+		node_count = memory_count = 1;
+		nodes[0] = memory[0] = 0;
+	}
+
+	for (int n = 0; n < node_count; ++n)
+	{
+		char path[128];
+		snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", nodes[n]);
+
+		int cpu_total = read_list(path, cpus, max_cpus);
+		if (cpu_total < 0)
+		{
+			cpu_total = max_cpus;
+			for (int cpu = 0; cpu < max_cpus; ++cpu)
+				cpus[cpu] = cpu;
+		}
+
+		// Memory of the own node if it has any, remote memory on the next node with memory
+		int local = 0;
+		while (local < memory_count && memory[local] != nodes[n])
+			++local;
+		const int remote = local < memory_count ? (local + 1) % memory_count : 0;
+
+		for (int c = 0; c < cpu_total; ++c)
+		{
+			int siblings[2];
+			snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list", cpus[c]);
+
+			// Per core only the first CPU of its SMT siblings runs a worker
+			if (mode == WORKERS_PER_CORE && read_list(path, siblings, 2) > 0 && siblings[0] != cpus[c])
+				continue;
+
+			workers[count++] = (NodeWorker){
+				cpus[c],
+				nodes[n],
+				{local < memory_count ? memory[local] : memory[0], memory[remote] != nodes[n] ? memory[remote] : -1},
+			};
+
+			if (mode == WORKERS_PER_NODE)
+				break;
+		}
+	}
+
+	return count;
+}
+
+/**
+ * Binds all future allocations of the calling process to a node.
+ *
+ * @return True on success, otherwise false.
+ */
+static bool bind_process(int node)
+{
+	unsigned long mask[NODE_MASK_WORDS] = {0};
+
+	mask[node / 64] = 1UL << (node % 64);
+	return syscall(SYS_set_mempolicy, MPOL_BIND, mask, NODES_MAX + 1) == 0;
+}
+
+/**
+ * Maps a buffer whose pages are bound to a node and faults them in.
+ *
+ * @return The buffer, NULL on error.
+ */
+static uint8_t *node_buffer(size_t size, int node)
+{
+	unsigned long mask[NODE_MASK_WORDS] = {0};
+
+	uint8_t *buffer = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (buffer == MAP_FAILED)
+	{
+		return NULL;
+	}
+
+	mask[node / 64] = 1UL << (node % 64);
+	if (syscall(SYS_mbind, buffer, size, MPOL_BIND, mask, NODES_MAX + 1, MPOL_MF_STRICT) != 0)
+	{
+		munmap(buffer, size);
+		return NULL;
+	}
+
+	memset(buffer, 0, size);
+	return buffer;
+}
+
+/**
+ * Asks the kernel which node a page is on.
+ *
+ * @return The node, -1 if unknown.
+ */
+static int page_node(void *address)
+{
+	int node = -1;
+
+	if (syscall(SYS_get_mempolicy, &node, NULL, 0, address, MPOL_F_NODE | MPOL_F_ADDR) != 0)
+	{
+		return -1;
+	}
+
+	return node;
+}
+
+/**
+ * Runs in the worker process: allocates everything on the node of the
+ * placement, waits for the other workers and encrypts NODES_ITERATIONS
+ * messages.
+ *
+ * @param crypto_library Pointer to the cryptographic library.
+ * @param cipher Name of the cipher.
+ * @param message_size Size of every message.
+ * @param node Node of the memory.
+ * @param cpu CPU of the worker.
+ * @param shared The barrier and result table.
+ * @param slot The worker's entry of the table.
+ */
+static void node_worker(const Crypto *crypto_library, const char *cipher, const size_t message_size, int node, int cpu,
+						NodeShared *shared, NodeSlot *slot)
+{
+	// The output also has to hold the tag of AEAD ciphers
+	const size_t stride = message_size + MAX_DIGEST_SIZE;
+	const size_t messages = NODES_BUFFER > stride ? NODES_BUFFER / stride : 1;
+	const size_t buffer_size = messages * stride;
+	uint8_t *src = NULL, *dst = NULL;
+	void *param = NULL;
+
+	// Pages written after the fork, heap included, are copied to the bound node
+	slot->ok = pin_thread(cpu) && bind_process(node);
+	if (slot->ok)
+	{
+		src = node_buffer(buffer_size, node);
+		dst = node_buffer(buffer_size, node);
+	}
+
+	slot->ok = slot->ok && src && dst && crypto_library->init(&param) &&
+			   crypto_library->random(param, buffer_size, src) && crypto_library->set_cipher(param, cipher);
+	slot->buffer_node = src ? page_node(src) : -1;
+
+	for (size_t i = 0; slot->ok && i < NODES_ITERATIONS / 100; ++i)
+	{
+		slot->ok = crypto_library->encrypt(param, message_size, dst, src);
+	}
+
+	// The warm-up kept the first message in the caches
+	size_t offset = stride;
+
+	// Failed workers still pass the barrier, so the others do not wait forever
+	pthread_barrier_wait(&shared->barrier);
+
+	slot->start = seconds();
+	for (size_t i = 0; slot->ok && i < NODES_ITERATIONS; ++i)
+	{
+		slot->ok = crypto_library->encrypt(param, message_size, dst + offset, src + offset);
+		offset = offset + stride < buffer_size ? offset + stride : 0;
+	}
+	slot->end = seconds();
+
+	if (param)
+		crypto_library->free(param);
+	if (src)
+		munmap(src, buffer_size);
+	if (dst)
+		munmap(dst, buffer_size);
+}
+
+/**
+ * Runs all workers of one cipher and placement at the same time.
+ *
+ * @param crypto_library Pointer to the cryptographic library.
+ * @param cipher Name of the cipher.
+ * @param message_size Size of every message.
+ * @param placement The placement of the memory.
+ * @param workers The workers.
+ * @param count Number of workers.
+ * @param shared The barrier and result table.
+ * @return True if every worker succeeded, otherwise false.
+ */
+static bool run_workers(const Crypto *crypto_library, const char *cipher, const size_t message_size,
+						NodePlacement placement, const NodeWorker *workers, int count, NodeShared *shared)
+{
+	pthread_barrierattr_t attributes;
+	pid_t pids[count];
+	int started = 0;
+	bool ok = true;
+
+	pthread_barrierattr_init(&attributes);
+	pthread_barrierattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED);
+	pthread_barrier_init(&shared->barrier, &attributes, count);
+	pthread_barrierattr_destroy(&attributes);
+	memset(shared->slots, 0, count * sizeof(NodeSlot));
+
+	// Buffered output would otherwise be printed by the children again
+	fflush(stdout);
+
+	for (; started < count; ++started)
+	{
+		pids[started] = fork();
+		if (pids[started] < 0)
+		{
+			printf("Error: fork() failed: %s\n", strerror(errno));
+			break;
+		}
+		else if (pids[started] == 0)
+		{
+			node_worker(crypto_library, cipher, message_size, workers[started].memory[placement],
+						workers[started].cpu, shared, &shared->slots[started]);
+			fflush(stdout);
+			_exit(0);
+		}
+	}
+
+	// The barrier would never open without all workers
+	if (started < count)
+	{
+		for (int w = 0; w < started; ++w)
+			kill(pids[w], SIGKILL);
+		ok = false;
+	}
+
+	for (int w = 0; w < started; ++w)
+	{
+		int status = 0;
+		waitpid(pids[w], &status, 0);
+		ok = ok && WIFEXITED(status) && WEXITSTATUS(status) == 0 && shared->slots[w].ok;
+	}
+
+	pthread_barrier_destroy(&shared->barrier);
+	return ok;
+}
+
+/**
+ * Benchmarks every cipher of a library on all nodes with local and remote
+ * memory.
+ *
+ * @param crypto_library Pointer to the cryptographic library.
+ * @param message_size Size of every message.
+ * @param mode Workers per node or per core.
+ * @return True if the benchmark succeeds; otherwise, false.
+ */
+bool benchmark_nodes(const Crypto *crypto_library, const size_t message_size, NodeWorkers mode)
+{
+	const char *name = crypto_library->name();
+	NodeWorker workers[cpu_count()];
+	bool ok = true;
+
+	const int count = find_workers(mode, workers);
+	const bool has_remote = workers[0].memory[NODE_REMOTE] >= 0;
+
+	const size_t shared_size = sizeof(NodeShared) + count * sizeof(NodeSlot);
+	NodeShared *shared = mmap(NULL, shared_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (shared == MAP_FAILED)
+	{
+		printf("Error: [%s] cannot map the shared result table: %s\n", name, strerror(errno));
+		return false;
+	}
+
+	printf("[%s] %d worker processes:", name, count);
+	for (int w = 0; w < count; ++w)
+	{
+		printf(" CPU %d (node %d)", workers[w].cpu, workers[w].node);
+	}
+	printf("\n");
+	if (!has_remote)
+	{
+		printf("[%s] only one node has memory, remote placement is skipped\n", name);
+	}
+
+	const char **ciphers = crypto_library->ciphers();
+	for (size_t i = 0; ciphers[i] != NULL; ++i)
+	{
+		const char *cipher = ciphers[i];
+		NodeSlot slots[NODE_PLACEMENTS][count];
+
+		printf("[%s] running %s on all nodes, %d messages of %zu bytes per worker...\n", name, cipher,
+			   NODES_ITERATIONS, message_size);
+
+		bool cipher_ok = true;
+		for (int p = 0; p < (has_remote ? NODE_PLACEMENTS : 1) && cipher_ok; ++p)
+		{
+			cipher_ok = run_workers(crypto_library, cipher, message_size, p, workers, count, shared);
+			memcpy(slots[p], shared->slots, count * sizeof(NodeSlot));
+
+			for (int w = 0; cipher_ok && w < count; ++w)
+			{
+				if (slots[p][w].buffer_node >= 0 && slots[p][w].buffer_node != workers[w].memory[p])
+					printf("[%s] warning: the buffers of CPU %d are on node %d instead of %d\n", name,
+						   workers[w].cpu, slots[p][w].buffer_node, workers[w].memory[p]);
+			}
+		}
+
+		if (!cipher_ok)
+		{
+			printf("Error: [%s] %s failed!\n", name, cipher);
+			ok = false;
+			continue;
+		}
+
+		// Every node, then the whole machine as node -1
+		for (int n = 0; n <= count; ++n)
+		{
+			const bool machine = n == count;
+			const int node = machine ? -1 : workers[n].node;
+			double throughput[NODE_PLACEMENTS] = {0.0, 0.0};
+			int members = 0;
+
+			// Each node is reported once, at its first worker
+			if (!machine && n > 0 && workers[n - 1].node == node)
+				continue;
+
+			for (int p = 0; p < (has_remote ? NODE_PLACEMENTS : 1); ++p)
+			{
+				TimeSpan span = {0};
+
+				for (int w = 0; w < count; ++w)
+				{
+					if (machine || workers[w].node == node)
+						time_span_add(&span, slots[p][w].start, slots[p][w].end);
+				}
+
+				members = (int)span.count;
+				throughput[p] = (double)members * NODES_ITERATIONS * message_size / (span.end - span.start);
+			}
+
+			if (machine)
+				printf("[%s] %s machine (%d workers): ", name, cipher, members);
+			else
+				printf("[%s] %s node %d (%d workers): ", name, cipher, node, members);
+
+			printf("%s %.2f MB/s", node_placement_names[NODE_LOCAL], throughput[NODE_LOCAL] / 1e6);
+			if (has_remote)
+			{
+				printf(", %s %.2f MB/s (%+.2f%% penalty)", node_placement_names[NODE_REMOTE],
+					   throughput[NODE_REMOTE] / 1e6, 100.0 * (1.0 - throughput[NODE_REMOTE] / throughput[NODE_LOCAL]));
+			}
+			printf("\n");
+		}
+	}
+
+	munmap(shared, shared_size);
+	return ok;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "cbos.h"
+
+// Messages every worker encrypts per cipher and placement
+#ifndef NODES_ITERATIONS
+#define NODES_ITERATIONS 100000
+#endif
+
+// Bytes of the input and of the output buffer of every worker, larger than the LLC so messages come from memory
+#ifndef NODES_BUFFER
+#define NODES_BUFFER (32UL << 20)
+#endif
+
+// Highest number of NUMA nodes supported
+#ifndef NODES_MAX
+#define NODES_MAX 256
+#endif
+
+/**
+ * Workers started per NUMA node
+ */
+typedef enum NodeWorkers
+{
+	WORKERS_PER_NODE, // One worker on the first CPU of every node
+	WORKERS_PER_CORE  // One worker on the first CPU of every core
+} NodeWorkers;
+
+/**
+ * @brief Benchmarks every cipher of a library with one worker process per
+ * NUMA node or per core, all running at the same time. Each worker binds its
+ * memory policy before it allocates anything, so its buffers and the context
+ * of the library are either on its own node (local) or on the next node with
+ * memory (remote). Every worker walks through NODES_BUFFER bytes of input and
+ * output, so the messages come from memory and not from the caches. The
+ * workers start together at a barrier in shared memory and write their times
+ * to a table in shared memory, from which the throughput of every node and of
+ * the whole machine and the penalty of remote memory are reported. Nodes and CPUs are read from
+ * /sys/devices/system/node; without a second memory node only the local
+ * placement is measured.
+ *
+ * @param crypto_library Pointer to the cryptographic library.
+ * @param message_size Size of every message.
+ * @param workers Workers per node or per core.
+ * @return True if the benchmark succeeds; otherwise, false.
+ */
+bool benchmark_nodes(const Crypto *crypto_library, const size_t message_size, NodeWorkers workers);
@@ -0,0 +1,310 @@
+#include <stdatomic.h>
+
+#include "openloop.h"
+#include "utils.h"
+
+// Offered loads relative to the estimated capacity of the worker pool
+static const double open_loop_loads[] = {0.1, 0.25, 0.5, 0.7, 0.8, 0.9, 0.95, 1.0, 1.1, 1.25};
+
+#define OPEN_LOOP_LOADS (sizeof(open_loop_loads) / sizeof(open_loop_loads[0]))
+
+// Calls that estimate the service time of one request
+#define OPEN_LOOP_CALIBRATION 1000
+
+/**
+ * Requests of one offered load, shared by all workers
+ */
+typedef struct OpenLoop
+{
+	const Crypto *crypto_library;
+	const char *cipher;
+	size_t message_size;
+	const double *arrivals; // Scheduled arrival of every request relative to start
+	size_t requests;
+	atomic_size_t next; // Next request to serve
+	double start;
+	double *latencies;
+	pthread_barrier_t ready;   // All workers are set up
+	pthread_barrier_t release; // loop->start is published
+} OpenLoop;
+
+/**
+ * State of one worker thread
+ */
+typedef struct OpenLoopWorker
+{
+	OpenLoop *loop;
+	int cpu;
+	double end; // Completion of the last request
+	bool ok;
+} OpenLoopWorker;
+
+/**
+ * Takes the next request from the schedule, waits for its arrival and
+ * encrypts it. A request that arrives while all workers are busy waits until
+ * one becomes free, which is part of its latency.
+ *
+ * @param arg Pointer to an OpenLoopWorker structure.
+ * @return NULL.
+ */
+static void *open_loop_worker(void *arg)
+{
+	OpenLoopWorker *worker = arg;
+	OpenLoop *loop = worker->loop;
+	const Crypto *crypto_library = loop->crypto_library;
+	void *param = NULL;
+	uint8_t *src = malloc(loop->message_size);
+	uint8_t *dst = malloc(loop->message_size);
+
+	pin_thread(worker->cpu);
+
+	worker->ok = src && dst && crypto_library->init(&param) &&
+				 crypto_library->random(param, loop->message_size, src) &&
+				 crypto_library->set_cipher(param, loop->cipher);
+
+	// The schedule starts once the slowest worker is set up
+	pthread_barrier_wait(&loop->ready);
+	pthread_barrier_wait(&loop->release);
+
+	while (worker->ok)
+	{
+		const size_t i = atomic_fetch_add(&loop->next, 1);
+		if (i >= loop->requests)
+		{
+			break;
+		}
+
+		const double arrival = loop->start + loop->arrivals[i];
+		wait_until(arrival);
+
+		worker->ok = crypto_library->encrypt(param, loop->message_size, dst, src) != 0;
+		worker->end = seconds();
+		loop->latencies[i] = worker->end - arrival;
+	}
+
+	if (param)
+	{
+		crypto_library->free(param);
+	}
+	free(src);
+	free(dst);
+
+	return NULL;
+}
+
+/**
+ * Schedules the arrivals of one offered load.
+ *
+ * @param arrivals Output for the arrival times relative to the start.
+ * @param requests Number of requests.
+ * @param rate Offered load in requests per second.
+ * @param arrival The arrival process.
+ * @param seed State of erand48().
+ */
+static void schedule_arrivals(double *arrivals, const size_t requests, const double rate, const Arrival arrival,
+							  unsigned short seed[3])
+{
+	double t = 0.0;
+
+	for (size_t i = 0; i < requests; ++i)
+	{
+		arrivals[i] = t;
+		t += arrival == ARRIVAL_POISSON ? -log(1.0 - erand48(seed)) / rate : 1.0 / rate;
+	}
+}
+
+/**
+ * Estimates the mean service time of one request with a closed loop.
+ *
+ * @param crypto_library Pointer to the cryptographic library.
+ * @param cipher The cipher.
+ * @param message_size Size of every request.
+ * @return The service time in seconds, 0 on error.
+ */
+static double service_time(const Crypto *crypto_library, const char *cipher, const size_t message_size)
+{
+	void *param = NULL;
+	double elapsed = 0.0;
+	uint8_t *src = malloc(message_size);
+	uint8_t *dst = malloc(message_size);
+
+	if (src && dst && crypto_library->init(&param) && crypto_library->random(param, message_size, src) &&
+		crypto_library->set_cipher(param, cipher))
+	{
+		const double start = seconds();
+		size_t i = 0;
+		while (i < OPEN_LOOP_CALIBRATION && crypto_library->encrypt(param, message_size, dst, src))
+			++i;
+		elapsed = i == OPEN_LOOP_CALIBRATION ? (seconds() - start) / OPEN_LOOP_CALIBRATION : 0.0;
+	}
+
+	if (param)
+	{
+		crypto_library->free(param);
+	}
+	free(src);
+	free(dst);
+
+	return elapsed;
+}
+
+/**
+ * Runs one offered load with a pool of workers.
+ *
+ * @param loop The schedule, the results are stored in loop->latencies.
+ * @param workers Number of workers.
+ * @param throughput Output for the completed requests per second.
+ * @return True if all requests succeed; otherwise, false.
+ */
+static bool run_open_loop(OpenLoop *loop, const int workers, double *throughput)
+{
+	OpenLoopWorker *states = calloc(workers, sizeof(OpenLoopWorker));
+	pthread_t *ids = calloc(workers, sizeof(pthread_t));
+	bool ok = states && ids;
+
+	if (ok)
+	{
+		atomic_store(&loop->next, 0);
+		pthread_barrier_init(&loop->ready, NULL, workers + 1);
+		pthread_barrier_init(&loop->release, NULL, workers + 1);
+
+		for (int t = 0; t < workers; ++t)
+		{
+			states[t] = (OpenLoopWorker){loop, t % cpu_count(), 0.0, false};
+			pthread_create(&ids[t], NULL, open_loop_worker, &states[t]);
+		}
+
+		// The first request arrives shortly after all workers are set up and released
+		pthread_barrier_wait(&loop->ready);
+		loop->start = seconds() + 1e-3;
+		pthread_barrier_wait(&loop->release);
+
+		double end = loop->start;
+		for (int t = 0; t < workers; ++t)
+		{
+			pthread_join(ids[t], NULL);
+			ok = ok && states[t].ok;
+			if (states[t].end > end)
+				end = states[t].end;
+		}
+
+		pthread_barrier_destroy(&loop->ready);
+		pthread_barrier_destroy(&loop->release);
+		*throughput = loop->requests / (end - loop->start);
+	}
+
+	free(states);
+	free(ids);
+	return ok;
+}
+
+/**
+ * Benchmarks one cipher at every offered load and reports the latency curve.
+ * The saturation point is the first load whose completed throughput falls
+ * below 95% of the offered load or whose median latency exceeds ten times the
+ * median at the lowest load. The median is used because the tail at low loads
+ * is dominated by preemption and interrupts.
+ */
+static bool open_loop_cipher(const Crypto *crypto_library, const char *cipher, const size_t message_size,
+							 const Arrival arrival, const int workers)
+{
+	const char *name = crypto_library->name();
+	const double service = service_time(crypto_library, cipher, message_size);
+
+	if (service <= 0.0)
+	{
+		printf("Error: [%s] %s failed!\n", name, cipher);
+		return false;
+	}
+
+	const int parallel = workers < cpu_count() ? workers : cpu_count();
+	const double capacity = parallel / service;
+	unsigned short seed[3] = {0x330e, 0xcb05, 0x2024};
+	double base_p50 = 0.0;
+	bool saturated = false;
+	bool ok = true;
+
+	printf("[%s] %s open loop, %s arrivals, %d workers, estimated capacity %.0f req/s\n", name, cipher,
+		   arrival == ARRIVAL_POISSON ? "Poisson" : "constant", workers, capacity);
+	printf("[%s] %12s %12s %10s %10s %10s %10s %10s\n", name, "offered/s", "achieved/s", "p50 us", "p90 us",
+		   "p99 us", "p99.9 us", "max us");
+
+	for (size_t l = 0; l < OPEN_LOOP_LOADS && ok; ++l)
+	{
+		const double rate = open_loop_loads[l] * capacity;
+		const size_t requests = (size_t)(rate * OPEN_LOOP_SECONDS) > 0 ? (size_t)(rate * OPEN_LOOP_SECONDS) : 1;
+		double *arrivals = malloc(requests * sizeof(double));
+		double *latencies = malloc(requests * sizeof(double));
+		double throughput = 0.0;
+
+		if (!arrivals || !latencies)
+		{
+			printf("Error: [%s] failed to allocate %zu samples!\n", name, requests);
+			free(arrivals);
+			free(latencies);
+			return false;
+		}
+
+		schedule_arrivals(arrivals, requests, rate, arrival, seed);
+
+		OpenLoop loop = {crypto_library, cipher, message_size, arrivals, requests};
+		loop.latencies = latencies;
+
+		ok = run_open_loop(&loop, workers, &throughput);
+		if (ok)
+		{
+			sort_samples(latencies, requests);
+			const double p50 = percentile(latencies, requests, 50);
+			if (l == 0)
+				base_p50 = p50;
+
+			printf("[%s] %12.0f %12.0f %10.1f %10.1f %10.1f %10.1f %10.1f\n", name, rate, throughput,
+				   1e6 * p50, 1e6 * percentile(latencies, requests, 90), 1e6 * percentile(latencies, requests, 99),
+				   1e6 * percentile(latencies, requests, 99.9), 1e6 * latencies[requests - 1]);
+
+			if (!saturated && (throughput < 0.95 * rate || p50 > 10.0 * base_p50))
+			{
+				saturated = true;
+				printf("[%s] %s saturates at %.0f req/s offered (%.0f%% of the estimated capacity)\n", name, cipher,
+					   rate, 100.0 * open_loop_loads[l]);
+			}
+		}
+		else
+		{
+			printf("Error: [%s] %s failed!\n", name, cipher);
+		}
+
+		free(arrivals);
+		free(latencies);
+	}
+
+	if (ok && !saturated)
+	{
+		printf("[%s] %s did not saturate up to %.0f%% of the estimated capacity\n", name, cipher,
+			   100.0 * open_loop_loads[OPEN_LOOP_LOADS - 1]);
+	}
+
+	return ok;
+}
+
+/**
+ * Benchmarks every cipher of a library in an open loop.
+ *
+ * @param crypto_library Pointer to the cryptographic library.
+ * @param message_size Size of every request.
+ * @param arrival The arrival process.
+ * @return True if the benchmark succeeds; otherwise, false.
+ */
+bool benchmark_open_loop(const Crypto *crypto_library, const size_t message_size, const Arrival arrival)
+{
+	const int workers = OPEN_LOOP_WORKERS > 0 ? OPEN_LOOP_WORKERS : cpu_count();
+	const char **ciphers = crypto_library->ciphers();
+	bool ok = true;
+
+	for (size_t i = 0; ciphers[i] != NULL; ++i)
+	{
+		ok = open_loop_cipher(crypto_library, ciphers[i], message_size, arrival, workers) && ok;
+	}
+
+	return ok;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "cbos.h"
+
+// Worker threads that serve the requests, 0 for one per CPU
+#ifndef OPEN_LOOP_WORKERS
+#define OPEN_LOOP_WORKERS 0
+#endif
+
+// Duration of every offered load
+#ifndef OPEN_LOOP_SECONDS
+#define OPEN_LOOP_SECONDS 1.0
+#endif
+
+/**
+ * Arrival processes of the open-loop benchmark
+ */
+typedef enum Arrival
+{
+	ARRIVAL_CONSTANT, // Requests arrive at fixed intervals
+	ARRIVAL_POISSON	  // Exponentially distributed intervals
+} Arrival;
+
+/**
+ * @brief Benchmarks every cipher of a library in an open loop: encrypt
+ * requests arrive at a fixed rate independent of their completion and are
+ * served by a pool of worker threads. The latency of every request is measured
+ * from its scheduled arrival to its completion, so queueing behind slow
+ * requests is included (no coordinated omission). The offered load is stepped
+ * from 10% to 125% of the estimated capacity and the saturation point is
+ * reported.
+ *
+ * @param crypto_library Pointer to the cryptographic library.
+ * @param message_size Size of every request.
+ * @param arrival The arrival process.
+ * @return True if the benchmark succeeds; otherwise, false.
+ */
+bool benchmark_open_loop(const Crypto *crypto_library, const size_t message_size, const Arrival arrival);
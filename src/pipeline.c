@@ -0,0 +1,506 @@
+#include <sched.h>
+
+#include "pipeline.h"
+#include "ring.h"
+#include "utils.h"
+
+// Plaintexts the producers cycle through, every worker encrypts each once as a reference
+#define PIPELINE_PATTERNS 16
+
+/**
+ * Packet buffer of the pool
+ */
+typedef struct Packet
+{
+	uint8_t *plaintext;
+	uint8_t *ciphertext;
+	size_t sequence;
+	int worker; // Stage index of the worker that encrypted it
+	bool ok;	// Result of encrypt
+} Packet;
+
+/**
+ * State shared by all stages of one pipeline run
+ */
+typedef struct Pipeline
+{
+	const Crypto *crypto_library;
+	const char *cipher;
+	size_t message_size;
+	size_t packets;
+	Packet *pool;
+	Ring free_ring; // Consumers -> producers
+	Ring work_ring; // Producers -> workers
+	Ring tx_ring;	// Workers -> consumers
+	atomic_size_t produced;
+	atomic_size_t encrypted;
+	atomic_size_t consumed;
+	atomic_bool failed;
+	double *produce_time; // Per packet sequence: pushed to the workers
+	double *dequeue_time; // Taken by a worker
+	double *encrypt_time; // Pushed to the consumers
+	double *consume_time; // Taken by a consumer
+	uint8_t *references;  // PIPELINE_PATTERNS ciphertexts per worker
+	pthread_barrier_t barrier;
+} Pipeline;
+
+/**
+ * State of one stage thread
+ */
+typedef struct StageThread
+{
+	Pipeline *pipeline;
+	int cpu;
+	int worker; // Index among the workers, -1 for producers and consumers
+	double start;
+	double end;
+	double busy; // Time spent filling, encrypting or verifying
+	bool ok;
+} StageThread;
+
+/**
+ * Pushes to a ring and yields while it is full. Returns false if another
+ * stage failed in the meantime.
+ */
+static bool stage_push(Pipeline *pipeline, Ring *ring, uint32_t value)
+{
+	while (!ring_push(ring, value))
+	{
+		if (atomic_load(&pipeline->failed))
+			return false;
+		sched_yield();
+	}
+
+	return true;
+}
+
+/**
+ * Pops from a ring and yields while it is empty. Returns false if another
+ * stage failed in the meantime.
+ */
+static bool stage_pop(Pipeline *pipeline, Ring *ring, uint32_t *value)
+{
+	while (!ring_pop(ring, value))
+	{
+		if (atomic_load(&pipeline->failed))
+			return false;
+		sched_yield();
+	}
+
+	return true;
+}
+
+/**
+ * Fills packets from the pool until all packets are produced.
+ *
+ * @param arg Pointer to a StageThread structure.
+ * @return NULL.
+ */
+static void *producer_stage(void *arg)
+{
+	StageThread *stage = arg;
+	Pipeline *pipeline = stage->pipeline;
+	size_t sequence;
+
+	pin_thread(stage->cpu);
+	stage->ok = true;
+	pthread_barrier_wait(&pipeline->barrier);
+	stage->start = seconds();
+
+	while (stage->ok && (sequence = atomic_fetch_add(&pipeline->produced, 1)) < pipeline->packets)
+	{
+		uint32_t index;
+		if (!stage_pop(pipeline, &pipeline->free_ring, &index))
+		{
+			break;
+		}
+
+		const double begin = seconds();
+		Packet *packet = &pipeline->pool[index];
+		packet->sequence = sequence;
+		memset(packet->plaintext, (int)(sequence % PIPELINE_PATTERNS), pipeline->message_size);
+		pipeline->produce_time[sequence] = seconds();
+		stage->busy += pipeline->produce_time[sequence] - begin;
+
+		stage->ok = stage_push(pipeline, &pipeline->work_ring, index);
+	}
+
+	stage->end = seconds();
+	return NULL;
+}
+
+/**
+ * Encrypts every plaintext pattern twice and stores the ciphertexts as the
+ * references of a worker. Both have to match, otherwise encrypt continues the
+ * previous message, e.g. Botan's, and the packets cannot be compared.
+ *
+ * @param stage The worker stage with the cipher set.
+ * @param param The context of the worker.
+ * @param restart Restart the message with stream_start before every packet.
+ * @return True if both ciphertexts of every pattern match, otherwise false.
+ */
+static bool worker_references(StageThread *stage, void *param, const bool restart)
+{
+	Pipeline *pipeline = stage->pipeline;
+	const Crypto *crypto_library = pipeline->crypto_library;
+	const size_t size = pipeline->message_size;
+	uint8_t *references = pipeline->references + (size_t)stage->worker * PIPELINE_PATTERNS * size;
+	uint8_t *plaintext = malloc(size);
+	uint8_t *ciphertext = malloc(size + MAX_DIGEST_SIZE);
+	bool ok = plaintext && ciphertext;
+
+	for (int pattern = 0; ok && pattern < PIPELINE_PATTERNS; ++pattern)
+	{
+		memset(plaintext, pattern, size);
+
+		for (int repeat = 0; ok && repeat < 2; ++repeat)
+		{
+			ok = (!restart || crypto_library->stream_start(param)) &&
+				 crypto_library->encrypt(param, size, ciphertext, plaintext) != 0;
+
+			if (ok && repeat == 0)
+				memcpy(references + pattern * size, ciphertext, size);
+			else if (ok)
+				ok = memcmp(references + pattern * size, ciphertext, size) == 0;
+		}
+	}
+
+	free(plaintext);
+	free(ciphertext);
+	return ok;
+}
+
+/**
+ * Encrypts packets with an own context until all packets are encrypted. Every
+ * packet is a message of its own: backends whose encrypt continues the
+ * previous message restart it with stream_start before every packet, outside
+ * of the encryption time.
+ *
+ * @param arg Pointer to a StageThread structure.
+ * @return NULL.
+ */
+static void *worker_stage(void *arg)
+{
+	StageThread *stage = arg;
+	Pipeline *pipeline = stage->pipeline;
+	const Crypto *crypto_library = pipeline->crypto_library;
+	void *param = NULL;
+	bool restart = false;
+
+	pin_thread(stage->cpu);
+	stage->ok = crypto_library->init(&param) && crypto_library->set_cipher(param, pipeline->cipher);
+
+	if (stage->ok && !worker_references(stage, param, false))
+	{
+		restart = true;
+		stage->ok = crypto_library->stream_start && worker_references(stage, param, true);
+		if (!stage->ok)
+		{
+			printf("Error: [%s] %s encrypts the same packet differently every time!\n", crypto_library->name(),
+				   pipeline->cipher);
+		}
+	}
+
+	if (!stage->ok)
+	{
+		atomic_store(&pipeline->failed, true);
+	}
+
+	pthread_barrier_wait(&pipeline->barrier);
+	stage->start = seconds();
+
+	while (stage->ok && atomic_load(&pipeline->encrypted) < pipeline->packets && !atomic_load(&pipeline->failed))
+	{
+		uint32_t index;
+		if (!ring_pop(&pipeline->work_ring, &index))
+		{
+			sched_yield();
+			continue;
+		}
+
+		Packet *packet = &pipeline->pool[index];
+		const bool started = !restart || crypto_library->stream_start(param);
+		const double begin = seconds();
+		pipeline->dequeue_time[packet->sequence] = begin;
+		packet->worker = stage->worker;
+		packet->ok = started &&
+					 crypto_library->encrypt(param, pipeline->message_size, packet->ciphertext, packet->plaintext) != 0;
+		pipeline->encrypt_time[packet->sequence] = seconds();
+		stage->busy += pipeline->encrypt_time[packet->sequence] - begin;
+
+		atomic_fetch_add(&pipeline->encrypted, 1);
+		stage->ok = stage_push(pipeline, &pipeline->tx_ring, index);
+	}
+
+	stage->end = seconds();
+	if (param)
+	{
+		crypto_library->free(param);
+	}
+
+	return NULL;
+}
+
+/**
+ * Verifies encrypted packets and returns them to the pool until all packets
+ * are consumed. A packet fails verification if encrypt reported an error or
+ * its ciphertext differs from the reference of its worker and plaintext.
+ *
+ * @param arg Pointer to a StageThread structure.
+ * @return NULL.
+ */
+static void *consumer_stage(void *arg)
+{
+	StageThread *stage = arg;
+	Pipeline *pipeline = stage->pipeline;
+	const size_t size = pipeline->message_size;
+
+	pin_thread(stage->cpu);
+	stage->ok = true;
+	pthread_barrier_wait(&pipeline->barrier);
+	stage->start = seconds();
+
+	while (stage->ok && atomic_load(&pipeline->consumed) < pipeline->packets && !atomic_load(&pipeline->failed))
+	{
+		uint32_t index;
+		if (!ring_pop(&pipeline->tx_ring, &index))
+		{
+			sched_yield();
+			continue;
+		}
+
+		Packet *packet = &pipeline->pool[index];
+		const double begin = seconds();
+		pipeline->consume_time[packet->sequence] = begin;
+		const uint8_t *reference = pipeline->references +
+								   ((size_t)packet->worker * PIPELINE_PATTERNS + packet->sequence % PIPELINE_PATTERNS) * size;
+		stage->ok = packet->ok && memcmp(packet->ciphertext, reference, size) == 0;
+		stage->busy += seconds() - begin;
+
+		atomic_fetch_add(&pipeline->consumed, 1);
+		stage->ok = stage->ok && stage_push(pipeline, &pipeline->free_ring, index);
+	}
+
+	if (!stage->ok)
+	{
+		atomic_store(&pipeline->failed, true);
+	}
+
+	stage->end = seconds();
+	return NULL;
+}
+
+/**
+ * Prints percentiles of the differences between two per-packet timestamps.
+ *
+ * @param name Name of the library.
+ * @param label Description of the interval.
+ * @param from Timestamps at the start of the interval.
+ * @param to Timestamps at the end of the interval.
+ * @param delays Scratch buffer for the differences.
+ * @param count Number of packets.
+ */
+static void print_delay(const char *name, const char *label, const double *from, const double *to, double *delays,
+						const size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		delays[i] = to[i] - from[i];
+	}
+	sort_samples(delays, count);
+
+	printf("[%s]   %-22s p50 %9.1f us, p90 %9.1f us, p99 %9.1f us, p99.9 %9.1f us\n", name, label,
+		   1e6 * percentile(delays, count, 50), 1e6 * percentile(delays, count, 90),
+		   1e6 * percentile(delays, count, 99), 1e6 * percentile(delays, count, 99.9));
+}
+
+/**
+ * Utilization of a stage: busy time of its threads over their wall time.
+ */
+static double stage_utilization(const StageThread *threads, const int count)
+{
+	double busy = 0.0, wall = 0.0;
+
+	for (int t = 0; t < count; ++t)
+	{
+		busy += threads[t].busy;
+		wall += threads[t].end - threads[t].start;
+	}
+
+	return wall > 0.0 ? busy / wall : 0.0;
+}
+
+/**
+ * Allocates the pool, the rings and the per-packet timestamps of a pipeline.
+ */
+static bool pipeline_init(Pipeline *pipeline, const int producers, const int workers, const int consumers)
+{
+	const size_t size = pipeline->message_size;
+
+	pipeline->pool = calloc(PIPELINE_BUFFERS, sizeof(Packet));
+	pipeline->produce_time = malloc(4 * pipeline->packets * sizeof(double));
+	pipeline->references = malloc((size_t)workers * PIPELINE_PATTERNS * size);
+	if (!pipeline->pool || !pipeline->produce_time || !pipeline->references)
+	{
+		return false;
+	}
+	pipeline->dequeue_time = pipeline->produce_time + pipeline->packets;
+	pipeline->encrypt_time = pipeline->dequeue_time + pipeline->packets;
+	pipeline->consume_time = pipeline->encrypt_time + pipeline->packets;
+
+	if (!ring_init(&pipeline->free_ring, PIPELINE_BUFFERS, producers == 1 && consumers == 1) ||
+		!ring_init(&pipeline->work_ring, PIPELINE_BUFFERS, producers == 1 && workers == 1) ||
+		!ring_init(&pipeline->tx_ring, PIPELINE_BUFFERS, workers == 1 && consumers == 1))
+	{
+		return false;
+	}
+
+	for (uint32_t i = 0; i < PIPELINE_BUFFERS; ++i)
+	{
+		Packet *packet = &pipeline->pool[i];
+		// The output also has to hold the tag of AEAD ciphers
+		if (posix_memalign((void **)&packet->plaintext, 64, size) ||
+			posix_memalign((void **)&packet->ciphertext, 64, size + MAX_DIGEST_SIZE))
+		{
+			return false;
+		}
+		ring_push(&pipeline->free_ring, i);
+	}
+
+	return true;
+}
+
+/**
+ * Frees everything allocated by pipeline_init().
+ */
+static void pipeline_free(Pipeline *pipeline)
+{
+	for (size_t i = 0; pipeline->pool && i < PIPELINE_BUFFERS; ++i)
+	{
+		free(pipeline->pool[i].plaintext);
+		free(pipeline->pool[i].ciphertext);
+	}
+
+	ring_free(&pipeline->free_ring);
+	ring_free(&pipeline->work_ring);
+	ring_free(&pipeline->tx_ring);
+	free(pipeline->pool);
+	free(pipeline->produce_time);
+	free(pipeline->references);
+}
+
+/**
+ * Runs one cipher through the pipeline and reports its throughput, queueing
+ * delays and stage utilization.
+ */
+static bool pipeline_cipher(const Crypto *crypto_library, const char *cipher, const size_t message_size,
+							const int producers, const int workers, const int consumers)
+{
+	const char *name = crypto_library->name();
+	const int threads = producers + workers + consumers;
+	Pipeline pipeline = {crypto_library, cipher, message_size, PIPELINE_PACKETS};
+	StageThread *stages = calloc(threads, sizeof(StageThread));
+	pthread_t *ids = calloc(threads, sizeof(pthread_t));
+	bool ok = stages && ids && pipeline_init(&pipeline, producers, workers, consumers);
+
+	if (!ok)
+	{
+		printf("Error: [%s] failed to allocate the pipeline!\n", name);
+		pipeline_free(&pipeline);
+		free(stages);
+		free(ids);
+		return false;
+	}
+
+	printf("[%s] running %s pipeline with %d producer(s), %d worker(s), %d consumer(s)...\n", name, cipher, producers,
+		   workers, consumers);
+
+	pthread_barrier_init(&pipeline.barrier, NULL, threads);
+
+	// Producers and consumers take the first CPUs, the workers the others
+	for (int t = 0; t < threads; ++t)
+	{
+		const bool worker = t >= producers && t < producers + workers;
+		void *(*function)(void *) = t < producers ? producer_stage : worker ? worker_stage : consumer_stage;
+		const int cpu = t < producers ? t : worker ? consumers + t : t - workers;
+		stages[t] = (StageThread){&pipeline, cpu % cpu_count(), worker ? t - producers : -1, 0.0, 0.0, 0.0, false};
+		pthread_create(&ids[t], NULL, function, &stages[t]);
+	}
+
+	TimeSpan span = {0};
+	for (int t = 0; t < threads; ++t)
+	{
+		pthread_join(ids[t], NULL);
+		ok = ok && stages[t].ok;
+		time_span_add(&span, stages[t].start, stages[t].end);
+	}
+
+	pthread_barrier_destroy(&pipeline.barrier);
+
+	if (ok && !atomic_load(&pipeline.failed))
+	{
+		const size_t count = pipeline.packets;
+		double *delays = malloc(count * sizeof(double));
+		const double elapsed = span.end - span.start;
+		const double utilization[] = {stage_utilization(stages, producers),
+									  stage_utilization(stages + producers, workers),
+									  stage_utilization(stages + producers + workers, consumers)};
+		const char *stage_names[] = {"producers", "workers", "consumers"};
+
+		printf("[%s] %s: %.0f packets/s, %.2f MB/s end to end\n", name, cipher, count / elapsed,
+			   count * message_size / elapsed / 1e6);
+
+		if (delays)
+		{
+			print_delay(name, "queue producer->worker", pipeline.produce_time, pipeline.dequeue_time, delays, count);
+			print_delay(name, "encrypt", pipeline.dequeue_time, pipeline.encrypt_time, delays, count);
+			print_delay(name, "queue worker->consumer", pipeline.encrypt_time, pipeline.consume_time, delays, count);
+			print_delay(name, "end to end", pipeline.produce_time, pipeline.consume_time, delays, count);
+			free(delays);
+		}
+
+		size_t busiest = 0;
+		for (size_t s = 1; s < 3; ++s)
+		{
+			if (utilization[s] > utilization[busiest])
+				busiest = s;
+		}
+
+		printf("[%s]   utilization producers %.1f%%, workers %.1f%%, consumers %.1f%%, busiest stage: %s\n", name,
+			   100.0 * utilization[0], 100.0 * utilization[1], 100.0 * utilization[2], stage_names[busiest]);
+	}
+	else
+	{
+		printf("Error: [%s] %s pipeline failed!\n", name, cipher);
+		ok = false;
+	}
+
+	pipeline_free(&pipeline);
+	free(stages);
+	free(ids);
+	return ok;
+}
+
+/**
+ * Benchmarks every cipher of a library in the pipeline.
+ *
+ * @param crypto_library Pointer to the cryptographic library.
+ * @param message_size Size of every packet.
+ * @return True if the benchmark succeeds; otherwise, false.
+ */
+bool benchmark_pipeline(const Crypto *crypto_library, const size_t message_size)
+{
+	const int spare = cpu_count() - PIPELINE_PRODUCERS - PIPELINE_CONSUMERS;
+	const int workers = PIPELINE_WORKERS > 0 ? PIPELINE_WORKERS : spare > 0 ? spare : 1;
+	const char **ciphers = crypto_library->ciphers();
+	bool ok = true;
+
+	for (size_t i = 0; ciphers[i] != NULL; ++i)
+	{
+		ok = pipeline_cipher(crypto_library, ciphers[i], message_size, PIPELINE_PRODUCERS, workers,
+							 PIPELINE_CONSUMERS) &&
+			 ok;
+	}
+
+	return ok;
+}
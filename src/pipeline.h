@@ -0,0 +1,39 @@
+#pragma once
+
+#include "cbos.h"
+
+// Threads of the stages, 0 workers means one per CPU left by the producers and consumers
+#ifndef PIPELINE_PRODUCERS
+#define PIPELINE_PRODUCERS 1
+#endif
+
+#ifndef PIPELINE_WORKERS
+#define PIPELINE_WORKERS 0
+#endif
+
+#ifndef PIPELINE_CONSUMERS
+#define PIPELINE_CONSUMERS 1
+#endif
+
+// Packets per cipher and preallocated packet buffers in flight
+#ifndef PIPELINE_PACKETS
+#define PIPELINE_PACKETS 100000
+#endif
+
+#ifndef PIPELINE_BUFFERS
+#define PIPELINE_BUFFERS 256
+#endif
+
+/**
+ * @brief Benchmarks every cipher of a library in a three-stage pipeline:
+ * producer threads fill packets from a preallocated pool, worker threads
+ * encrypt them and consumer threads verify them against reference
+ * ciphertexts and recycle them. The stages are
+ * connected by lock-free rings. Reports end-to-end throughput, queueing delay
+ * between the stages and the utilization of every stage.
+ *
+ * @param crypto_library Pointer to the cryptographic library.
+ * @param message_size Size of every packet.
+ * @return True if the benchmark succeeds; otherwise, false.
+ */
+bool benchmark_pipeline(const Crypto *crypto_library, const size_t message_size);
@@ -0,0 +1,168 @@
+#include "pubkey.h"
+#include "utils.h"
+
+/**
+ * State of one benchmark thread
+ */
+typedef struct PKWorker
+{
+	const Crypto *crypto_library;
+	const char *operation;
+	size_t iterations;
+	double *latencies;
+	void *param;
+} PKWorker;
+
+/**
+ * Creates the context of a thread. Keys and inputs are generated by
+ * set_pk_operation() before all threads start together.
+ *
+ * @param arg Pointer to a PKWorker structure.
+ * @return True on success, otherwise false.
+ */
+static bool pk_setup(void *arg)
+{
+	PKWorker *worker = arg;
+
+	return worker->crypto_library->init(&worker->param) &&
+		   worker->crypto_library->set_pk_operation(worker->param, worker->operation);
+}
+
+/**
+ * Runs one public-key operation repeatedly.
+ *
+ * @param arg Pointer to a PKWorker structure.
+ * @return True on success, otherwise false.
+ */
+static bool pk_run(void *arg)
+{
+	PKWorker *worker = arg;
+	bool ok = true;
+
+	for (size_t i = 0; ok && i < worker->iterations; ++i)
+	{
+		const double op_start = seconds();
+		ok = worker->crypto_library->pk_run(worker->param);
+		worker->latencies[i] = seconds() - op_start;
+	}
+
+	return ok;
+}
+
+/**
+ * Frees the context of a thread.
+ *
+ * @param arg Pointer to a PKWorker structure.
+ */
+static void pk_cleanup(void *arg)
+{
+	PKWorker *worker = arg;
+
+	if (worker->param)
+	{
+		worker->crypto_library->free(worker->param);
+	}
+}
+
+static const PinnedWork pk_work = {pk_setup, pk_run, pk_cleanup};
+
+/**
+ * Benchmarks one public-key operation with a number of threads.
+ *
+ * @param crypto_library Pointer to the cryptographic library.
+ * @param operation Name of the operation.
+ * @param threads Number of threads.
+ * @param iterations Number of operations per thread.
+ * @param ops_per_second Output for the throughput of all threads together.
+ * @return True if the benchmark succeeds; otherwise, false.
+ */
+static bool run_pk(const Crypto *crypto_library, const char *operation, const int threads, const size_t iterations,
+				   double *ops_per_second)
+{
+	const char *name = crypto_library->name();
+	const size_t count = threads * iterations;
+	PKWorker *workers = calloc(threads, sizeof(PKWorker));
+	double *latencies = malloc(count * sizeof(double));
+	TimeSpan span;
+
+	if (!workers || !latencies)
+	{
+		printf("Error: [%s] failed to allocate %zu samples!\n", name, count);
+		free(workers);
+		free(latencies);
+		return false;
+	}
+
+	for (int t = 0; t < threads; ++t)
+	{
+		workers[t] = (PKWorker){crypto_library, operation, iterations, latencies + t * iterations, NULL};
+	}
+
+	const bool ok = run_pinned_threads(threads, NULL, &pk_work, workers, sizeof(PKWorker), &span);
+
+	if (ok)
+	{
+		sort_samples(latencies, count);
+		*ops_per_second = count / (span.end - span.start);
+
+		printf("[%s] %s: %d thread(s), %.1f ops/s, latency p50 %.1f us, p90 %.1f us, p99 %.1f us, p99.9 %.1f us\n",
+			   name, operation, threads, *ops_per_second, 1e6 * percentile(latencies, count, 50),
+			   1e6 * percentile(latencies, count, 90), 1e6 * percentile(latencies, count, 99),
+			   1e6 * percentile(latencies, count, 99.9));
+	}
+	else
+	{
+		printf("Error: [%s] %s failed with %d thread(s)!\n", name, operation, threads);
+	}
+
+	free(workers);
+	free(latencies);
+	return ok;
+}
+
+/**
+ * Benchmarks every public-key operation of a library, first on one thread and
+ * then scaled to 2, 4, ... threads and finally one thread per CPU. The scaling
+ * is reported relative to the single-threaded throughput.
+ *
+ * @param crypto_library Pointer to the cryptographic library.
+ * @param iterations Number of operations per thread.
+ * @return True if the benchmark succeeds; otherwise, false.
+ */
+bool benchmark_pk(const Crypto *crypto_library, const size_t iterations)
+{
+	bool ok = true;
+	const char *name = crypto_library->name();
+	const int cpus = cpu_count();
+
+	if (!crypto_library->pk_operations)
+	{
+		return true;
+	}
+
+	const char **operations = crypto_library->pk_operations();
+	for (size_t i = 0; operations[i] != NULL; ++i)
+	{
+		double single = 0.0;
+
+		printf("[%s] running %s benchmark...\n", name, operations[i]);
+
+		for (int threads = 1; threads <= cpus; threads = next_thread_count(threads, cpus))
+		{
+			double ops_per_second = 0.0;
+			if (!run_pk(crypto_library, operations[i], threads, iterations, &ops_per_second))
+			{
+				ok = false;
+				break;
+			}
+
+			if (threads == 1)
+				single = ops_per_second;
+			else
+				printf("[%s] %s: %d threads scale to %.2fx of one thread\n", name, operations[i], threads,
+					   ops_per_second / single);
+		}
+	}
+
+	return ok;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "cbos.h"
+
+// Operations per thread for every public-key benchmark
+#ifndef PK_ITERATIONS
+#define PK_ITERATIONS 1000
+#endif
+
+/**
+ * @brief Benchmarks every public-key operation of a library with 1, 2, 4, ...
+ * threads up to the number of CPUs and reports operations per second and
+ * latency percentiles.
+ *
+ * @param crypto_library Pointer to the cryptographic library.
+ * @param iterations Number of operations per thread.
+ * @return True if the benchmark succeeds; otherwise, false.
+ */
+bool benchmark_pk(const Crypto *crypto_library, const size_t iterations);
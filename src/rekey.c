@@ -0,0 +1,208 @@
+#include "rekey.h"
+#include "utils.h"
+
+/**
+ * What a rekey interval counts
+ */
+typedef enum RekeyUnit
+{
+	REKEY_NEVER,
+	REKEY_MESSAGES_LIMIT, // A new key every `interval` messages
+	REKEY_BYTES_LIMIT     // A new key before the current one exceeds `interval` bytes
+} RekeyUnit;
+
+/**
+ * A rekey policy
+ */
+typedef struct RekeyPolicy
+{
+	RekeyUnit unit;
+	size_t interval;
+} RekeyPolicy;
+
+// Policies of one unit from the shortest to the longest interval
+static const RekeyPolicy rekey_policies[] = {
+	{REKEY_MESSAGES_LIMIT, 1},
+	{REKEY_MESSAGES_LIMIT, 4},
+	{REKEY_MESSAGES_LIMIT, 16},
+	{REKEY_MESSAGES_LIMIT, 64},
+	{REKEY_MESSAGES_LIMIT, 256},
+	{REKEY_MESSAGES_LIMIT, 1024},
+	{REKEY_BYTES_LIMIT, 16UL << 10},
+	{REKEY_BYTES_LIMIT, 256UL << 10},
+	{REKEY_BYTES_LIMIT, 4UL << 20},
+	{REKEY_BYTES_LIMIT, 64UL << 20},
+};
+
+#define REKEY_POLICIES (sizeof(rekey_policies) / sizeof(rekey_policies[0]))
+
+/**
+ * Encrypts REKEY_MESSAGES messages and rekeys according to a policy between
+ * them.
+ *
+ * @param crypto_library Pointer to the cryptographic library.
+ * @param param The context with the cipher already set.
+ * @param policy The rekey policy.
+ * @param message_size Size of every message.
+ * @param dst Output buffer.
+ * @param src Input message.
+ * @param elapsed Output for the time of all messages and rekeys.
+ * @param rekeys Output for the number of rekeys.
+ * @return True on success, otherwise false.
+ */
+static bool rekey_run(const Crypto *crypto_library, void *param, const RekeyPolicy *policy, const size_t message_size,
+					  uint8_t *dst, const uint8_t *src, double *elapsed, size_t *rekeys)
+{
+	size_t since_rekey = 0; // Messages or bytes under the current key
+	size_t count = 0;
+
+	const double start = seconds();
+
+	for (size_t i = 0; i < REKEY_MESSAGES; ++i)
+	{
+		const size_t next = policy->unit == REKEY_BYTES_LIMIT ? message_size : 1;
+
+		if (policy->unit != REKEY_NEVER && since_rekey + next > policy->interval && since_rekey > 0)
+		{
+			if (!crypto_library->rekey(param))
+			{
+				return false;
+			}
+			since_rekey = 0;
+			++count;
+		}
+
+		if (!crypto_library->encrypt(param, message_size, dst, src))
+		{
+			return false;
+		}
+		since_rekey += next;
+	}
+
+	*elapsed = seconds() - start;
+	*rekeys = count;
+	return true;
+}
+
+/**
+ * Prints the interval of a policy.
+ *
+ * @param policy The policy.
+ * @param text Output for the text.
+ * @param size Size of text.
+ */
+static void format_policy(const RekeyPolicy *policy, char *text, size_t size)
+{
+	if (policy->unit == REKEY_MESSAGES_LIMIT)
+		snprintf(text, size, "every %zu messages", policy->interval);
+	else if (policy->interval >= 1UL << 20)
+		snprintf(text, size, "every %zu MiB", policy->interval >> 20);
+	else
+		snprintf(text, size, "every %zu KiB", policy->interval >> 10);
+}
+
+/**
+ * Benchmarks every cipher of a library under all rekey policies.
+ *
+ * @param crypto_library Pointer to the cryptographic library.
+ * @param message_size Size of every message.
+ * @return True if the benchmark succeeds; otherwise, false.
+ */
+bool benchmark_rekey(const Crypto *crypto_library, const size_t message_size)
+{
+	const char *name = crypto_library->name();
+	const RekeyPolicy never = {REKEY_NEVER, 0};
+	void *param = NULL;
+	bool ok = true;
+
+	if (!crypto_library->rekey)
+	{
+		return true;
+	}
+
+	uint8_t *src = malloc(message_size);
+	uint8_t *dst = malloc(message_size + MAX_DIGEST_SIZE);
+
+	if (!src || !dst || !crypto_library->init(&param) || !crypto_library->random(param, message_size, src))
+	{
+		printf("Error: [%s] rekey benchmark initialization failed!\n", name);
+		free(src);
+		free(dst);
+		return false;
+	}
+
+	const char **ciphers = crypto_library->ciphers();
+	for (size_t i = 0; ciphers[i] != NULL; ++i)
+	{
+		const char *cipher = ciphers[i];
+		double elapsed[REKEY_POLICIES], baseline, baseline_end;
+		size_t rekeys[REKEY_POLICIES], none;
+
+		// One untimed rekey, so every run keeps its key between messages like the policies do
+		if (!crypto_library->set_cipher(param, cipher) || !crypto_library->rekey(param))
+		{
+			printf("Error: [%s] failed to set %s, skipping it...\n", name, cipher);
+			ok = false;
+			continue;
+		}
+
+		printf("[%s] running %s rekey benchmark, %d messages of %zu bytes per interval...\n", name, cipher,
+			   REKEY_MESSAGES, message_size);
+		fflush(stdout);
+
+		// No rekeying before and after the policies, the faster run is the reference
+		bool cipher_ok = rekey_run(crypto_library, param, &never, message_size, dst, src, &baseline, &none);
+		for (size_t p = 0; p < REKEY_POLICIES && cipher_ok; ++p)
+		{
+			cipher_ok = rekey_run(crypto_library, param, &rekey_policies[p], message_size, dst, src, &elapsed[p],
+								  &rekeys[p]);
+		}
+		cipher_ok = cipher_ok && rekey_run(crypto_library, param, &never, message_size, dst, src, &baseline_end, &none);
+
+		if (!cipher_ok)
+		{
+			printf("Error: [%s] %s failed!\n", name, cipher);
+			ok = false;
+			continue;
+		}
+
+		if (baseline_end < baseline)
+		{
+			baseline = baseline_end;
+		}
+
+		const double total = (double)REKEY_MESSAGES * message_size;
+		printf("[%s] %s no rekey:                %9.2f MB/s\n", name, cipher, total / baseline / 1e6);
+
+		for (size_t p = 0; p < REKEY_POLICIES; ++p)
+		{
+			char interval[32];
+
+			format_policy(&rekey_policies[p], interval, sizeof(interval));
+			printf("[%s] %s rekey %-18s %9.2f MB/s (%6.2f%%), %7zu rekeys\n", name, cipher, interval,
+				   total / elapsed[p] / 1e6, 100.0 * baseline / elapsed[p], rekeys[p]);
+		}
+
+		// Sparse policies are within the noise, the cost of a rekey is taken from the densest one
+		const double rekey_time = elapsed[0] > baseline ? (elapsed[0] - baseline) / rekeys[0] : 0.0;
+		const double message_time = baseline / REKEY_MESSAGES;
+		const double messages = rekey_time / (REKEY_TOLERANCE * message_time);
+
+		if (messages <= 1.0)
+		{
+			printf("[%s] %s rekeys in %.1f ns, less than %.0f%% even with a new key for every message\n", name, cipher,
+				   1e9 * rekey_time, 100.0 * REKEY_TOLERANCE);
+		}
+		else
+		{
+			printf("[%s] %s rekeys in %.1f ns, less than %.0f%% with a new key every %.0f messages or %.0f KiB\n", name,
+				   cipher, 1e9 * rekey_time, 100.0 * REKEY_TOLERANCE, ceil(messages),
+				   ceil(messages) * message_size / 1024.0);
+		}
+	}
+
+	crypto_library->free(param);
+	free(src);
+	free(dst);
+	return ok;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "cbos.h"
+
+// Messages encrypted per cipher and rekey interval
+#ifndef REKEY_MESSAGES
+#define REKEY_MESSAGES 20000
+#endif
+
+// Throughput loss against no rekeying that is considered not measurable
+#ifndef REKEY_TOLERANCE
+#define REKEY_TOLERANCE 0.01
+#endif
+
+/**
+ * @brief Encrypts REKEY_MESSAGES messages with every cipher of a library that
+ * can be rekeyed, once without rekeying and once per rekey policy: a new key
+ * every N messages, like a record limit or the invocation limit of GCM, and
+ * a new key once N bytes were encrypted with the current one, like TLS 1.3 key
+ * updates or IPsec lifetimes. Reports the sustained throughput of every
+ * policy relative to no rekeying, the time per rekey from the policy with the
+ * most rekeys and the shortest interval that costs less than REKEY_TOLERANCE
+ * of the throughput.
+ *
+ * @param crypto_library Pointer to the cryptographic library.
+ * @param message_size Size of every message.
+ * @return True if the benchmark succeeds; otherwise, false.
+ */
+bool benchmark_rekey(const Crypto *crypto_library, const size_t message_size);
@@ -0,0 +1,146 @@
+#include "ring.h"
+
+/**
+ * Allocate an empty ring.
+ *
+ * @param ring The ring to initialize.
+ * @param capacity Number of slots, rounded up to a power of two.
+ * @param spsc True if the ring has exactly one producer and one consumer.
+ * @return true on success, false if memory allocation failed.
+ */
+bool ring_init(Ring *ring, size_t capacity, bool spsc)
+{
+  size_t size = 1;
+  while (size < capacity)
+  {
+    size <<= 1;
+  }
+
+  ring->cells = calloc(size, sizeof(RingCell));
+  if (!ring->cells)
+  {
+    return false;
+  }
+
+  for (size_t i = 0; i < size; ++i)
+  {
+    atomic_init(&ring->cells[i].sequence, i);
+  }
+
+  ring->mask = size - 1;
+  ring->spsc = spsc;
+  atomic_init(&ring->head, 0);
+  atomic_init(&ring->tail, 0);
+  return true;
+}
+
+/**
+ * Free the slots of a ring.
+ *
+ * @param ring The ring.
+ */
+void ring_free(Ring *ring)
+{
+  free(ring->cells);
+  ring->cells = NULL;
+}
+
+/**
+ * Append a value without blocking. SPSC rings publish the value by advancing
+ * the tail, MPMC rings claim a slot by advancing the tail and publish the value
+ * through the sequence number of the slot (bounded queue of D. Vyukov).
+ *
+ * @param ring The ring.
+ * @param value The value.
+ * @return true on success, false if the ring is full.
+ */
+bool ring_push(Ring *ring, uint32_t value)
+{
+  if (ring->spsc)
+  {
+    const size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    if (tail - atomic_load_explicit(&ring->head, memory_order_acquire) > ring->mask)
+    {
+      return false;
+    }
+
+    ring->cells[tail & ring->mask].value = value;
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    return true;
+  }
+
+  RingCell *cell;
+  size_t pos = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+  for (;;)
+  {
+    cell = &ring->cells[pos & ring->mask];
+    const intptr_t diff = (intptr_t)atomic_load_explicit(&cell->sequence, memory_order_acquire) - (intptr_t)pos;
+    if (diff == 0)
+    {
+      if (atomic_compare_exchange_weak_explicit(&ring->tail, &pos, pos + 1, memory_order_relaxed,
+                                                memory_order_relaxed))
+        break;
+    }
+    else if (diff < 0)
+    {
+      return false;
+    }
+    else
+    {
+      pos = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    }
+  }
+
+  cell->value = value;
+  atomic_store_explicit(&cell->sequence, pos + 1, memory_order_release);
+  return true;
+}
+
+/**
+ * Remove the oldest value without blocking.
+ *
+ * @param ring The ring.
+ * @param value Output for the value.
+ * @return true on success, false if the ring is empty.
+ */
+bool ring_pop(Ring *ring, uint32_t *value)
+{
+  if (ring->spsc)
+  {
+    const size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    if (head == atomic_load_explicit(&ring->tail, memory_order_acquire))
+    {
+      return false;
+    }
+
+    *value = ring->cells[head & ring->mask].value;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    return true;
+  }
+
+  RingCell *cell;
+  size_t pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  for (;;)
+  {
+    cell = &ring->cells[pos & ring->mask];
+    const intptr_t diff = (intptr_t)atomic_load_explicit(&cell->sequence, memory_order_acquire) - (intptr_t)(pos + 1);
+    if (diff == 0)
+    {
+      if (atomic_compare_exchange_weak_explicit(&ring->head, &pos, pos + 1, memory_order_relaxed,
+                                                memory_order_relaxed))
+        break;
+    }
+    else if (diff < 0)
+    {
+      return false;
+    }
+    else
+    {
+      pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    }
+  }
+
+  *value = cell->value;
+  atomic_store_explicit(&cell->sequence, pos + ring->mask + 1, memory_order_release);
+  return true;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stdatomic.h>
+
+#include "cbos.h"
+
+/**
+ * Slot of a ring. The sequence number is only used by rings with several
+ * producers or consumers.
+ */
+typedef struct RingCell
+{
+    atomic_size_t sequence;
+    uint32_t value;
+} RingCell;
+
+/**
+ * Bounded lock-free ring of 32-bit values. With one producer and one consumer
+ * (SPSC) it only synchronizes the head and tail, otherwise (MPMC) every slot
+ * carries a sequence number that producers and consumers claim it with.
+ */
+typedef struct Ring
+{
+    RingCell *cells;
+    size_t mask;
+    bool spsc;
+    _Alignas(64) atomic_size_t head; // Next slot to pop
+    _Alignas(64) atomic_size_t tail; // Next slot to push
+} Ring;
+
+/**
+ * @brief Allocates an empty ring.
+ *
+ * @param ring The ring to initialize.
+ * @param capacity Number of slots, rounded up to a power of two.
+ * @param spsc True if the ring has exactly one producer and one consumer.
+ * @return True on success, false if memory allocation failed.
+ */
+bool ring_init(Ring *ring, size_t capacity, bool spsc);
+
+/**
+ * @brief Frees the slots of a ring.
+ *
+ * @param ring The ring.
+ */
+void ring_free(Ring *ring);
+
+/**
+ * @brief Appends a value without blocking.
+ *
+ * @param ring The ring.
+ * @param value The value.
+ * @return True on success, false if the ring is full.
+ */
+bool ring_push(Ring *ring, uint32_t value);
+
+/**
+ * @brief Removes the oldest value without blocking.
+ *
+ * @param ring The ring.
+ * @param value Output for the value.
+ * @return True on success, false if the ring is empty.
+ */
+bool ring_pop(Ring *ring, uint32_t *value);
@@ -0,0 +1,237 @@
+#include "rng.h"
+#include "utils.h"
+
+// Nonce, IV and key sizes, where contention and syscall cost dominate
+static const size_t rng_request_sizes[] = {12, 16, 32};
+
+#define RNG_REQUEST_SIZES (sizeof(rng_request_sizes) / sizeof(rng_request_sizes[0]))
+
+/**
+ * State of one benchmark thread
+ */
+typedef struct RNGWorker
+{
+	const Crypto *crypto_library; // NULL for getrandom()
+	const char *rng;
+	void *shared; // Context shared by all threads, NULL if every thread owns one
+	size_t request_size;
+	size_t iterations;
+	double *latencies;
+	void *param;
+} RNGWorker;
+
+/**
+ * Generates random bytes with random_bytes() through the signature of
+ * Crypto::rng_bytes.
+ */
+static bool getrandom_bytes(void *param, const size_t size, void *dst)
+{
+	random_bytes(dst, size);
+	return true;
+}
+
+/**
+ * Uses the shared context or creates a generator for the thread itself.
+ *
+ * @param arg Pointer to an RNGWorker structure.
+ * @return True on success, otherwise false.
+ */
+static bool rng_setup(void *arg)
+{
+	RNGWorker *worker = arg;
+	const Crypto *crypto_library = worker->crypto_library;
+
+	worker->param = worker->shared;
+	if (crypto_library && !worker->param)
+	{
+		return crypto_library->init(&worker->param) && crypto_library->set_rng(worker->param, worker->rng, false);
+	}
+
+	return true;
+}
+
+/**
+ * Requests random bytes repeatedly.
+ *
+ * @param arg Pointer to an RNGWorker structure.
+ * @return True on success, otherwise false.
+ */
+static bool rng_run(void *arg)
+{
+	RNGWorker *worker = arg;
+	const Crypto *crypto_library = worker->crypto_library;
+	bool (*rng_bytes)(void *, const size_t, void *) = crypto_library ? crypto_library->rng_bytes : getrandom_bytes;
+	uint8_t buffer[64];
+	bool ok = true;
+
+	for (size_t i = 0; ok && i < worker->iterations; ++i)
+	{
+		const double call_start = seconds();
+		ok = rng_bytes(worker->param, worker->request_size, buffer);
+		worker->latencies[i] = seconds() - call_start;
+	}
+
+	return ok;
+}
+
+/**
+ * Frees the generator of the thread, not the shared one.
+ *
+ * @param arg Pointer to an RNGWorker structure.
+ */
+static void rng_cleanup(void *arg)
+{
+	RNGWorker *worker = arg;
+
+	if (worker->crypto_library && worker->param && worker->param != worker->shared)
+	{
+		worker->crypto_library->free(worker->param);
+	}
+}
+
+static const PinnedWork rng_work = {rng_setup, rng_run, rng_cleanup};
+
+/**
+ * Benchmarks one generator and request size with a number of threads.
+ *
+ * @param name Name of the library.
+ * @param crypto_library Pointer to the cryptographic library, NULL for getrandom().
+ * @param rng Name of the generator.
+ * @param shared Context shared by all threads, NULL if every thread owns a generator.
+ * @param request_size Bytes per call.
+ * @param threads Number of threads.
+ * @param iterations Number of calls per thread.
+ * @return True if the benchmark succeeds; otherwise, false.
+ */
+static bool run_rng(const char *name, const Crypto *crypto_library, const char *rng, void *shared,
+					const size_t request_size, const int threads, const size_t iterations)
+{
+	const size_t count = threads * iterations;
+	RNGWorker *workers = calloc(threads, sizeof(RNGWorker));
+	double *latencies = malloc(count * sizeof(double));
+	TimeSpan span;
+
+	if (!workers || !latencies)
+	{
+		printf("Error: [%s] failed to allocate %zu samples!\n", name, count);
+		free(workers);
+		free(latencies);
+		return false;
+	}
+
+	for (int t = 0; t < threads; ++t)
+	{
+		workers[t] = (RNGWorker){crypto_library, rng, shared, request_size, iterations, latencies + t * iterations,
+								 NULL};
+	}
+
+	const bool ok = run_pinned_threads(threads, NULL, &rng_work, workers, sizeof(RNGWorker), &span);
+
+	if (ok)
+	{
+		sort_samples(latencies, count);
+
+		printf("[%s] %s (%s), %zu-byte requests: %d thread(s), %.2f MB/s, latency p50 %.0f ns, p99 %.0f ns, p99.9 %.0f ns\n",
+			   name, rng, shared || !crypto_library ? "shared" : "per thread", request_size, threads,
+			   count * request_size / (span.end - span.start) / 1e6, 1e9 * percentile(latencies, count, 50),
+			   1e9 * percentile(latencies, count, 99), 1e9 * percentile(latencies, count, 99.9));
+	}
+	else
+	{
+		printf("Error: [%s] %s failed with %d thread(s)!\n", name, rng, threads);
+	}
+
+	free(workers);
+	free(latencies);
+	return ok;
+}
+
+/**
+ * Benchmarks one generator for every request size with 1, 2, 4, ... threads
+ * up to one thread per CPU.
+ */
+static bool run_rng_threads(const char *name, const Crypto *crypto_library, const char *rng, void *shared,
+							const size_t iterations)
+{
+	const int cpus = cpu_count();
+
+	for (size_t s = 0; s < RNG_REQUEST_SIZES; ++s)
+	{
+		for (int threads = 1; threads <= cpus; threads = next_thread_count(threads, cpus))
+		{
+			if (!run_rng(name, crypto_library, rng, shared, rng_request_sizes[s], threads, iterations))
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Benchmarks every random number generator of a library, first with one
+ * generator per thread and then with one generator shared by all threads.
+ * Generators that cannot be shared, e.g. Botan's "user" RNG, are only run per
+ * thread.
+ *
+ * @param crypto_library Pointer to the cryptographic library.
+ * @param iterations Number of calls per thread.
+ * @return True if the benchmark succeeds; otherwise, false.
+ */
+bool benchmark_rng(const Crypto *crypto_library, const size_t iterations)
+{
+	bool ok = true;
+	const char *name = crypto_library->name();
+
+	if (!crypto_library->rngs)
+	{
+		return true;
+	}
+
+	const char **rngs = crypto_library->rngs();
+	for (size_t i = 0; rngs[i] != NULL; ++i)
+	{
+		printf("[%s] running %s benchmark...\n", name, rngs[i]);
+
+		if (!run_rng_threads(name, crypto_library, rngs[i], NULL, iterations))
+		{
+			ok = false;
+			continue;
+		}
+
+		void *shared = NULL;
+		if (!crypto_library->init(&shared))
+		{
+			ok = false;
+			continue;
+		}
+
+		if (crypto_library->set_rng(shared, rngs[i], true))
+		{
+			ok = run_rng_threads(name, crypto_library, rngs[i], shared, iterations) && ok;
+		}
+		else
+		{
+			printf("[%s] %s cannot be shared between threads, skipped\n", name, rngs[i]);
+		}
+
+		crypto_library->free(shared);
+	}
+
+	return ok;
+}
+
+/**
+ * Benchmarks random_bytes(), which calls getrandom() and has no generator
+ * state in user space.
+ *
+ * @param iterations Number of calls per thread.
+ * @return True if the benchmark succeeds; otherwise, false.
+ */
+bool benchmark_getrandom(const size_t iterations)
+{
+	printf("[kernel] running getrandom() benchmark...\n");
+
+	return run_rng_threads("kernel", NULL, "getrandom()", NULL, iterations);
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "cbos.h"
+
+// Calls per thread and request size of every random number generator benchmark
+#ifndef RNG_ITERATIONS
+#define RNG_ITERATIONS 100000
+#endif
+
+/**
+ * @brief Benchmarks every random number generator of a library with 1, 2, 4,
+ * ... threads up to the number of CPUs, once with one generator per thread and
+ * once with a generator shared by all threads, and reports bytes per second
+ * and per-call latency for 12 to 32-byte requests.
+ *
+ * @param crypto_library Pointer to the cryptographic library.
+ * @param iterations Number of calls per thread.
+ * @return True if the benchmark succeeds; otherwise, false.
+ */
+bool benchmark_rng(const Crypto *crypto_library, const size_t iterations);
+
+/**
+ * @brief Benchmarks random_bytes(), i.e. getrandom(), like benchmark_rng().
+ *
+ * @param iterations Number of calls per thread.
+ * @return True if the benchmark succeeds; otherwise, false.
+ */
+bool benchmark_getrandom(const size_t iterations);
@@ -0,0 +1,534 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <sys/wait.h>
+
+#include "schedule.h"
+#include "utils.h"
+
+static const size_t schedule_sizes[] = {SCHEDULE_SIZES};
+
+#define SCHEDULE_SIZE_COUNT (sizeof(schedule_sizes) / sizeof(schedule_sizes[0]))
+
+/**
+ * One repetition of a (library, cipher, message size, threads) case
+ */
+typedef struct Case
+{
+	const Crypto *crypto_library;
+	const char *cipher;
+	size_t message_size;
+	int threads;
+	int *cores; // Indices into the usable cores while running
+	pid_t pid;
+	int fd; // Read end of the result pipe
+	double start;
+	double end;
+	double bytes_per_second;
+	bool ok;
+} Case;
+
+/**
+ * Result a child writes to its pipe, smaller than PIPE_BUF so the write is
+ * atomic and never blocks
+ */
+typedef struct CaseResult
+{
+	double bytes_per_second;
+	bool ok;
+} CaseResult;
+
+/**
+ * State of one encrypting thread of a child
+ */
+typedef struct CaseWorker
+{
+	const Case *run;
+	uint8_t *src;
+	uint8_t *dst;
+	void *param;
+} CaseWorker;
+
+/**
+ * Sets up the context, key and buffers of a thread and warms them up before
+ * the threads start together.
+ *
+ * @param arg Pointer to a CaseWorker structure.
+ * @return True on success, otherwise false.
+ */
+static bool case_setup(void *arg)
+{
+	CaseWorker *worker = arg;
+	const Case *run = worker->run;
+	const Crypto *crypto_library = run->crypto_library;
+	const size_t message_size = run->message_size;
+
+	// The output also has to hold the tag of AEAD ciphers
+	const size_t buffer_size = message_size + MAX_DIGEST_SIZE;
+	worker->src = malloc(buffer_size);
+	worker->dst = malloc(buffer_size);
+
+	bool ok = worker->src && worker->dst && crypto_library->init(&worker->param) &&
+			  crypto_library->random(worker->param, buffer_size, worker->src) &&
+			  crypto_library->set_cipher(worker->param, run->cipher);
+
+	for (size_t i = 0; ok && i < SCHEDULE_ITERATIONS / 100; ++i)
+	{
+		ok = crypto_library->encrypt(worker->param, message_size, worker->dst, worker->src);
+	}
+
+	return ok;
+}
+
+/**
+ * Encrypts SCHEDULE_ITERATIONS messages.
+ *
+ * @param arg Pointer to a CaseWorker structure.
+ * @return True on success, otherwise false.
+ */
+static bool case_run(void *arg)
+{
+	CaseWorker *worker = arg;
+	const Crypto *crypto_library = worker->run->crypto_library;
+	bool ok = true;
+
+	for (size_t i = 0; ok && i < SCHEDULE_ITERATIONS; ++i)
+	{
+		ok = crypto_library->encrypt(worker->param, worker->run->message_size, worker->dst, worker->src);
+	}
+
+	return ok;
+}
+
+/**
+ * Frees the context and buffers of a thread.
+ *
+ * @param arg Pointer to a CaseWorker structure.
+ */
+static void case_cleanup(void *arg)
+{
+	CaseWorker *worker = arg;
+
+	if (worker->param)
+	{
+		worker->run->crypto_library->free(worker->param);
+	}
+	free(worker->src);
+	free(worker->dst);
+}
+
+static const PinnedWork case_work = {case_setup, case_run, case_cleanup};
+
+/**
+ * Runs one case in the child process and writes its result to the pipe.
+ *
+ * @param run The case with its cores.
+ * @param usable The usable cores.
+ * @param fd Write end of the result pipe.
+ */
+static void run_case(const Case *run, const int *usable, int fd)
+{
+	const int threads = run->threads;
+	CaseWorker workers[threads];
+	int cpus[threads];
+	CaseResult result = {0.0, true};
+	TimeSpan span;
+
+	for (int t = 0; t < threads; ++t)
+	{
+		workers[t] = (CaseWorker){run, NULL, NULL, NULL};
+		cpus[t] = usable[run->cores[t]];
+	}
+
+	result.ok = run_pinned_threads(threads, cpus, &case_work, workers, sizeof(CaseWorker), &span);
+
+	if (result.ok)
+	{
+		result.bytes_per_second = (double)threads * SCHEDULE_ITERATIONS * run->message_size / (span.end - span.start);
+	}
+
+	if (write(fd, &result, sizeof(result)) != sizeof(result))
+	{
+		printf("Error: failed to report the result of %s: %s\n", run->cipher, strerror(errno));
+	}
+}
+
+/**
+ * Reads the cores the scheduler may use: the isolated CPUs if there are any,
+ * otherwise all online CPUs.
+ *
+ * @param usable Output for the CPU indices, cpu_count() entries.
+ * @return Number of usable cores.
+ */
+static int usable_cores(int *usable)
+{
+	const int cpus = cpu_count();
+	int count = 0;
+	char list[256] = "";
+
+	FILE *file = fopen("/sys/devices/system/cpu/isolated", "r");
+	if (file)
+	{
+		if (!fgets(list, sizeof(list), file))
+		{
+			list[0] = '\0';
+		}
+		fclose(file);
+	}
+
+	// The list has the form "2-5,7"
+	for (char *range = strtok(list, ",\n"); range; range = strtok(NULL, ",\n"))
+	{
+		int first = 0, last = 0;
+		const int fields = sscanf(range, "%d-%d", &first, &last);
+		if (fields < 1)
+			continue;
+		if (fields == 1)
+			last = first;
+		for (int cpu = first; cpu <= last && count < cpus; ++cpu)
+			usable[count++] = cpu;
+	}
+
+	if (count > 0)
+	{
+		return count;
+	}
+
+	for (int cpu = 0; cpu < cpus; ++cpu)
+	{
+		usable[cpu] = cpu;
+	}
+
+	return cpus;
+}
+
+/**
+ * Reserves free cores for a case.
+ *
+ * @param run The case, its cores are stored in run->cores.
+ * @param busy Busy flag of every usable core.
+ * @param count Number of usable cores.
+ * @return True if enough cores were free, otherwise false and nothing is reserved.
+ */
+static bool reserve_cores(Case *run, bool *busy, int count)
+{
+	int found = 0;
+	for (int i = 0; i < count && found < run->threads; ++i)
+	{
+		if (!busy[i])
+			run->cores[found++] = i;
+	}
+
+	if (found < run->threads)
+	{
+		return false;
+	}
+
+	for (int t = 0; t < run->threads; ++t)
+	{
+		busy[run->cores[t]] = true;
+	}
+
+	return true;
+}
+
+/**
+ * Forks the child process of a case.
+ *
+ * @param run The case with its reserved cores.
+ * @param usable The usable cores.
+ * @return True if the child was started, otherwise false.
+ */
+static bool launch_case(Case *run, const int *usable)
+{
+	int fds[2];
+
+	if (pipe(fds) != 0)
+	{
+		printf("Error: pipe() failed: %s\n", strerror(errno));
+		return false;
+	}
+
+	// Buffered output would otherwise be printed by the child again
+	fflush(stdout);
+
+	run->start = seconds();
+	run->pid = fork();
+	if (run->pid < 0)
+	{
+		printf("Error: fork() failed: %s\n", strerror(errno));
+		close(fds[0]);
+		close(fds[1]);
+		return false;
+	}
+	else if (run->pid == 0)
+	{
+		close(fds[0]);
+		pin_thread(usable[run->cores[0]]);
+		run_case(run, usable, fds[1]);
+		close(fds[1]);
+		fflush(stdout);
+		_exit(0);
+	}
+
+	close(fds[1]);
+	run->fd = fds[0];
+	return true;
+}
+
+/**
+ * Collects the result of a finished child.
+ *
+ * @param run The case of the child.
+ * @param status Exit status from waitpid().
+ */
+static void collect_case(Case *run, int status)
+{
+	CaseResult result = {0.0, false};
+
+	run->end = seconds();
+
+	if (read(run->fd, &result, sizeof(result)) != sizeof(result) || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+	{
+		result.ok = false;
+	}
+	close(run->fd);
+
+	run->ok = result.ok;
+	run->bytes_per_second = result.bytes_per_second;
+	run->pid = 0;
+}
+
+/**
+ * Compares throughputs for qsort().
+ */
+static int compare_throughput(const void *a, const void *b)
+{
+	const double x = (*(const Case *const *)a)->bytes_per_second;
+	const double y = (*(const Case *const *)b)->bytes_per_second;
+	return (x > y) - (x < y);
+}
+
+/**
+ * Prints the median, minimum and maximum throughput of every case over its
+ * repetitions, in the order of the matrix.
+ *
+ * @param cases All repetitions, SCHEDULE_REPETITIONS consecutive ones per case.
+ * @param count Number of repetitions.
+ */
+static void print_cases(const Case *cases, size_t count)
+{
+	printf("\n%-36s %-20s %8s %7s %11s %11s %11s %7s\n", "Library", "Cipher", "Size", "Threads", "Median MB/s",
+		   "Min MB/s", "Max MB/s", "Spread");
+
+	for (size_t i = 0; i < count; i += SCHEDULE_REPETITIONS)
+	{
+		const Case *sorted[SCHEDULE_REPETITIONS];
+		size_t valid = 0;
+
+		for (size_t r = 0; r < SCHEDULE_REPETITIONS; ++r)
+		{
+			if (cases[i + r].ok)
+				sorted[valid++] = &cases[i + r];
+		}
+
+		const Case *run = &cases[i];
+		if (valid == 0)
+		{
+			printf("%-36s %-20s %8zu %7d %11s\n", run->crypto_library->name(), run->cipher, run->message_size,
+				   run->threads, "failed");
+			continue;
+		}
+
+		qsort(sorted, valid, sizeof(sorted[0]), compare_throughput);
+
+		const double median = sorted[valid / 2]->bytes_per_second;
+		const double min = sorted[0]->bytes_per_second;
+		const double max = sorted[valid - 1]->bytes_per_second;
+
+		printf("%-36s %-20s %8zu %7d %11.1f %11.1f %11.1f %6.2f%%", run->crypto_library->name(), run->cipher,
+			   run->message_size, run->threads, median / 1e6, min / 1e6, max / 1e6, 100.0 * (max - min) / median);
+		if (valid < SCHEDULE_REPETITIONS)
+			printf(" (%zu of %d failed)", SCHEDULE_REPETITIONS - valid, SCHEDULE_REPETITIONS);
+		printf("\n");
+	}
+}
+
+/**
+ * Runs the benchmark matrix of all libraries in random order in forked
+ * children.
+ *
+ * @param libs NULL-terminated list of the libraries.
+ * @param jobs Cases running at the same time, 0 for one per usable core.
+ * @param seed Seed of the random order.
+ * @return True if all cases succeed; otherwise, false.
+ */
+bool benchmark_schedule(const Crypto **libs, int jobs, unsigned int seed)
+{
+	int usable[cpu_count()];
+	const int cores = usable_cores(usable);
+	bool busy[cores];
+	bool ok = true;
+
+	memset(busy, 0, sizeof(busy));
+
+	if (jobs <= 0 || jobs > cores)
+	{
+		jobs = cores;
+	}
+
+	// Expand the matrix, repetitions of a case are consecutive
+	size_t count = 0, capacity = 0;
+	Case *cases = NULL;
+
+	for (size_t l = 0; libs[l] != NULL; ++l)
+	{
+		const char **ciphers = libs[l]->ciphers();
+		for (size_t c = 0; ciphers[c] != NULL; ++c)
+		{
+			for (size_t s = 0; s < SCHEDULE_SIZE_COUNT; ++s)
+			{
+				const size_t size = schedule_sizes[s] ? schedule_sizes[s] : (size_t)get_message_size();
+				for (int threads = 1; threads <= cores; threads = next_thread_count(threads, cores))
+				{
+					for (size_t r = 0; r < SCHEDULE_REPETITIONS; ++r)
+					{
+						if (count == capacity)
+						{
+							capacity = capacity ? 2 * capacity : 64;
+							Case *grown = realloc(cases, capacity * sizeof(Case));
+							if (!grown)
+							{
+								printf("Error: failed to allocate %zu cases!\n", capacity);
+								for (size_t i = 0; i < count; ++i)
+									free(cases[i].cores);
+								free(cases);
+								return false;
+							}
+							cases = grown;
+						}
+
+						cases[count] = (Case){libs[l], ciphers[c], size, threads, malloc(threads * sizeof(int)), 0, -1,
+											  0.0, 0.0, 0.0, false};
+						if (!cases[count++].cores)
+						{
+							printf("Error: failed to allocate the cores of %zu cases!\n", count);
+							ok = false;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	printf("Scheduling %zu runs on %d core(s), %d at a time, seed %u...\n", count, cores, jobs, seed);
+
+	// Shuffle the execution order, which interleaves the repetitions
+	size_t *order = malloc(count * sizeof(size_t));
+	for (size_t i = 0; order && i < count; ++i)
+	{
+		order[i] = i;
+	}
+	for (size_t i = count; order && i > 1; --i)
+	{
+		const size_t j = rand_r(&seed) % i;
+		const size_t swap = order[i - 1];
+		order[i - 1] = order[j];
+		order[j] = swap;
+	}
+
+	if (!order || !ok)
+	{
+		printf("Error: failed to allocate %zu cases!\n", count);
+		for (size_t i = 0; i < count; ++i)
+			free(cases[i].cores);
+		free(cases);
+		free(order);
+		return false;
+	}
+
+	size_t next = 0, finished = 0;
+	int running = 0;
+	double busy_time = 0.0;
+	const double start = seconds();
+
+	while (finished < count)
+	{
+		// Start cases in the shuffled order as long as their cores are free
+		while (next < count && running < jobs && reserve_cores(&cases[order[next]], busy, cores))
+		{
+			Case *run = &cases[order[next++]];
+			if (launch_case(run, usable))
+			{
+				++running;
+				continue;
+			}
+
+			for (int t = 0; t < run->threads; ++t)
+				busy[run->cores[t]] = false;
+			++finished;
+			ok = false;
+		}
+
+		if (running == 0)
+		{
+			continue;
+		}
+
+		int status = 0;
+		const pid_t pid = waitpid(-1, &status, 0);
+		if (pid < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			printf("Error: waitpid() failed: %s\n", strerror(errno));
+			ok = false;
+			break;
+		}
+
+		Case *run = NULL;
+		for (size_t i = 0; i < count && !run; ++i)
+		{
+			if (cases[i].pid == pid)
+				run = &cases[i];
+		}
+
+		if (!run)
+		{
+			continue;
+		}
+
+		collect_case(run, status);
+		for (int t = 0; t < run->threads; ++t)
+			busy[run->cores[t]] = false;
+		--running;
+		++finished;
+		busy_time += run->end - run->start;
+
+		if (run->ok)
+		{
+			printf("[%s] %s, %zu bytes, %d thread(s): %.1f MB/s (%zu/%zu)\n", run->crypto_library->name(), run->cipher,
+				   run->message_size, run->threads, run->bytes_per_second / 1e6, finished, count);
+		}
+		else
+		{
+			printf("Error: [%s] %s, %zu bytes, %d thread(s) failed (%zu/%zu)\n", run->crypto_library->name(),
+				   run->cipher, run->message_size, run->threads, finished, count);
+			ok = false;
+		}
+	}
+
+	const double wall = seconds() - start;
+
+	print_cases(cases, count);
+	printf("\n%zu runs in %.1f s wall-clock, %.1f s of runs, %.2f runs in parallel on average\n", count, wall,
+		   busy_time, wall > 0.0 ? busy_time / wall : 0.0);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		free(cases[i].cores);
+	}
+	free(cases);
+	free(order);
+
+	return ok;
+}
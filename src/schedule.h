@@ -0,0 +1,34 @@
+#pragma once
+
+#include "cbos.h"
+
+// Message sizes of the matrix, e.g. -DSCHEDULE_SIZES=64,1024,16384; defaults to the message size of the library
+#ifndef SCHEDULE_SIZES
+#define SCHEDULE_SIZES 0
+#endif
+
+// Repetitions of every case, interleaved with all other cases
+#ifndef SCHEDULE_REPETITIONS
+#define SCHEDULE_REPETITIONS 5
+#endif
+
+// Encrypt calls per thread and case
+#ifndef SCHEDULE_ITERATIONS
+#define SCHEDULE_ITERATIONS 100000
+#endif
+
+/**
+ * @brief Expands the (library, cipher, message size, threads) matrix of all
+ * libraries, repeats every case SCHEDULE_REPETITIONS times and runs the cases
+ * in a random order, each in a forked child process pinned to its own cores.
+ * Children report over a pipe, so no case inherits the heap, caches or branch
+ * predictor state of another one. Up to `jobs` cases run at the same time on
+ * disjoint cores, taken from /sys/devices/system/cpu/isolated if CPUs are
+ * isolated and from all online CPUs otherwise.
+ *
+ * @param libs NULL-terminated list of the libraries.
+ * @param jobs Cases running at the same time, 0 for one per usable core.
+ * @param seed Seed of the random order, printed to reproduce it.
+ * @return True if all cases succeed; otherwise, false.
+ */
+bool benchmark_schedule(const Crypto **libs, int jobs, unsigned int seed);
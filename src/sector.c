@@ -0,0 +1,195 @@
+#include "sector.h"
+#include "utils.h"
+
+// Sizes of the data units, the sectors of a legacy and of an Advanced Format disk
+static const size_t sector_sizes[] = {512, 4096};
+
+#define SECTOR_SIZES (sizeof(sector_sizes) / sizeof(sector_sizes[0]))
+
+/**
+ * State of one benchmark thread
+ */
+typedef struct SectorWorker
+{
+	const Crypto *crypto_library;
+	const char *cipher;
+	size_t sector_size;
+	uint8_t *dst;
+	const uint8_t *src;
+	uint64_t first_sector; // Number of the first sector of the range of the thread
+	size_t sectors;
+	void *param;
+} SectorWorker;
+
+/**
+ * Encrypts every sector of a range once.
+ *
+ * @param worker The worker owning the range, with the cipher already set.
+ * @return True on success, otherwise false.
+ */
+static bool sector_pass(const SectorWorker *worker)
+{
+	const size_t size = worker->sector_size;
+
+	for (size_t s = 0; s < worker->sectors; ++s)
+	{
+		if (worker->crypto_library->encrypt_sector(worker->param, worker->first_sector + s, size,
+												   worker->dst + s * size, worker->src + s * size) != size)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Creates the context of a thread and encrypts its range once, untimed.
+ *
+ * @param arg Pointer to a SectorWorker structure.
+ * @return True on success, otherwise false.
+ */
+static bool sector_setup(void *arg)
+{
+	SectorWorker *worker = arg;
+
+	return worker->crypto_library->init(&worker->param) &&
+		   worker->crypto_library->set_cipher(worker->param, worker->cipher) && sector_pass(worker);
+}
+
+/**
+ * Encrypts the sector range of a thread SECTOR_PASSES times.
+ *
+ * @param arg Pointer to a SectorWorker structure.
+ * @return True on success, otherwise false.
+ */
+static bool sector_run(void *arg)
+{
+	bool ok = true;
+
+	for (int pass = 0; ok && pass < SECTOR_PASSES; ++pass)
+	{
+		ok = sector_pass(arg);
+	}
+
+	return ok;
+}
+
+/**
+ * Frees the context of a thread.
+ *
+ * @param arg Pointer to a SectorWorker structure.
+ */
+static void sector_cleanup(void *arg)
+{
+	SectorWorker *worker = arg;
+
+	if (worker->param)
+	{
+		worker->crypto_library->free(worker->param);
+	}
+}
+
+static const PinnedWork sector_work = {sector_setup, sector_run, sector_cleanup};
+
+/**
+ * Encrypts the region with one sector size and a number of threads.
+ *
+ * @param crypto_library Pointer to the cryptographic library.
+ * @param cipher Name of the cipher.
+ * @param sector_size Size of every sector.
+ * @param threads Number of threads.
+ * @param dst Output region.
+ * @param src Input region.
+ * @return True if the benchmark succeeds; otherwise, false.
+ */
+static bool run_sector(const Crypto *crypto_library, const char *cipher, const size_t sector_size, const int threads,
+					   uint8_t *dst, const uint8_t *src)
+{
+	const char *name = crypto_library->name();
+	const size_t total = SECTOR_REGION / sector_size;
+	const size_t per_thread = total / threads;
+	SectorWorker *workers = calloc(threads, sizeof(SectorWorker));
+	TimeSpan span;
+
+	if (!workers)
+	{
+		printf("Error: [%s] failed to allocate %d workers!\n", name, threads);
+		return false;
+	}
+
+	for (int t = 0; t < threads; ++t)
+	{
+		// The last thread also takes the sectors left over by the division
+		const size_t first = t * per_thread;
+		const size_t sectors = t == threads - 1 ? total - first : per_thread;
+
+		workers[t] = (SectorWorker){crypto_library, cipher, sector_size, dst + first * sector_size,
+									src + first * sector_size, first, sectors, NULL};
+	}
+
+	const bool ok = run_pinned_threads(threads, NULL, &sector_work, workers, sizeof(SectorWorker), &span);
+
+	if (ok)
+	{
+		const double sectors = (double)total * SECTOR_PASSES;
+		const double elapsed = span.end - span.start;
+
+		printf("[%s] %s %zu-byte sectors, %d thread(s): %.0f sectors/s, %.3f GB/s\n", name, cipher, sector_size,
+			   threads, sectors / elapsed, sectors * sector_size / elapsed / 1e9);
+	}
+	else
+	{
+		printf("Error: [%s] %s failed with %zu-byte sectors and %d thread(s)!\n", name, cipher, sector_size, threads);
+	}
+
+	free(workers);
+	return ok;
+}
+
+bool benchmark_sector(const Crypto *crypto_library)
+{
+	bool ok = true;
+	const char *name = crypto_library->name();
+	const int cpus = cpu_count();
+
+	if (!crypto_library->encrypt_sector)
+	{
+		return true;
+	}
+
+	uint8_t *src = malloc(SECTOR_REGION);
+	uint8_t *dst = malloc(SECTOR_REGION);
+	if (!src || !dst)
+	{
+		printf("Error: [%s] failed to allocate a region of %zu bytes!\n", name, (size_t)SECTOR_REGION);
+		free(src);
+		free(dst);
+		return false;
+	}
+
+	random_bytes(src, SECTOR_REGION);
+
+	const char **ciphers = crypto_library->ciphers();
+	for (size_t i = 0; ok && ciphers[i] != NULL; ++i)
+	{
+		if (!strstr(ciphers[i], "XTS"))
+		{
+			continue;
+		}
+
+		printf("[%s] running %s sector benchmark...\n", name, ciphers[i]);
+
+		for (size_t s = 0; ok && s < SECTOR_SIZES; ++s)
+		{
+			for (int threads = 1; ok && threads <= cpus; threads = next_thread_count(threads, cpus))
+			{
+				ok = run_sector(crypto_library, ciphers[i], sector_sizes[s], threads, dst, src);
+			}
+		}
+	}
+
+	free(src);
+	free(dst);
+	return ok;
+}
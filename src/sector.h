@@ -0,0 +1,27 @@
+#pragma once
+
+#include "cbos.h"
+
+// Bytes of the simulated disk region, split among the threads
+#ifndef SECTOR_REGION
+#define SECTOR_REGION (64UL << 20)
+#endif
+
+// Passes over the whole region per sector size and thread count
+#ifndef SECTOR_PASSES
+#define SECTOR_PASSES 4
+#endif
+
+/**
+ * @brief Encrypts a region of SECTOR_REGION bytes like dm-crypt or FileVault
+ * do, as independent 512-byte and 4096-byte data units with every XTS cipher
+ * of a library. Every sector is encrypted with the tweak of its own sector
+ * number, so the key stays the same and only the tweak changes between calls.
+ * The region is split into contiguous sector ranges, one per thread, from one
+ * thread up to one thread per CPU. Reports sectors per second and GB/s of
+ * every sector size and thread count.
+ *
+ * @param crypto_library Pointer to the cryptographic library.
+ * @return True if the benchmark succeeds; otherwise, false.
+ */
+bool benchmark_sector(const Crypto *crypto_library);
@@ -0,0 +1,377 @@
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "stats.h"
+#include "utils.h"
+
+// Largest sample the bootstrap resamples from
+#define STATS_BOOTSTRAP_SAMPLES 20000
+
+/**
+ * Reasons a sample is rejected
+ */
+typedef enum Rejection
+{
+	REJECT_SWITCH,
+	REJECT_FAULT,
+	REJECT_INTERRUPT,
+	REJECT_UNEXPLAINED,
+	REJECTIONS
+} Rejection;
+
+static const char *rejection_names[REJECTIONS] = {"context switch", "page fault", "interrupt", "unexplained"};
+
+// /proc/interrupts, opened once and read again from its start for every window
+static int interrupts_fd = -1;
+static char *interrupts_text = NULL;
+static size_t interrupts_capacity = 0;
+
+/**
+ * Reads all of /proc/interrupts into interrupts_text. The buffer is sized by
+ * the first read and only grows again if the file does, so rows of machines
+ * with many CPUs are never split.
+ *
+ * @return Length of the text, 0 if the file cannot be read.
+ */
+static size_t read_interrupts(void)
+{
+	size_t length = 0;
+
+	if (interrupts_fd < 0 && (interrupts_fd = open("/proc/interrupts", O_RDONLY | O_CLOEXEC)) < 0)
+	{
+		return 0;
+	}
+
+	while (true)
+	{
+		if (length + 1 >= interrupts_capacity)
+		{
+			const size_t capacity = interrupts_capacity ? 2 * interrupts_capacity : 16384;
+			char *text = realloc(interrupts_text, capacity);
+			if (!text)
+			{
+				return 0;
+			}
+			interrupts_text = text;
+			interrupts_capacity = capacity;
+		}
+
+		const size_t room = interrupts_capacity - 1 - length;
+		const ssize_t got = pread(interrupts_fd, interrupts_text + length, room, (off_t)length);
+		if (got < 0)
+		{
+			return 0;
+		}
+
+		length += (size_t)got;
+
+		// Less than the room is the end of the file
+		if ((size_t)got < room)
+		{
+			break;
+		}
+	}
+
+	interrupts_text[length] = '\0';
+	return length;
+}
+
+/**
+ * Sums the interrupts of one CPU over all sources of /proc/interrupts.
+ *
+ * @param cpu Column of the CPU.
+ * @return The sum, 0 if the file cannot be read.
+ */
+static long long cpu_interrupts(int cpu)
+{
+	long long total = 0;
+
+	if (read_interrupts() == 0)
+	{
+		return 0;
+	}
+
+	// The first line names the CPU columns
+	char *line = strchr(interrupts_text, '\n');
+
+	while (line)
+	{
+		++line;
+		char *next = strchr(line, '\n');
+		if (next)
+			*next = '\0';
+
+		char *field = strchr(line, ':');
+		if (field)
+		{
+			++field;
+
+			// Sources like ERR and MIS only have one column
+			for (int column = 0; column <= cpu; ++column)
+			{
+				char *end = NULL;
+				const long long value = strtoll(field, &end, 10);
+				if (end == field)
+					break;
+				if (column == cpu)
+					total += value;
+				field = end;
+			}
+		}
+
+		line = next;
+	}
+
+	return total;
+}
+
+/**
+ * Read the interrupts of the current CPU and the context switches and page
+ * faults of the calling thread.
+ *
+ * @param counters Output for the counters.
+ */
+void window_counters(WindowCounters *counters)
+{
+	struct rusage usage;
+
+	counters->cpu = sched_getcpu();
+	counters->interrupts = counters->cpu >= 0 ? cpu_interrupts(counters->cpu) : 0;
+
+	if (getrusage(RUSAGE_THREAD, &usage) == 0)
+	{
+		counters->switches = usage.ru_nvcsw + usage.ru_nivcsw;
+		counters->page_faults = usage.ru_minflt + usage.ru_majflt;
+	}
+	else
+	{
+		counters->switches = 0;
+		counters->page_faults = 0;
+	}
+}
+
+/**
+ * Compute the change of the counters over a window. Interrupts are only
+ * comparable if the thread stayed on its CPU; a migration is a context
+ * switch anyway.
+ *
+ * @param start Counters at the start of the window.
+ * @param end Counters at its end.
+ * @return The change.
+ */
+WindowCounters window_delta(const WindowCounters *start, const WindowCounters *end)
+{
+	WindowCounters delta = {0, end->switches - start->switches, end->page_faults - start->page_faults, start->cpu};
+
+	if (start->cpu == end->cpu)
+	{
+		delta.interrupts = end->interrupts - start->interrupts;
+	}
+	else if (delta.switches == 0)
+	{
+		delta.switches = 1;
+	}
+
+	return delta;
+}
+
+/**
+ * Returns the median of unsorted samples, which are reordered.
+ */
+double sample_median(double *samples, size_t count)
+{
+	size_t low = 0, high = count - 1;
+	const size_t k = (count - 1) / 2;
+
+	// Quickselect with the middle element as pivot
+	while (low < high)
+	{
+		const double pivot = samples[low + (high - low) / 2];
+		size_t i = low, j = high;
+
+		while (i <= j)
+		{
+			while (samples[i] < pivot)
+				++i;
+			while (samples[j] > pivot)
+				--j;
+			if (i <= j)
+			{
+				const double swap = samples[i];
+				samples[i] = samples[j];
+				samples[j] = swap;
+				++i;
+				if (j == 0)
+					break;
+				--j;
+			}
+		}
+
+		if (k <= j)
+			high = j;
+		else if (k >= i)
+			low = i;
+		else
+			break;
+	}
+
+	return samples[k];
+}
+
+/**
+ * Computes a percentile bootstrap confidence interval of the median. Large
+ * sample sets are subsampled to STATS_BOOTSTRAP_SAMPLES and the interval is
+ * narrowed by the square root of the size ratio, as the spread of the median
+ * shrinks with the square root of the sample size.
+ *
+ * @param samples The samples.
+ * @param count Number of samples.
+ * @param median Median of all samples.
+ * @param low Output for the lower end of the 95% interval.
+ * @param high Output for the upper end.
+ * @return True on success, false if memory allocation failed.
+ */
+static bool bootstrap_median(const double *samples, size_t count, double median, double *low, double *high)
+{
+	const size_t size = count < STATS_BOOTSTRAP_SAMPLES ? count : STATS_BOOTSTRAP_SAMPLES;
+	double *resample = malloc(size * sizeof(double));
+	double *medians = malloc(STATS_BOOTSTRAP * sizeof(double));
+	uint64_t state = 0x2545F4914F6CDD1DULL;
+
+	if (!resample || !medians)
+	{
+		free(resample);
+		free(medians);
+		return false;
+	}
+
+	for (size_t b = 0; b < STATS_BOOTSTRAP; ++b)
+	{
+		for (size_t i = 0; i < size; ++i)
+		{
+			state ^= state << 13;
+			state ^= state >> 7;
+			state ^= state << 17;
+			resample[i] = samples[state % count];
+		}
+		medians[b] = sample_median(resample, size);
+	}
+
+	sort_samples(medians, STATS_BOOTSTRAP);
+
+	const double scale = sqrt((double)size / count);
+	*low = median - scale * (median - percentile(medians, STATS_BOOTSTRAP, 2.5));
+	*high = median + scale * (percentile(medians, STATS_BOOTSTRAP, 97.5) - median);
+
+	free(resample);
+	free(medians);
+	return true;
+}
+
+/**
+ * Print robust statistics and the outliers of the samples of one benchmark.
+ *
+ * @param name Name of the library.
+ * @param samples Samples in measurement order.
+ * @param count Number of samples.
+ * @param windows Counter deltas of every STATS_WINDOW samples.
+ * @param unit Unit of the samples for the output.
+ */
+void print_robust_stats(const char *name, const double *samples, size_t count, const WindowCounters *windows,
+						const char *unit)
+{
+	double *sorted = malloc(count * sizeof(double));
+	double *deviations = malloc(count * sizeof(double));
+
+	if (!sorted || !deviations || count == 0)
+	{
+		printf("Error: [%s] failed to allocate %zu samples for the robust statistics!\n", name, count);
+		free(sorted);
+		free(deviations);
+		return;
+	}
+
+	memcpy(sorted, samples, count * sizeof(double));
+	sort_samples(sorted, count);
+
+	const double median = percentile(sorted, count, 50);
+	for (size_t i = 0; i < count; ++i)
+	{
+		deviations[i] = fabs(sorted[i] - median);
+	}
+	sort_samples(deviations, count);
+	const double mad = percentile(deviations, count, 50);
+
+	const size_t trim = (size_t)(count * STATS_TRIM);
+	double trimmed = 0.0;
+	for (size_t i = trim; i < count - trim; ++i)
+	{
+		trimmed += sorted[i];
+	}
+	trimmed /= count - 2 * trim;
+
+	double ci_low = median, ci_high = median;
+	bootstrap_median(samples, count, median, &ci_low, &ci_high);
+
+	printf("[%s] Median: %lf %s, MAD: %lf, %.0f%% trimmed mean: %lf, 95%% CI of the median: [%lf, %lf]\n", name,
+		   median, unit, mad, 100.0 * STATS_TRIM, trimmed, ci_low, ci_high);
+
+	// Quantized samples can have a MAD of 0, then only deviations beyond 1% count
+	double threshold = STATS_OUTLIER_MADS * 1.4826 * mad;
+	if (threshold < 0.01 * median)
+	{
+		threshold = 0.01 * median;
+	}
+
+	size_t rejected[REJECTIONS] = {0};
+	size_t kept = 0;
+	double sum = 0.0, sum_squares = 0.0;
+
+	for (size_t start = 0; start < count; start += STATS_WINDOW)
+	{
+		const WindowCounters *window = &windows[start / STATS_WINDOW];
+		long long causes[REJECT_UNEXPLAINED] = {window->switches, window->page_faults, window->interrupts};
+		const size_t end = start + STATS_WINDOW < count ? start + STATS_WINDOW : count;
+
+		for (size_t i = start; i < end; ++i)
+		{
+			if (fabs(samples[i] - median) <= threshold)
+			{
+				++kept;
+				sum += samples[i];
+				sum_squares += samples[i] * samples[i];
+				continue;
+			}
+
+			// Every counted event explains one outlier of its window
+			Rejection reason = REJECT_SWITCH;
+			while (reason < REJECT_UNEXPLAINED && causes[reason] <= 0)
+				reason++;
+			if (reason < REJECT_UNEXPLAINED)
+				causes[reason]--;
+			rejected[reason]++;
+		}
+	}
+
+	printf("[%s] Rejected %zu of %zu samples beyond %.1f robust standard deviations:", name, count - kept, count,
+		   STATS_OUTLIER_MADS);
+	for (int r = 0; r < REJECTIONS; ++r)
+	{
+		printf("%s %zu %s", r ? "," : "", rejected[r], rejection_names[r]);
+	}
+	printf("\n");
+
+	if (kept > 0)
+	{
+		const double mean = sum / kept;
+		const double variance = sum_squares / kept - mean * mean;
+		printf("[%s] Filtered average: %lf %s, standard deviation: %lf\n", name, mean, unit,
+			   variance > 0.0 ? sqrt(variance) : 0.0);
+	}
+
+	free(sorted);
+	free(deviations);
+}
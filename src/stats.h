@@ -0,0 +1,79 @@
+#pragma once
+
+#include "cbos.h"
+
+// Samples between two reads of the interrupt and rusage counters
+#ifndef STATS_WINDOW
+#define STATS_WINDOW 1000
+#endif
+
+// Distance from the median in robust standard deviations (1.4826 MAD) that rejects a sample
+#ifndef STATS_OUTLIER_MADS
+#define STATS_OUTLIER_MADS 5.0
+#endif
+
+// Fraction cut from each end for the trimmed mean
+#ifndef STATS_TRIM
+#define STATS_TRIM 0.1
+#endif
+
+// Bootstrap resamples of the confidence interval of the median
+#ifndef STATS_BOOTSTRAP
+#define STATS_BOOTSTRAP 200
+#endif
+
+/**
+ * Interrupts of the measuring CPU and rusage counters of the measuring
+ * thread, either at one point in time or the change over a sample window
+ */
+typedef struct WindowCounters
+{
+	long long interrupts;  // Sum over all sources of /proc/interrupts
+	long long switches;    // Voluntary and involuntary context switches
+	long long page_faults; // Minor and major page faults
+	int cpu;               // CPU the window started on
+} WindowCounters;
+
+/**
+ * @brief Reads the counters of the calling thread and its current CPU.
+ *
+ * @param counters Output for the counters.
+ */
+void window_counters(WindowCounters *counters);
+
+/**
+ * @brief Computes the change of the counters over a window.
+ *
+ * @param start Counters at the start of the window.
+ * @param end Counters at its end.
+ * @return The change, with the CPU of the start.
+ */
+WindowCounters window_delta(const WindowCounters *start, const WindowCounters *end);
+
+/**
+ * @brief Returns the median of unsorted samples, the lower of the two middle
+ * ones for an even count.
+ *
+ * @param samples The samples, which are reordered.
+ * @param count Number of samples, at least one.
+ * @return The median.
+ */
+double sample_median(double *samples, size_t count);
+
+/**
+ * @brief Prints robust statistics of the samples of one benchmark: median,
+ * MAD, trimmed mean and a bootstrap confidence interval of the median of all
+ * samples, then the samples rejected as outliers by their distance from the
+ * median with the reason attributed to them, and the mean and standard
+ * deviation of the remaining ones. An outlier is attributed to a context
+ * switch, a page fault or an interrupt that was counted in its window, each
+ * event explaining one outlier, and to no cause otherwise.
+ *
+ * @param name Name of the library.
+ * @param samples Samples in measurement order, e.g. bytes per cycle.
+ * @param count Number of samples.
+ * @param windows Counter deltas of every STATS_WINDOW samples.
+ * @param unit Unit of the samples for the output.
+ */
+void print_robust_stats(const char *name, const double *samples, size_t count, const WindowCounters *windows,
+						const char *unit);
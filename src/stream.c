@@ -0,0 +1,139 @@
+#include "stream.h"
+#include "utils.h"
+
+// Update sizes, the last one is the reference; 17, 100, 1000 and 1500 are no block multiples
+static const size_t stream_update_sizes[] = {16, 17, 64, 100, 256, 1000, 1024, 1500, 4096, 16384, 65536};
+
+#define STREAM_UPDATE_SIZES (sizeof(stream_update_sizes) / sizeof(stream_update_sizes[0]))
+
+/**
+ * Encrypts STREAM_REPETITIONS messages in updates of one size.
+ *
+ * @param crypto_library Pointer to the cryptographic library.
+ * @param param The context with the cipher already set.
+ * @param update_size Bytes per update call.
+ * @param dst Output buffer of STREAM_TOTAL + 2 * MAX_DIGEST_SIZE bytes.
+ * @param src Input message of STREAM_TOTAL bytes.
+ * @param elapsed Output for the time of all messages.
+ * @return True on success, otherwise false.
+ */
+static bool stream_messages(const Crypto *crypto_library, void *param, const size_t update_size, uint8_t *dst,
+							const uint8_t *src, double *elapsed)
+{
+	const double start = seconds();
+
+	for (size_t r = 0; r < STREAM_REPETITIONS; ++r)
+	{
+		size_t total = 0, written = 0;
+
+		if (!crypto_library->stream_start(param))
+		{
+			return false;
+		}
+
+		for (size_t offset = 0; offset < STREAM_TOTAL; offset += update_size)
+		{
+			const size_t size = STREAM_TOTAL - offset < update_size ? STREAM_TOTAL - offset : update_size;
+			if (!crypto_library->stream_update(param, size, dst + total, src + offset, &written))
+			{
+				return false;
+			}
+			total += written;
+		}
+
+		if (!crypto_library->stream_finish(param, dst + total, &written))
+		{
+			return false;
+		}
+		total += written;
+
+		// Buffered input must have been written by now
+		if (total < STREAM_TOTAL)
+		{
+			printf("Error: only %zu of %lu bytes were written!\n", total, STREAM_TOTAL);
+			return false;
+		}
+	}
+
+	*elapsed = seconds() - start;
+	return true;
+}
+
+/**
+ * Benchmarks streamed encryption of every cipher of a library.
+ *
+ * @param crypto_library Pointer to the cryptographic library.
+ * @return True if the benchmark succeeds; otherwise, false.
+ */
+bool benchmark_stream(const Crypto *crypto_library)
+{
+	const char *name = crypto_library->name();
+	void *param = NULL;
+	bool ok = true;
+
+	if (!crypto_library->stream_start)
+	{
+		return true;
+	}
+
+	uint8_t *src = malloc(STREAM_TOTAL);
+	uint8_t *dst = malloc(STREAM_TOTAL + 2 * MAX_DIGEST_SIZE);
+
+	if (!src || !dst || !crypto_library->init(&param) || !crypto_library->random(param, STREAM_TOTAL, src))
+	{
+		printf("Error: [%s] stream benchmark initialization failed!\n", name);
+		free(src);
+		free(dst);
+		return false;
+	}
+
+	const char **ciphers = crypto_library->ciphers();
+	for (size_t i = 0; ciphers[i] != NULL; ++i)
+	{
+		const char *cipher = ciphers[i];
+		double elapsed[STREAM_UPDATE_SIZES];
+
+		if (!crypto_library->set_cipher(param, cipher))
+		{
+			printf("Error: [%s] failed to set %s, skipping it...\n", name, cipher);
+			ok = false;
+			continue;
+		}
+
+		if (!crypto_library->stream_start(param))
+		{
+			printf("[%s] %s cannot be streamed, skipped\n", name, cipher);
+			continue;
+		}
+
+		printf("[%s] running %s stream benchmark, %lu bytes per message...\n", name, cipher, STREAM_TOTAL);
+
+		bool cipher_ok = true;
+		for (size_t s = 0; s < STREAM_UPDATE_SIZES && cipher_ok; ++s)
+		{
+			cipher_ok = stream_messages(crypto_library, param, stream_update_sizes[s], dst, src, &elapsed[s]);
+		}
+
+		if (!cipher_ok)
+		{
+			printf("Error: [%s] %s stream failed!\n", name, cipher);
+			ok = false;
+			continue;
+		}
+
+		const double reference = elapsed[STREAM_UPDATE_SIZES - 1];
+		for (size_t s = 0; s < STREAM_UPDATE_SIZES; ++s)
+		{
+			const size_t updates = STREAM_REPETITIONS * ((STREAM_TOTAL + stream_update_sizes[s] - 1) / stream_update_sizes[s]);
+			printf("[%s] %s %6zu-byte updates: %9.2f MB/s (%6.2f%% of %zu-byte updates), %8.1f ns/update\n", name,
+				   cipher, stream_update_sizes[s], STREAM_REPETITIONS * STREAM_TOTAL / elapsed[s] / 1e6,
+				   100.0 * reference / elapsed[s], stream_update_sizes[STREAM_UPDATE_SIZES - 1],
+				   1e9 * elapsed[s] / updates);
+		}
+	}
+
+	crypto_library->free(param);
+	free(src);
+	free(dst);
+	return ok;
+}
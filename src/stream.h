@@ -0,0 +1,25 @@
+#pragma once
+
+#include "cbos.h"
+
+// Bytes of every streamed message
+#ifndef STREAM_TOTAL
+#define STREAM_TOTAL (1UL << 20)
+#endif
+
+// Messages per cipher and update size
+#ifndef STREAM_REPETITIONS
+#define STREAM_REPETITIONS 10
+#endif
+
+/**
+ * @brief Benchmarks every cipher of a library that can be streamed by
+ * encrypting STREAM_TOTAL bytes as one message in updates of 16 bytes to
+ * 64 KiB, including sizes that are no multiple of the block size. Reports the
+ * throughput per update size relative to 64 KiB updates and the time per
+ * update call.
+ *
+ * @param crypto_library Pointer to the cryptographic library.
+ * @return True if the benchmark succeeds; otherwise, false.
+ */
+bool benchmark_stream(const Crypto *crypto_library);
@@ -0,0 +1,367 @@
+#include <errno.h>
+
+#include "timeseries.h"
+#include "utils.h"
+
+// Encrypt calls between two checks of the clock
+#define TIMESERIES_BATCH 16
+
+// Highest thermal zone searched for the package temperature
+#define THERMAL_ZONES 64
+
+/**
+ * One interval of the sustained load of a cipher
+ */
+typedef struct Sample
+{
+	const char *lib_name;
+	const char *cipher;
+	size_t interval;
+	double bytes_per_second;
+	double mhz;		   // Current frequency of the CPU, NAN if unknown
+	double celsius;	   // Package temperature, NAN if unknown
+	long long time_ms; // End of the interval in milliseconds since the epoch
+} Sample;
+
+/**
+ * Growable list of samples
+ */
+typedef struct Series
+{
+	Sample *items;
+	size_t count;
+	size_t capacity;
+} Series;
+
+/**
+ * Reads the first number of a sysfs file.
+ *
+ * @param path The file.
+ * @return The number, NAN if the file cannot be read.
+ */
+static double read_number(const char *path)
+{
+	double value = NAN;
+
+	FILE *file = fopen(path, "r");
+	if (file)
+	{
+		if (fscanf(file, "%lf", &value) != 1)
+			value = NAN;
+		fclose(file);
+	}
+
+	return value;
+}
+
+/**
+ * Finds the thermal zone of the package temperature.
+ *
+ * @param path Output for the path of its temp file.
+ * @param size Size of path.
+ * @return True if an x86_pkg_temp zone exists, otherwise false.
+ */
+static bool find_package_zone(char *path, size_t size)
+{
+	for (int zone = 0; zone < THERMAL_ZONES; ++zone)
+	{
+		char type[64] = "";
+		snprintf(path, size, "/sys/class/thermal/thermal_zone%d/type", zone);
+
+		FILE *file = fopen(path, "r");
+		if (!file)
+			continue;
+
+		const bool found = fgets(type, sizeof(type), file) && strncmp(type, "x86_pkg_temp", 12) == 0;
+		fclose(file);
+
+		if (found)
+		{
+			snprintf(path, size, "/sys/class/thermal/thermal_zone%d/temp", zone);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * @return Milliseconds since the epoch.
+ */
+static long long epoch_ms(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * Appends a sample to the series.
+ *
+ * @return True on success, false if the list could not grow.
+ */
+static bool series_add(Series *series, const Sample *sample)
+{
+	if (series->count == series->capacity)
+	{
+		size_t capacity = series->capacity ? 2 * series->capacity : 64;
+		Sample *items = realloc(series->items, capacity * sizeof(Sample));
+		if (!items)
+		{
+			return false;
+		}
+		series->items = items;
+		series->capacity = capacity;
+	}
+
+	series->items[series->count++] = *sample;
+	return true;
+}
+
+/**
+ * Reports whether the throughput of a cipher dropped and stayed below the
+ * first interval. The onset is the first interval from which on every
+ * interval is more than TIMESERIES_DROP below the first one.
+ *
+ * @param samples The intervals of one cipher.
+ * @param count Number of intervals.
+ */
+static void report_drop(const Sample *samples, size_t count)
+{
+	const Sample *first = &samples[0];
+	const double threshold = first->bytes_per_second * (1.0 - TIMESERIES_DROP);
+	size_t onset = count;
+
+	while (onset > 1 && samples[onset - 1].bytes_per_second < threshold)
+	{
+		--onset;
+	}
+
+	// The last quarter is the steady state
+	double steady = 0.0;
+	const size_t tail = count - count * 3 / 4;
+	for (size_t i = count - tail; i < count; ++i)
+	{
+		steady += samples[i].bytes_per_second;
+	}
+	steady /= tail;
+
+	printf("[%s] %s: first interval %.1f MB/s, steady state %.1f MB/s (%.1f%%)", first->lib_name, first->cipher,
+		   first->bytes_per_second / 1e6, steady / 1e6, 100.0 * steady / first->bytes_per_second);
+
+	if (onset < count && steady < threshold)
+	{
+		printf(", dropped after %.0f s", onset * TIMESERIES_INTERVAL);
+		if (!isnan(samples[onset].mhz) && !isnan(first->mhz))
+			printf(" with the frequency at %.0f of %.0f MHz", samples[onset].mhz, first->mhz);
+		if (!isnan(samples[onset].celsius))
+			printf(" and the package at %.1f C", samples[onset].celsius);
+	}
+	else
+	{
+		printf(", no drop");
+	}
+	printf("\n");
+}
+
+/**
+ * Runs the sustained load of one cipher and samples every interval.
+ *
+ * @param crypto_library Pointer to the cryptographic library.
+ * @param param The context with the cipher already set.
+ * @param cipher Name of the cipher.
+ * @param message_size Size of every message.
+ * @param dst Output buffer.
+ * @param src Input message.
+ * @param freq_path Path of scaling_cur_freq of the CPU.
+ * @param temp_path Path of the package temperature, NULL if there is none.
+ * @param series The series the samples are appended to.
+ * @return True on success, otherwise false.
+ */
+static bool sample_cipher(const Crypto *crypto_library, void *param, const char *cipher, const size_t message_size,
+						  uint8_t *dst, const uint8_t *src, const char *freq_path, const char *temp_path,
+						  Series *series)
+{
+	const char *name = crypto_library->name();
+	const size_t intervals = (size_t)(TIMESERIES_SECONDS / TIMESERIES_INTERVAL);
+	const size_t first = series->count;
+	double start = seconds();
+
+	for (size_t interval = 0; interval < intervals; ++interval)
+	{
+		const double deadline = start + TIMESERIES_INTERVAL;
+		size_t calls = 0;
+		double now = start;
+
+		while (now < deadline)
+		{
+			for (int i = 0; i < TIMESERIES_BATCH; ++i)
+			{
+				if (!crypto_library->encrypt(param, message_size, dst, src))
+				{
+					printf("Error: [%s] %s failed!\n", name, cipher);
+					return false;
+				}
+			}
+			calls += TIMESERIES_BATCH;
+			now = seconds();
+		}
+
+		const double khz = read_number(freq_path);
+		const double millicelsius = temp_path ? read_number(temp_path) : NAN;
+		Sample sample = {name, cipher, interval, calls * message_size / (now - start), khz / 1e3, millicelsius / 1e3,
+						 epoch_ms()};
+
+		if (!series_add(series, &sample))
+		{
+			printf("Error: [%s] failed to store the samples of %s!\n", name, cipher);
+			return false;
+		}
+
+		start = now;
+	}
+
+	report_drop(series->items + first, series->count - first);
+	return true;
+}
+
+/**
+ * Writes the samples as CSV.
+ */
+static void write_csv(FILE *file, const Series *series)
+{
+	fprintf(file, "library,cipher,interval,seconds,mb_per_s,mhz,celsius\n");
+
+	for (size_t i = 0; i < series->count; ++i)
+	{
+		const Sample *sample = &series->items[i];
+		fprintf(file, "\"%s\",%s,%zu,%.3f,%.3f,", sample->lib_name, sample->cipher, sample->interval,
+				(sample->interval + 1) * TIMESERIES_INTERVAL, sample->bytes_per_second / 1e6);
+		if (!isnan(sample->mhz))
+			fprintf(file, "%.0f", sample->mhz);
+		fprintf(file, ",");
+		if (!isnan(sample->celsius))
+			fprintf(file, "%.1f", sample->celsius);
+		fprintf(file, "\n");
+	}
+}
+
+/**
+ * Writes the samples in the Prometheus text exposition format, every metric
+ * family with all of its samples in one group.
+ */
+static void write_prometheus(FILE *file, const Series *series)
+{
+	static const char *metrics[] = {"cbos_throughput_bytes_per_second", "cbos_cpu_frequency_mhz",
+									"cbos_package_temperature_celsius"};
+	static const char *help[] = {"Encryption throughput of the interval", "Current frequency of the measured CPU",
+								 "Package temperature of the x86_pkg_temp thermal zone"};
+
+	for (int m = 0; m < 3; ++m)
+	{
+		fprintf(file, "# HELP %s %s\n# TYPE %s gauge\n", metrics[m], help[m], metrics[m]);
+
+		for (size_t i = 0; i < series->count; ++i)
+		{
+			const Sample *sample = &series->items[i];
+			const double value = m == 0 ? sample->bytes_per_second : m == 1 ? sample->mhz : sample->celsius;
+			if (isnan(value))
+				continue;
+
+			fprintf(file, "%s{library=\"%s\",cipher=\"%s\",interval=\"%zu\"} %.6g %lld\n", metrics[m],
+					sample->lib_name, sample->cipher, sample->interval, value, sample->time_ms);
+		}
+	}
+}
+
+/**
+ * Samples the sustained load of every cipher of all libraries and writes the
+ * time series.
+ *
+ * @param libs NULL-terminated list of the libraries.
+ * @param message_size Size of every message.
+ * @param format Format of the file.
+ * @param path Path of the file.
+ * @return True if the benchmark succeeds; otherwise, false.
+ */
+bool benchmark_timeseries(const Crypto **libs, const size_t message_size, SeriesFormat format, const char *path)
+{
+	const int cpu = 0;
+	char freq_path[128];
+	char temp_path[128];
+	Series series = {0};
+	bool ok = true;
+
+	pin_thread(cpu);
+
+	snprintf(freq_path, sizeof(freq_path), "/sys/devices/system/cpu/cpu%d/cpufreq/scaling_cur_freq", cpu);
+	if (isnan(read_number(freq_path)))
+	{
+		printf("cpufreq is not available, the frequency is not sampled\n");
+	}
+
+	const bool has_temp = find_package_zone(temp_path, sizeof(temp_path));
+	if (!has_temp)
+	{
+		printf("No x86_pkg_temp thermal zone, the temperature is not sampled\n");
+	}
+
+	uint8_t *src = malloc(message_size);
+	uint8_t *dst = malloc(message_size + MAX_DIGEST_SIZE);
+
+	for (size_t l = 0; ok && libs[l] != NULL; ++l)
+	{
+		const Crypto *crypto_library = libs[l];
+		const char *name = crypto_library->name();
+		void *param = NULL;
+
+		if (!src || !dst || !crypto_library->init(&param) || !crypto_library->random(param, message_size, src))
+		{
+			printf("Error: [%s] time series initialization failed!\n", name);
+			ok = false;
+			break;
+		}
+
+		const char **ciphers = crypto_library->ciphers();
+		for (size_t i = 0; ciphers[i] != NULL; ++i)
+		{
+			if (!crypto_library->set_cipher(param, ciphers[i]))
+			{
+				printf("Error: [%s] failed to set %s, skipping it...\n", name, ciphers[i]);
+				ok = false;
+				continue;
+			}
+
+			printf("[%s] running %s for %d s...\n", name, ciphers[i], TIMESERIES_SECONDS);
+			fflush(stdout);
+
+			ok = sample_cipher(crypto_library, param, ciphers[i], message_size, dst, src, freq_path,
+							   has_temp ? temp_path : NULL, &series) &&
+				 ok;
+		}
+
+		crypto_library->free(param);
+	}
+
+	FILE *file = fopen(path, "w");
+	if (file)
+	{
+		if (format == SERIES_PROMETHEUS)
+			write_prometheus(file, &series);
+		else
+			write_csv(file, &series);
+		fclose(file);
+		printf("%zu samples written to %s\n", series.count, path);
+	}
+	else
+	{
+		printf("Error: cannot write %s: %s\n", path, strerror(errno));
+		ok = false;
+	}
+
+	free(series.items);
+	free(src);
+	free(dst);
+
+	return ok;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "cbos.h"
+
+// Duration of the sustained load per cipher
+#ifndef TIMESERIES_SECONDS
+#define TIMESERIES_SECONDS 60
+#endif
+
+// Length of one sample
+#ifndef TIMESERIES_INTERVAL
+#define TIMESERIES_INTERVAL 1.0
+#endif
+
+// Relative throughput loss against the first interval that counts as a drop
+#ifndef TIMESERIES_DROP
+#define TIMESERIES_DROP 0.05
+#endif
+
+/**
+ * Output formats of the time series
+ */
+typedef enum SeriesFormat
+{
+	SERIES_CSV,		   // One row per interval
+	SERIES_PROMETHEUS  // Prometheus text exposition format with timestamps
+} SeriesFormat;
+
+/**
+ * @brief Encrypts with every cipher of every library for TIMESERIES_SECONDS on
+ * one pinned thread and samples the throughput, the current frequency of the
+ * CPU (cpufreq scaling_cur_freq) and the package temperature (x86_pkg_temp
+ * thermal zone) every TIMESERIES_INTERVAL seconds. The samples are written to
+ * a file, and a steady-state drop of the throughput below the first interval,
+ * e.g. from thermal throttling, is reported.
+ *
+ * @param libs NULL-terminated list of the libraries.
+ * @param message_size Size of every message.
+ * @param format Format of the file.
+ * @param path Path of the file.
+ * @return True if the benchmark succeeds; otherwise, false.
+ */
+bool benchmark_timeseries(const Crypto **libs, const size_t message_size, SeriesFormat format, const char *path);
@@ -1,5 +1,69 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <sched.h>
+#include <sys/random.h>
+
 #include "utils.h"
 
+#define MAX_LIBS 16
+
+// Defaults of backends that do not define get_message_size() and get_iterations()
+#ifndef MESSAGE_SIZE
+#define MESSAGE_SIZE 4096
+#endif
+
+#ifndef ITERATIONS
+#define ITERATIONS 100
+#endif
+
+static const Crypto *registered_libs[MAX_LIBS + 1];
+static size_t registered_libs_count = 0;
+
+/**
+ * Add a library to the NULL-terminated list of libraries to benchmark.
+ *
+ * @param crypto_library Pointer to the Crypto struct of the library.
+ */
+void register_lib(const Crypto *crypto_library)
+{
+  if (registered_libs_count >= MAX_LIBS)
+  {
+    fprintf(stderr, "Error: more than %d libraries registered, ignoring %s\n", MAX_LIBS, crypto_library->name());
+    return;
+  }
+  registered_libs[registered_libs_count++] = crypto_library;
+}
+
+/**
+ * @return NULL-terminated list of the registered libraries.
+ */
+const Crypto **get_libs()
+{
+  return registered_libs;
+}
+
+/**
+ * Message size of executables whose backends do not define their own. Weak,
+ * so a backend defining get_message_size() overrides it.
+ *
+ * @return MESSAGE_SIZE of the compiler flags.
+ */
+__attribute__((weak)) int get_message_size()
+{
+  return MESSAGE_SIZE;
+}
+
+/**
+ * Iterations of executables whose backends do not define their own. Weak, so
+ * a backend defining get_iterations() overrides it.
+ *
+ * @return ITERATIONS of the compiler flags.
+ */
+__attribute__((weak)) int get_iterations()
+{
+  return ITERATIONS;
+}
+
 // detect ARM64 platforms
 #ifdef __aarch64__
 /**
@@ -46,45 +110,29 @@ unsigned int timestamp(void)
 #endif
 
 /**
- * Generate and store random bytes in the provided buffer.
+ * Generate and store random bytes in the provided buffer with getrandom(),
+ * which neither needs a file descriptor nor blocks once the kernel's pool is
+ * initialized.
  *
  * @param data Pointer to the buffer for storing random bytes.
  * @param size Number of random bytes to generate and store.
  */
 void random_bytes(uint8_t *data, size_t size)
 {
-  ssize_t i;
-  static int fd = -1;
-
-  ssize_t xlen = (ssize_t)size;
-  assert(xlen >= 0);
-  if (fd == -1)
+  while (size > 0)
   {
-    for (;;)
+    ssize_t i = getrandom(data, size, 0);
+    if (i < 0)
     {
-      fd = open("/dev/urandom", O_RDONLY);
-      if (fd != -1)
-        break;
-      sleep(1);
-    }
-  }
-
-  while (xlen > 0)
-  {
-    if (xlen < 1048576)
-      i = xlen;
-    else
-      i = 1048576;
+      if (errno == EINTR)
+        continue;
 
-    i = read(fd, data, (size_t)i);
-    if (i < 1)
-    {
-      sleep(1);
-      continue;
+      printf("random_bytes(): getrandom() failed: %s\n", strerror(errno));
+      abort();
     }
 
     data += i;
-    xlen -= i;
+    size -= (size_t)i;
   }
 }
 
@@ -138,3 +186,257 @@ double seconds(void)
 
   return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
 }
+
+/**
+ * Wait until a point in time of seconds(). The thread sleeps for most of the
+ * time and spins for the last 50 microseconds, which nanosleep() would
+ * overshoot.
+ *
+ * @param deadline The point in time in seconds.
+ */
+void wait_until(double deadline)
+{
+  double remaining = deadline - seconds();
+
+  while (remaining > 0.0)
+  {
+    if (remaining > 50e-6)
+    {
+      const double sleep = remaining - 50e-6;
+      struct timespec ts = {(time_t)sleep, (long)((sleep - (time_t)sleep) * 1e9)};
+      nanosleep(&ts, NULL);
+    }
+    remaining = deadline - seconds();
+  }
+}
+
+/**
+ * Append a copy of a result to a growable result list.
+ *
+ * @param results Pointer to the result list.
+ * @param result Pointer to the result to copy.
+ * @return true on success, false if the list could not grow.
+ */
+bool results_add(Results *results, const Result *result)
+{
+  if (results->count == results->capacity)
+  {
+    size_t capacity = results->capacity ? 2 * results->capacity : 16;
+    Result *items = realloc(results->items, capacity * sizeof(Result));
+    if (!items)
+    {
+      return false;
+    }
+    results->items = items;
+    results->capacity = capacity;
+  }
+
+  results->items[results->count++] = *result;
+  return true;
+}
+
+/**
+ * Release the memory of a result list and reset it to empty.
+ *
+ * @param results Pointer to the result list.
+ */
+void results_free(Results *results)
+{
+  free(results->items);
+  results->items = NULL;
+  results->count = 0;
+  results->capacity = 0;
+}
+
+static int compare_samples(const void *a, const void *b)
+{
+  const double x = *(const double *)a;
+  const double y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+/**
+ * Sort samples in ascending order.
+ *
+ * @param samples The samples to sort.
+ * @param count Number of samples.
+ */
+void sort_samples(double *samples, size_t count)
+{
+  qsort(samples, count, sizeof(double), compare_samples);
+}
+
+/**
+ * Nearest-rank percentile of sorted samples.
+ *
+ * @param sorted Samples sorted in ascending order.
+ * @param count Number of samples.
+ * @param p The percentile between 0 and 100.
+ * @return The sample at the percentile, 0 if there are no samples.
+ */
+double percentile(const double *sorted, size_t count, double p)
+{
+  if (count == 0)
+  {
+    return 0.0;
+  }
+
+  size_t rank = (size_t)ceil(p / 100.0 * (double)count);
+  if (rank > 0)
+  {
+    --rank;
+  }
+  if (rank >= count)
+  {
+    rank = count - 1;
+  }
+
+  return sorted[rank];
+}
+
+/**
+ * @return number of online CPUs, at least 1.
+ */
+int cpu_count(void)
+{
+  long count = sysconf(_SC_NPROCESSORS_ONLN);
+  return count > 0 ? (int)count : 1;
+}
+
+/**
+ * Pin the calling thread to a single CPU.
+ *
+ * @param cpu The CPU index.
+ * @return true on success, false otherwise.
+ */
+bool pin_thread(int cpu)
+{
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+/**
+ * Next thread count of a scaling run: doubled, and the number of CPUs as the
+ * last step if doubling would skip it.
+ *
+ * @param threads The current thread count.
+ * @param cpus Number of CPUs.
+ * @return The next thread count, larger than cpus after the last step.
+ */
+int next_thread_count(int threads, int cpus)
+{
+  return threads < cpus && 2 * threads > cpus ? cpus : 2 * threads;
+}
+
+/**
+ * Extend a time span by the interval of one thread or process.
+ *
+ * @param span The span, zero-initialized when empty.
+ * @param start Start of the interval.
+ * @param end End of the interval.
+ */
+void time_span_add(TimeSpan *span, double start, double end)
+{
+  if (span->count == 0 || start < span->start)
+    span->start = start;
+  if (span->count == 0 || end > span->end)
+    span->end = end;
+  ++span->count;
+}
+
+/**
+ * State of one thread of run_pinned_threads()
+ */
+typedef struct PinnedThread
+{
+  const PinnedWork *work;
+  void *worker;
+  int cpu;
+  pthread_barrier_t *barrier;
+  double start;
+  double end;
+  bool ok;
+} PinnedThread;
+
+/**
+ * Pin the thread, set it up, wait for all threads and time its work.
+ *
+ * @param arg Pointer to a PinnedThread structure.
+ * @return NULL.
+ */
+static void *pinned_thread(void *arg)
+{
+  PinnedThread *thread = arg;
+  const PinnedWork *work = thread->work;
+
+  pin_thread(thread->cpu);
+
+  thread->ok = !work->setup || work->setup(thread->worker);
+
+  pthread_barrier_wait(thread->barrier);
+
+  thread->start = seconds();
+  thread->ok = thread->ok && work->run(thread->worker);
+  thread->end = seconds();
+
+  if (work->cleanup)
+  {
+    work->cleanup(thread->worker);
+  }
+
+  return NULL;
+}
+
+/**
+ * Run one worker per thread, each pinned to its CPU, and time them from the
+ * first start to the last end after all of them are set up.
+ *
+ * @param threads Number of threads.
+ * @param cpus CPU of every thread, NULL for thread t on CPU t % cpu_count().
+ * @param work The steps of every thread.
+ * @param workers Array of `threads` worker states.
+ * @param worker_size Size of one worker state.
+ * @param span Output for the span of the timed steps.
+ * @return True if every thread succeeded, false otherwise.
+ */
+bool run_pinned_threads(int threads, const int *cpus, const PinnedWork *work, void *workers, size_t worker_size,
+                        TimeSpan *span)
+{
+  PinnedThread *states = calloc(threads, sizeof(PinnedThread));
+  pthread_t *ids = calloc(threads, sizeof(pthread_t));
+  pthread_barrier_t barrier;
+  bool ok = states && ids;
+
+  *span = (TimeSpan){0};
+
+  if (!ok)
+  {
+    free(states);
+    free(ids);
+    return false;
+  }
+
+  pthread_barrier_init(&barrier, NULL, threads);
+
+  for (int t = 0; t < threads; ++t)
+  {
+    states[t] = (PinnedThread){work, (char *)workers + t * worker_size, cpus ? cpus[t] : t % cpu_count(), &barrier,
+                               0.0, 0.0, false};
+    pthread_create(&ids[t], NULL, pinned_thread, &states[t]);
+  }
+
+  for (int t = 0; t < threads; ++t)
+  {
+    pthread_join(ids[t], NULL);
+    ok = ok && states[t].ok;
+    time_span_add(span, states[t].start, states[t].end);
+  }
+
+  pthread_barrier_destroy(&barrier);
+
+  free(states);
+  free(ids);
+  return ok;
+}
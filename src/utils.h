@@ -20,6 +20,46 @@ typedef struct Progress
     double start_time;
 } Progress;
 
+/**
+ * Result of benchmarking one cipher, hash or MAC function of a library
+ */
+typedef struct Result
+{
+    const char *lib_name;
+    const char *algorithm;
+    size_t message_size;
+    size_t iterations;
+    double elapsed_time;
+    double bytes_per_cycle;
+    double std_deviation;
+} Result;
+
+/**
+ * Growable list of benchmark results
+ */
+typedef struct Results
+{
+    Result *items;
+    size_t count;
+    size_t capacity;
+} Results;
+
+/**
+ * @brief Appends a result to the list.
+ *
+ * @param results Pointer to the result list.
+ * @param result The result to append.
+ * @return True on success, false if memory allocation failed.
+ */
+bool results_add(Results *results, const Result *result);
+
+/**
+ * @brief Frees the memory held by the result list.
+ *
+ * @param results Pointer to the result list.
+ */
+void results_free(Results *results);
+
 /**
  * @brief Monitors task progress in a separate thread.
  *
@@ -45,4 +85,100 @@ void ccnt_init(void);
  *
  * @return Current time in seconds.
  */
-double seconds(void);
\ No newline at end of file
+double seconds(void);
+
+/**
+ * @brief Waits until a point in time returned by seconds().
+ *
+ * @param deadline The point in time in seconds.
+ */
+void wait_until(double deadline);
+
+/**
+ * @brief Sorts samples in ascending order.
+ *
+ * @param samples The samples to sort.
+ * @param count Number of samples.
+ */
+void sort_samples(double *samples, size_t count);
+
+/**
+ * @brief Returns a percentile of sorted samples.
+ *
+ * @param sorted Samples sorted in ascending order.
+ * @param count Number of samples.
+ * @param p The percentile between 0 and 100.
+ * @return The sample at the percentile, 0 if there are no samples.
+ */
+double percentile(const double *sorted, size_t count, double p);
+
+/**
+ * @brief Returns the number of online CPUs.
+ *
+ * @return Number of online CPUs, at least 1.
+ */
+int cpu_count(void);
+
+/**
+ * @brief Pins the calling thread to a CPU.
+ *
+ * @param cpu The CPU index.
+ * @return True on success, false otherwise.
+ */
+bool pin_thread(int cpu);
+
+/**
+ * @brief Returns the next thread count of a scaling run: 1, 2, 4, ... and
+ * finally the number of CPUs.
+ *
+ * Usage: `for (int threads = 1; threads <= cpus; threads = next_thread_count(threads, cpus))`
+ *
+ * @param threads The current thread count.
+ * @param cpus Number of CPUs.
+ * @return The next thread count, larger than cpus after the last step.
+ */
+int next_thread_count(int threads, int cpus);
+
+/**
+ * Earliest start and latest end of several threads or processes
+ */
+typedef struct TimeSpan
+{
+    double start;
+    double end;
+    size_t count; // Intervals added, 0 for an empty span
+} TimeSpan;
+
+/**
+ * @brief Extends a time span by one interval.
+ *
+ * @param span The span, zero-initialized when empty.
+ * @param start Start of the interval.
+ * @param end End of the interval.
+ */
+void time_span_add(TimeSpan *span, double start, double end);
+
+/**
+ * Steps of every thread of run_pinned_threads(), called with its worker state
+ */
+typedef struct PinnedWork
+{
+    bool (*setup)(void *worker);   // Optional, untimed, before all threads start together
+    bool (*run)(void *worker);     // The timed work
+    void (*cleanup)(void *worker); // Optional, after the timed work, also if a step failed
+} PinnedWork;
+
+/**
+ * @brief Runs one worker per thread, each pinned to its CPU. All threads are
+ * set up first and then start the timed work together at a barrier.
+ *
+ * @param threads Number of threads.
+ * @param cpus CPU of every thread, NULL for thread t on CPU t % cpu_count().
+ * @param work The steps of every thread.
+ * @param workers Array of `threads` worker states.
+ * @param worker_size Size of one worker state.
+ * @param span Output for the first start and the last end of the timed work.
+ * @return True if every thread succeeded, false otherwise.
+ */
+bool run_pinned_threads(int threads, const int *cpus, const PinnedWork *work, void *workers, size_t worker_size,
+                        TimeSpan *span);
@@ -0,0 +1,602 @@
+#include "verify.h"
+
+/**
+ * A known-answer test of a cipher, all values in hex
+ */
+typedef struct KnownAnswer
+{
+	const char *cipher; // Normalized name
+	const char *source;
+	const char *key;
+	const char *iv;
+	const char *plaintext;
+	const char *ciphertext; // Without the tag of AEAD ciphers
+} KnownAnswer;
+
+static const KnownAnswer known_answers[] = {
+	{"AES-128-ECB", "FIPS-197 C.1", "000102030405060708090a0b0c0d0e0f", "", "00112233445566778899aabbccddeeff",
+	 "69c4e0d86a7b0430d8cdb78070b4c55a"},
+	{"AES-192-ECB", "FIPS-197 C.2", "000102030405060708090a0b0c0d0e0f1011121314151617", "",
+	 "00112233445566778899aabbccddeeff", "dda97ca4864cdfe06eaf70a0ec0d7191"},
+	{"AES-256-ECB", "FIPS-197 C.3", "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f", "",
+	 "00112233445566778899aabbccddeeff", "8ea2b7ca516745bfeafc49904b496089"},
+	{"AES-128-ECB", "SP 800-38A F.1.1", "2b7e151628aed2a6abf7158809cf4f3c", "", "6bc1bee22e409f96e93d7e117393172a",
+	 "3ad77bb40d7a3660a89ecaf32466ef97"},
+	{"AES-192-ECB", "SP 800-38A F.1.3", "8e73b0f7da0e6452c810f32b809079e562f8ead2522c6b7b", "",
+	 "6bc1bee22e409f96e93d7e117393172a", "bd334f1d6e45f25ff712a214571fa5cc"},
+	{"AES-256-ECB", "SP 800-38A F.1.5", "603deb1015ca71be2b73aef0857d77811f352c073b6108d72d9810a30914dff4", "",
+	 "6bc1bee22e409f96e93d7e117393172a", "f3eed1bdb5d2a03c064b5a7e3db181f8"},
+	{"AES-128-CBC", "SP 800-38A F.2.1", "2b7e151628aed2a6abf7158809cf4f3c", "000102030405060708090a0b0c0d0e0f",
+	 "6bc1bee22e409f96e93d7e117393172a", "7649abac8119b246cee98e9b12e9197d"},
+	{"AES-192-CBC", "SP 800-38A F.2.3", "8e73b0f7da0e6452c810f32b809079e562f8ead2522c6b7b",
+	 "000102030405060708090a0b0c0d0e0f", "6bc1bee22e409f96e93d7e117393172a", "4f021db243bc633d7178183a9fa071e8"},
+	{"AES-256-CBC", "SP 800-38A F.2.5", "603deb1015ca71be2b73aef0857d77811f352c073b6108d72d9810a30914dff4",
+	 "000102030405060708090a0b0c0d0e0f", "6bc1bee22e409f96e93d7e117393172a", "f58c4c04d6e5f1ba779eabfb5f7bfbd6"},
+	{"AES-128-CFB", "SP 800-38A F.3.13", "2b7e151628aed2a6abf7158809cf4f3c", "000102030405060708090a0b0c0d0e0f",
+	 "6bc1bee22e409f96e93d7e117393172a", "3b3fd92eb72dad20333449f8e83cfb4a"},
+	{"AES-192-CFB", "SP 800-38A F.3.15", "8e73b0f7da0e6452c810f32b809079e562f8ead2522c6b7b",
+	 "000102030405060708090a0b0c0d0e0f", "6bc1bee22e409f96e93d7e117393172a", "cdc80d6fddf18cab34c25909c99a4174"},
+	{"AES-256-CFB", "SP 800-38A F.3.17", "603deb1015ca71be2b73aef0857d77811f352c073b6108d72d9810a30914dff4",
+	 "000102030405060708090a0b0c0d0e0f", "6bc1bee22e409f96e93d7e117393172a", "dc7e84bfda79164b7ecd8486985d3860"},
+	{"AES-128-CTR", "SP 800-38A F.5.1", "2b7e151628aed2a6abf7158809cf4f3c", "f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff",
+	 "6bc1bee22e409f96e93d7e117393172a", "874d6191b620e3261bef6864990db6ce"},
+	{"AES-192-CTR", "SP 800-38A F.5.3", "8e73b0f7da0e6452c810f32b809079e562f8ead2522c6b7b",
+	 "f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff", "6bc1bee22e409f96e93d7e117393172a", "1abc932417521ca24f2b0459fe7e6e0b"},
+	{"AES-256-CTR", "SP 800-38A F.5.5", "603deb1015ca71be2b73aef0857d77811f352c073b6108d72d9810a30914dff4",
+	 "f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff", "6bc1bee22e409f96e93d7e117393172a", "601ec313775789a5b7a7f504bbf3d228"},
+	{"AES-128-GCM", "GCM test case 2", "00000000000000000000000000000000", "000000000000000000000000",
+	 "00000000000000000000000000000000", "0388dace60b6a392f328c2b971b2fe78"},
+	{"AES-192-GCM", "GCM test case 8", "000000000000000000000000000000000000000000000000", "000000000000000000000000",
+	 "00000000000000000000000000000000", "98e7247c07f0fe411c267e4384b0f600"},
+	{"AES-256-GCM", "GCM test case 14", "0000000000000000000000000000000000000000000000000000000000000000",
+	 "000000000000000000000000", "00000000000000000000000000000000", "cea7403d4d606b6e074ec5d3baf39d18"},
+	{"AES-128-CCM", "SP 800-38C C.3", "404142434445464748494a4b4c4d4e4f", "101112131415161718191a1b",
+	 "202122232425262728292a2b2c2d2e2f3031323334353637", "e3b201a9f5b71a7a9b1ceaeccd97e70b6176aad9a4428aa5"},
+	{"AES-128-OCB", "RFC 7253 A", "000102030405060708090a0b0c0d0e0f", "bbaa99887766554433221104",
+	 "000102030405060708090a0b0c0d0e0f", "571d535b60b277188be5147170a9a22c"},
+	// Vector 2, vector 1 has two equal keys that OpenSSL 3 rejects
+	{"AES-128-XTS", "IEEE 1619 vector 2", "1111111111111111111111111111111122222222222222222222222222222222",
+	 "33333333330000000000000000000000", "4444444444444444444444444444444444444444444444444444444444444444",
+	 "c454185e6a16936e39334038acef838bfb186fff7480adc4289382ecd6d394f0"},
+	// The IV of ChaCha20 is the little-endian block counter followed by the nonce, like in OpenSSL
+	{"ChaCha20", "RFC 8439 2.4.2", "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f",
+	 "01000000000000000000004a00000000", "4c616469657320616e642047656e746c656d656e206f662074686520636c6173",
+	 "6e2e359a2568f98041ba0728dd0d6981e97e7aec1d4360c20a27afccfd9fae0b"},
+	{"ChaCha20-Poly1305", "RFC 8439 2.8.2", "808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f",
+	 "070000004041424344454647", "4c616469657320616e642047656e746c656d656e206f662074686520636c6173",
+	 "d31a8d34648e60db7b86afbc53ef7ec2a4aded51296e08fea9e2b5a736ee62d6"},
+};
+
+#define KNOWN_ANSWERS (sizeof(known_answers) / sizeof(known_answers[0]))
+
+// Longest key, IV and plaintext of a test vector
+#define VERIFY_MAX_FIELD 64
+
+/**
+ * Ciphertext fingerprint of one cipher of one library
+ */
+typedef struct Fingerprint
+{
+	const char *library;
+	char cipher[VERIFY_NAME_SIZE];
+	size_t message_size;
+	uint64_t value;
+} Fingerprint;
+
+static Fingerprint fingerprints[VERIFY_MAX_FINGERPRINTS];
+static size_t fingerprint_count = 0;
+
+/**
+ * Normalizes the name of a cipher to the OpenSSL spelling, e.g. Botan's
+ * AES-128/CTR to AES-128-CTR and its block cipher AES-128 to AES-128-ECB.
+ *
+ * @param cipher Name of the cipher in its library.
+ * @param name Output for the normalized name.
+ */
+static void normalize_name(const char *cipher, char name[VERIFY_NAME_SIZE])
+{
+	snprintf(name, VERIFY_NAME_SIZE, "%s", cipher);
+
+	for (char *c = name; *c; ++c)
+	{
+		if (*c == '/')
+			*c = '-';
+	}
+
+	if (strncmp(name, "AES-", 4) == 0 && !strchr(name + 4, '-') && strlen(name) + 4 < VERIFY_NAME_SIZE)
+	{
+		strcat(name, "-ECB");
+	}
+}
+
+/**
+ * Derives the key and IV sizes of a normalized cipher name.
+ *
+ * @param name Normalized name of the cipher.
+ * @param key_size Output for the key size.
+ * @param iv_size Output for the IV size, the counter and nonce for ChaCha20.
+ * @return True if the sizes are known, otherwise false.
+ */
+static bool cipher_sizes(const char *name, size_t *key_size, size_t *iv_size)
+{
+	if (strcmp(name, "ChaCha20") == 0 || strcmp(name, "ChaCha20-Poly1305") == 0)
+	{
+		*key_size = 32;
+		*iv_size = strcmp(name, "ChaCha20") == 0 ? 16 : 12;
+		return true;
+	}
+
+	const int bits = strncmp(name, "AES-", 4) == 0 ? atoi(name + 4) : 0;
+	const char *mode = strchr(name + (bits ? 4 : 0), '-');
+
+	if ((bits != 128 && bits != 192 && bits != 256) || !mode)
+	{
+		return false;
+	}
+
+	++mode;
+	*key_size = bits / 8 * (strcmp(mode, "XTS") == 0 ? 2 : 1);
+
+	if (strcmp(mode, "ECB") == 0)
+		*iv_size = 0;
+	else if (strcmp(mode, "GCM") == 0 || strcmp(mode, "CCM") == 0 || strcmp(mode, "OCB") == 0)
+		*iv_size = 12;
+	else if (strcmp(mode, "CBC") == 0 || strcmp(mode, "CTR") == 0 || strcmp(mode, "CFB") == 0 ||
+			 strcmp(mode, "XTS") == 0)
+		*iv_size = 16;
+	else
+		return false;
+
+	return true;
+}
+
+/**
+ * Decodes a hex string.
+ *
+ * @param hex The hex string.
+ * @param out Output buffer of VERIFY_MAX_FIELD bytes.
+ * @return Number of bytes decoded.
+ */
+static size_t hex_decode(const char *hex, uint8_t *out)
+{
+	size_t size = 0;
+
+	for (; hex[0] && hex[1] && size < VERIFY_MAX_FIELD; hex += 2)
+	{
+		unsigned int byte = 0;
+		sscanf(hex, "%2x", &byte);
+		out[size++] = (uint8_t)byte;
+	}
+
+	return size;
+}
+
+/**
+ * Prints bytes in hex.
+ *
+ * @param data The bytes.
+ * @param size Number of bytes.
+ */
+static void print_hex(const uint8_t *data, const size_t size)
+{
+	for (size_t i = 0; i < size; ++i)
+	{
+		printf("%02x", data[i]);
+	}
+}
+
+/**
+ * Hashes bytes with 64-bit FNV-1a.
+ *
+ * @param data The bytes.
+ * @param size Number of bytes.
+ * @return The hash.
+ */
+static uint64_t fnv1a(const uint8_t *data, const size_t size)
+{
+	uint64_t hash = 0xcbf29ce484222325ULL;
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash = (hash ^ data[i]) * 0x100000001b3ULL;
+	}
+
+	return hash;
+}
+
+/**
+ * Compares a fingerprint with those of the other libraries and of earlier
+ * runs of the same library, and stores it if the library has none yet.
+ *
+ * @param library Name of the library.
+ * @param verification The verification with the fingerprint.
+ * @param message_size Size of the message.
+ * @return False if another fingerprint of the cipher and size differs.
+ */
+static bool compare_fingerprint(const char *library, Verification *verification, const size_t message_size)
+{
+	bool ok = true, stored = false;
+
+	for (size_t i = 0; i < fingerprint_count; ++i)
+	{
+		const Fingerprint *other = &fingerprints[i];
+		if (other->message_size != message_size || strcmp(other->cipher, verification->cipher) != 0)
+		{
+			continue;
+		}
+
+		const bool same_library = strcmp(other->library, library) == 0;
+		stored = stored || same_library;
+
+		if (other->value != verification->fingerprint)
+		{
+			printf("Error: [%s] %s: ciphertext %016llx differs from %016llx %s [%s]!\n", library, verification->cipher,
+				   (unsigned long long)verification->fingerprint, (unsigned long long)other->value,
+				   same_library ? "of the earlier verification of" : "of", other->library);
+			ok = false;
+		}
+		else if (!same_library && !verification->same_as)
+		{
+			verification->same_as = other->library;
+		}
+	}
+
+	if (!stored && fingerprint_count < VERIFY_MAX_FINGERPRINTS)
+	{
+		Fingerprint *fingerprint = &fingerprints[fingerprint_count++];
+		fingerprint->library = library;
+		snprintf(fingerprint->cipher, sizeof(fingerprint->cipher), "%s", verification->cipher);
+		fingerprint->message_size = message_size;
+		fingerprint->value = verification->fingerprint;
+	}
+
+	return ok;
+}
+
+/**
+ * Encrypts one message after setting a key and IV and compares a prefix of
+ * the ciphertext.
+ *
+ * @param crypto_library Pointer to the cryptographic library.
+ * @param param The context with the cipher already set.
+ * @param key The key.
+ * @param key_size Size of the key.
+ * @param iv The IV.
+ * @param iv_size Size of the IV.
+ * @param message_size Size of the message.
+ * @param dst Output buffer.
+ * @param src Message.
+ * @return True on success, otherwise false.
+ */
+static bool encrypt_with(const Crypto *crypto_library, void *param, const uint8_t *key, const size_t key_size,
+						 const uint8_t *iv, const size_t iv_size, const size_t message_size, uint8_t *dst,
+						 const uint8_t *src)
+{
+	return crypto_library->set_key(param, key, key_size, iv, iv_size) &&
+		   crypto_library->encrypt(param, message_size, dst, src);
+}
+
+/**
+ * Fills the fixed key, IV and message every library encrypts the same way.
+ *
+ * @param key Output for VERIFY_MAX_FIELD key bytes.
+ * @param iv Output for VERIFY_MAX_FIELD IV bytes.
+ * @param message Output for the message.
+ * @param size Size of the message buffer.
+ */
+static void fixed_message(uint8_t *key, uint8_t *iv, uint8_t *message, const size_t size)
+{
+	for (size_t i = 0; i < VERIFY_MAX_FIELD; ++i)
+	{
+		key[i] = (uint8_t)i;
+		iv[i] = (uint8_t)(0xf0 + i);
+	}
+	for (size_t i = 0; i < size; ++i)
+	{
+		message[i] = (uint8_t)(7 * i + 3);
+	}
+}
+
+bool verify_cipher(const Crypto *crypto_library, const char *cipher, const size_t message_size,
+				   Verification *verification)
+{
+	const char *name = crypto_library->name();
+	size_t key_size = 0, iv_size = 0;
+	bool ok = true;
+
+	*verification = (Verification){0};
+	normalize_name(cipher, verification->cipher);
+
+	if (!crypto_library->set_key || !cipher_sizes(verification->cipher, &key_size, &iv_size))
+	{
+		return true;
+	}
+	verification->verifiable = true;
+
+	// The messages hold every test vector and the tag of AEAD ciphers
+	const size_t capacity = message_size + VERIFY_MAX_FIELD + MAX_DIGEST_SIZE;
+	uint8_t *src = calloc(1, capacity);
+	uint8_t *dst = calloc(1, capacity);
+	void *param = NULL;
+
+	if (!src || !dst || !crypto_library->init(&param) || !crypto_library->set_cipher(param, cipher))
+	{
+		printf("Error: [%s] failed to set %s for its verification!\n", name, cipher);
+		free(src);
+		free(dst);
+		if (param)
+			crypto_library->free(param);
+		return false;
+	}
+
+	for (size_t i = 0; ok && i < KNOWN_ANSWERS; ++i)
+	{
+		const KnownAnswer *answer = &known_answers[i];
+		uint8_t key[VERIFY_MAX_FIELD], iv[VERIFY_MAX_FIELD], expected[VERIFY_MAX_FIELD];
+
+		if (strcmp(answer->cipher, verification->cipher) != 0)
+		{
+			continue;
+		}
+
+		const size_t answer_key_size = hex_decode(answer->key, key);
+		const size_t answer_iv_size = hex_decode(answer->iv, iv);
+		const size_t plaintext_size = hex_decode(answer->plaintext, src);
+		hex_decode(answer->ciphertext, expected);
+
+		// Every mode here encrypts the start of a longer message like the test vector
+		const size_t compared = plaintext_size < message_size ? plaintext_size : message_size;
+		memset(src + plaintext_size, 0, capacity - plaintext_size);
+		memset(dst, 0, capacity);
+
+		if (!encrypt_with(crypto_library, param, key, answer_key_size, iv, answer_iv_size, message_size, dst, src))
+		{
+			printf("Error: [%s] %s failed to encrypt the %s test vector!\n", name, cipher, answer->source);
+			ok = false;
+		}
+		else if (memcmp(dst, expected, compared) != 0)
+		{
+			printf("Error: [%s] %s does not match %s: expected ", name, cipher, answer->source);
+			print_hex(expected, compared);
+			printf(", got ");
+			print_hex(dst, compared);
+			printf("\n");
+			ok = false;
+		}
+		else
+		{
+			++verification->known_answers;
+		}
+	}
+
+	uint8_t key[VERIFY_MAX_FIELD], iv[VERIFY_MAX_FIELD];
+	fixed_message(key, iv, src, capacity);
+
+	if (ok && !encrypt_with(crypto_library, param, key, key_size, iv, iv_size, message_size, dst, src))
+	{
+		printf("Error: [%s] %s failed to encrypt the verification message!\n", name, cipher);
+		ok = false;
+	}
+	else if (ok)
+	{
+		verification->fingerprint = fnv1a(dst, message_size);
+		ok = compare_fingerprint(name, verification, message_size);
+	}
+
+	// The ciphertext has to decrypt to the message again with the same key and IV
+	uint8_t *plain = ok && crypto_library->decrypt ? calloc(1, capacity) : NULL;
+	if (plain)
+	{
+		if (!crypto_library->set_key(param, key, key_size, iv, iv_size) ||
+			crypto_library->decrypt(param, message_size, plain, dst) != message_size ||
+			memcmp(plain, src, message_size) != 0)
+		{
+			printf("Error: [%s] %s does not decrypt its ciphertext to the message!\n", name, cipher);
+			ok = false;
+		}
+		else
+		{
+			verification->round_trip = true;
+		}
+		free(plain);
+	}
+
+	crypto_library->free(param);
+	free(src);
+	free(dst);
+	return ok;
+}
+
+bool verify_context(const Crypto *crypto_library, void *param, const size_t message_size,
+					const Verification *verification)
+{
+	const char *name = crypto_library->name();
+	size_t key_size = 0, iv_size = 0;
+
+	if (!verification->verifiable || !cipher_sizes(verification->cipher, &key_size, &iv_size))
+	{
+		return true;
+	}
+
+	const size_t capacity = message_size + MAX_DIGEST_SIZE;
+	uint8_t *src = malloc(capacity);
+	uint8_t *dst = malloc(capacity);
+	uint8_t key[VERIFY_MAX_FIELD], iv[VERIFY_MAX_FIELD];
+	bool ok = false;
+
+	if (!src || !dst)
+	{
+		printf("Error: [%s] %s: out of memory for the verification of its context!\n", name, verification->cipher);
+	}
+	else
+	{
+		fixed_message(key, iv, src, capacity);
+
+		if (!encrypt_with(crypto_library, param, key, key_size, iv, iv_size, message_size, dst, src))
+		{
+			printf("Error: [%s] %s failed to encrypt the verification message with its context!\n", name,
+				   verification->cipher);
+		}
+		else if (fnv1a(dst, message_size) != verification->fingerprint)
+		{
+			printf("Error: [%s] %s: ciphertext %016llx of its context differs from %016llx of its verification!\n",
+				   name, verification->cipher, (unsigned long long)fnv1a(dst, message_size),
+				   (unsigned long long)verification->fingerprint);
+		}
+		else
+		{
+			ok = true;
+		}
+	}
+
+	free(src);
+	free(dst);
+	return ok;
+}
+
+/**
+ * Checks if a library is linked into this executable.
+ *
+ * @param libs NULL-terminated list of the libraries.
+ * @param library Name of a library.
+ * @return True if the library is in the list.
+ */
+static bool is_own_library(const Crypto **libs, const char *library)
+{
+	for (size_t i = 0; libs[i] != NULL; ++i)
+	{
+		if (strcmp(libs[i]->name(), library) == 0)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool verify_libraries(const Crypto **libs, const size_t message_size, const char *path)
+{
+	bool ok = true;
+
+	for (size_t i = 0; libs[i] != NULL; ++i)
+	{
+		const char *name = libs[i]->name();
+		const char **ciphers = libs[i]->ciphers();
+
+		for (size_t j = 0; ciphers[j] != NULL; ++j)
+		{
+			Verification verification;
+			if (!verify_cipher(libs[i], ciphers[j], message_size, &verification))
+			{
+				ok = false;
+			}
+			else if (!verification.verifiable)
+			{
+				printf("[%s] %s: not verifiable\n", name, ciphers[j]);
+			}
+			else
+			{
+				printf("[%s] %s: %zu known answer(s), ciphertext %016llx%s%s%s%s\n", name, verification.cipher,
+					   verification.known_answers, (unsigned long long)verification.fingerprint,
+					   verification.round_trip ? ", decrypted" : "", verification.same_as ? ", same as [" : "",
+					   verification.same_as ? verification.same_as : "", verification.same_as ? "]" : "");
+			}
+		}
+	}
+
+	// Lines of other libraries are kept and compared, those of the ciphers verified here are replaced
+	char **others = NULL;
+	size_t other_count = 0;
+	FILE *file = fopen(path, "r");
+	char *line = NULL;
+	size_t line_size = 0;
+
+	while (file && getline(&line, &line_size, file) > 0)
+	{
+		char cipher[VERIFY_NAME_SIZE];
+		size_t size = 0;
+		unsigned long long value = 0;
+		int library_start = 0;
+		bool replaced = false;
+
+		line[strcspn(line, "\n")] = '\0';
+		if (sscanf(line, "%63s %zu %llx %n", cipher, &size, &value, &library_start) != 3 || !line[library_start])
+		{
+			continue;
+		}
+
+		const char *library = line + library_start;
+		for (size_t i = 0; i < fingerprint_count; ++i)
+		{
+			const Fingerprint *own = &fingerprints[i];
+			if (own->message_size != size || strcmp(own->cipher, cipher) != 0)
+			{
+				continue;
+			}
+
+			if (strcmp(own->library, library) == 0)
+			{
+				replaced = true;
+			}
+			else if (own->value != value)
+			{
+				printf("Error: [%s] %s: ciphertext %016llx differs from %016llx of [%s] in %s!\n", own->library,
+					   cipher, (unsigned long long)own->value, value, library, path);
+				ok = false;
+			}
+			else if (!is_own_library(libs, library))
+			{
+				printf("[%s] %s: same ciphertext as [%s] in %s\n", own->library, cipher, library, path);
+			}
+		}
+
+		if (replaced)
+		{
+			continue;
+		}
+
+		char **grown = realloc(others, (other_count + 1) * sizeof(char *));
+		if (grown)
+		{
+			others = grown;
+			others[other_count++] = strdup(line);
+		}
+	}
+
+	free(line);
+	if (file)
+	{
+		fclose(file);
+	}
+
+	file = fopen(path, "w");
+	if (!file)
+	{
+		printf("Error: failed to write the fingerprints to %s!\n", path);
+		ok = false;
+	}
+
+	for (size_t i = 0; i < other_count; ++i)
+	{
+		if (file && others[i])
+		{
+			fprintf(file, "%s\n", others[i]);
+		}
+		free(others[i]);
+	}
+	free(others);
+
+	for (size_t i = 0; file && i < fingerprint_count; ++i)
+	{
+		fprintf(file, "%s %zu %016llx %s\n", fingerprints[i].cipher, fingerprints[i].message_size,
+				(unsigned long long)fingerprints[i].value, fingerprints[i].library);
+	}
+
+	if (file)
+	{
+		fclose(file);
+		printf("Fingerprints written to %s\n", path);
+	}
+
+	return ok;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "cbos.h"
+
+// Longest normalized cipher name
+#ifndef VERIFY_NAME_SIZE
+#define VERIFY_NAME_SIZE 64
+#endif
+
+// Fingerprints kept for the comparison between libraries
+#ifndef VERIFY_MAX_FINGERPRINTS
+#define VERIFY_MAX_FINGERPRINTS 1024
+#endif
+
+/**
+ * Outcome of the verification of one cipher
+ */
+typedef struct Verification
+{
+	char cipher[VERIFY_NAME_SIZE]; // Normalized name, e.g. AES-128-CTR for Botan's AES-128/CTR
+	bool verifiable;			   // The library can set the key and IV and their sizes are known
+	size_t known_answers;		   // Test vectors that matched
+	uint64_t fingerprint;		   // FNV-1a hash of the ciphertext of a fixed key, IV and message
+	const char *same_as;		   // Other library with the same ciphertext, NULL if none verified it yet
+	bool round_trip;			   // The ciphertext was decrypted to the message with decrypt
+} Verification;
+
+/**
+ * @brief Verifies a cipher of a library with its own context, outside of any
+ * timed loop. The cipher encrypts the known-answer tests of its normalized
+ * name (FIPS-197, SP 800-38A, SP 800-38C, the GCM specification, RFC 7253
+ * and IEEE 1619) and a message of `message_size` bytes with a fixed key and
+ * IV, whose ciphertext is compared with every library that verified the same
+ * cipher and message size before. Only the ciphertext is compared, the tags
+ * of AEAD ciphers depend on the associated data of every backend. Libraries
+ * with decrypt also have to decrypt that ciphertext to the message again.
+ *
+ * Libraries without set_key and ciphers with unknown key or IV sizes are not
+ * verifiable, which is not an error.
+ *
+ * @param crypto_library Pointer to the cryptographic library.
+ * @param cipher Name of the cipher in the library.
+ * @param message_size Size of the message.
+ * @param verification Output for the outcome.
+ * @return False if a test vector or another library disagrees or the cipher
+ * fails; otherwise, true.
+ */
+bool verify_cipher(const Crypto *crypto_library, const char *cipher, const size_t message_size,
+				   Verification *verification);
+
+/**
+ * @brief Verifies a context that already encrypted with a cipher, e.g. the
+ * one of the timed loops: sets the fixed key and IV of verify_cipher() on it
+ * and compares the ciphertext of the fixed message with the fingerprint of
+ * `verification`. A context whose state drifted while it was benchmarked,
+ * e.g. a message that was never finished, fails even if a new one is fine.
+ * The key and IV of the context are replaced.
+ *
+ * @param crypto_library Pointer to the cryptographic library.
+ * @param param The context with the cipher set.
+ * @param message_size Size of the message, the one of verify_cipher().
+ * @param verification Outcome of verify_cipher() for the cipher.
+ * @return False if the ciphertext differs or the cipher fails; true if it
+ * matches or the cipher is not verifiable.
+ */
+bool verify_context(const Crypto *crypto_library, void *param, const size_t message_size,
+					const Verification *verification);
+
+/**
+ * @brief Verifies every cipher of every library with verify_cipher() and
+ * compares the ciphertexts with those of other executables, e.g. OpenSSL
+ * and Botan, stored in the file at `path`. The fingerprints of the libraries
+ * of this executable replace their earlier lines in the file.
+ *
+ * @param libs NULL-terminated list of the libraries.
+ * @param message_size Size of the message.
+ * @param path File the fingerprints of all executables are merged in.
+ * @return True if every verifiable cipher agrees; otherwise, false.
+ */
+bool verify_libraries(const Crypto **libs, const size_t message_size, const char *path);